@@ -3,6 +3,8 @@ uniform vec2 iResolution;
 uniform vec2 displayHorizontal;
 uniform vec2 displayVertical;
 uniform bool displayEnabled;
+uniform int field;  // Bob deinterlacing - only rows of this field are shown, -1 - disabled
+uniform int displayStartY;  // Field parity is counted from the first displayed row
 
 SHARED vec2 fragTexcoord;
 
@@ -29,6 +31,14 @@ void main() {
         return;
     }
 
-    outColor = vec4(texture(renderBuffer, fragTexcoord).rgb, 1.0);
+    vec2 texcoord = fragTexcoord;
+    if (field >= 0) {
+        float height = float(textureSize(renderBuffer, 0).y);
+        float start = float(displayStartY);
+        float row = start + floor((texcoord.y * height - start) / 2.0) * 2.0 + float(field);
+        texcoord.y = (row + 0.5) / height;
+    }
+
+    outColor = vec4(texture(renderBuffer, texcoord).rgb, 1.0);
 }
 #endif
\ No newline at end of file
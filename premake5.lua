@@ -55,6 +55,11 @@ filter "options:ubsan"
 	buildoptions {"-fsanitize=undefined"}
 	linkoptions {"-fsanitize=undefined"}
 
+newoption {
+	trigger = "headless",
+	description = "Build headless runner without SDL and OpenGL"
+}
+
 newoption {
 	trigger = "time-trace",
 	description = "Build with -ftime-trace (clang only)"
@@ -242,7 +247,13 @@ project "avocado"
 	filter "options:headless"
 		files { 
 			"src/platform/headless/**.cpp",
-			"src/platform/headless/**.h"
+			"src/platform/headless/**.h",
+			"src/platform/null/**.*"
+		}
+
+	filter {"system:linux", "options:headless"}
+		links { 
+			"pthread",
 		}
 
 	filter {"system:windows", "not options:headless"}
@@ -356,3 +367,24 @@ project "avocado_autotest"
 		"core",
 		"fmt"
 	}
+
+project "avocado_bench"
+	uuid "5b0c6f3e-2d7a-4e61-9f0b-8a1c4d2e7b93"
+	kind "ConsoleApp"
+	location "build/libs/avocado_bench"
+	debugdir "."
+
+	includedirs { 
+		"src", 
+	}
+
+	files { 
+		"src/platform/null/**.*",
+		"tests/bench/**.h",
+		"tests/bench/**.cpp"
+	}
+
+	links {
+		"core",
+		"fmt"
+	}
@@ -1,6 +1,8 @@
 #pragma once
 #include <string>
 #include <unordered_map>
+#include <vector>
+#include "cpu/cpu_core.h"
 #include "device/controller/controller_type.h"
 #include "device/gpu/rendering_mode.h"
 #include "utils/event.h"
@@ -64,6 +66,8 @@ struct avocado_config_t {
             bool vsync = false;
             bool forceNtsc = false;
             bool nativeTextureFormat = true;
+            int renderingThreads = 0;  // Software rasterizer threads, 0 - draw on emulation thread
+            Deinterlacing deinterlacing = Deinterlacing::weave;
         } graphics;
 
         struct {
@@ -77,6 +81,15 @@ struct avocado_config_t {
 
         struct {
             bool ram8mb = false;
+            CpuCore cpuCore = CpuCore::interpreter;
+            bool fastmem = false;  // Mirror guest memory in host address space for the recompiler
+
+            struct {
+                bool enabled = true;
+                // Per game overrides, keyed by disc image name without extension
+                std::unordered_map<std::string, bool> games;
+                std::unordered_map<std::string, std::vector<uint32_t>> ignored;  // Loop start addresses never skipped
+            } idleLoops;
         } system;
 
     } options;
@@ -0,0 +1,59 @@
+#include "backend.h"
+#include <algorithm>
+#include "cpu/cpu.h"
+#include "system.h"
+#include "utils/address.h"
+
+namespace mips {
+
+static_assert(Backend::PAGE_SIZE == System::PAGE_SIZE, "Code pages must match memory map pages");
+
+Backend::Backend(CPU* cpu) : cpu(cpu), sys(cpu->sys) { pages.resize(sys->ram.size() / PAGE_SIZE); }
+
+bool Backend::isCompilable(uint32_t pc) const {
+    if (pc & 3) return false;
+    uint32_t addr = align_mips<uint32_t>(pc);
+    return in_range<System::RAM_BASE, System::RAM_SIZE_8MB>(addr) || in_range<System::BIOS_BASE, System::BIOS_SIZE>(addr);
+}
+
+bool Backend::ramOffset(uint32_t pc, uint32_t& offset) const {
+    uint32_t addr = align_mips<uint32_t>(pc);
+    if (!in_range<System::RAM_BASE, System::RAM_SIZE_8MB>(addr)) return false;
+    offset = (addr - System::RAM_BASE) & (sys->ram.size() - 1);
+    return true;
+}
+
+void Backend::registerBlock(uint32_t pc, uint32_t start, uint32_t end) {
+    for (uint32_t page = start / PAGE_SIZE; page <= (end - 1) / PAGE_SIZE && page < pages.size(); page++) {
+        if (pages[page].empty()) sys->setRamPageWritable(page, false);
+        pages[page].push_back({pc, start, end});
+    }
+}
+
+void Backend::unregisterBlock(uint32_t pc, uint32_t start, uint32_t end) {
+    for (uint32_t page = start / PAGE_SIZE; page <= (end - 1) / PAGE_SIZE && page < pages.size(); page++) {
+        auto& list = pages[page];
+        list.erase(std::remove_if(list.begin(), list.end(), [pc](const PageEntry& e) { return e.pc == pc; }), list.end());
+        if (list.empty()) sys->setRamPageWritable(page, true);
+    }
+}
+
+void Backend::clearPages() {
+    for (uint32_t page = 0; page < pages.size(); page++) {
+        if (!pages[page].empty()) sys->setRamPageWritable(page, true);
+    }
+    pages.assign(sys->ram.size() / PAGE_SIZE, {});
+}
+
+void Backend::invalidatePage(uint32_t ramAddress) {
+    auto& page = pages[ramAddress / PAGE_SIZE];
+    for (size_t n = 0; n < page.size();) {
+        if (ramAddress >= page[n].start && ramAddress < page[n].end) {
+            removeBlock(page[n].pc);  // Removes entry from the page list
+        } else {
+            n++;
+        }
+    }
+}
+
+}  // namespace mips
@@ -0,0 +1,66 @@
+#pragma once
+#include <cstdint>
+#include <vector>
+#include "cpu/opcode.h"
+#include "utils/macros.h"
+
+struct System;
+
+namespace mips {
+
+struct CPU;
+
+/**
+ * Base for execution engines caching translated guest code blocks (cached interpreter, recompiler).
+ * Keeps track of which blocks overlap which RAM page, so writes to RAM can discard stale code.
+ */
+class Backend {
+   public:
+    static const uint32_t PAGE_SIZE = 4096;
+
+    Backend(CPU* cpu);
+    virtual ~Backend() = default;
+
+    virtual bool execute(int count) = 0;
+    virtual void flush() = 0;
+
+    // Must be called on every RAM write, address is offset into RAM
+    INLINE void invalidate(uint32_t ramAddress) {
+        auto& page = pages[ramAddress / PAGE_SIZE];
+        if (unlikely(!page.empty())) invalidatePage(ramAddress);
+    }
+
+   protected:
+    CPU* cpu;
+    System* sys;
+
+    // Jumps and branches, these are always followed by a delay slot
+    static bool isBranch(Opcode i) {
+        if (i.op == 0) return i.fun == 8 || i.fun == 9;  // jr, jalr
+        return i.op >= 1 && i.op <= 7;                   // bcondz, j, jal, beq, bne, blez, bgtz
+    }
+
+    // Block code must be located in RAM or BIOS, and be word aligned
+    bool isCompilable(uint32_t pc) const;
+    // Translates PC to offset into RAM, returns false if address is not in RAM
+    bool ramOffset(uint32_t pc, uint32_t& offset) const;
+
+    // Range is in RAM offsets, [start, end)
+    void registerBlock(uint32_t pc, uint32_t start, uint32_t end);
+    void unregisterBlock(uint32_t pc, uint32_t start, uint32_t end);
+    void clearPages();
+
+    virtual void removeBlock(uint32_t pc) = 0;
+
+   private:
+    struct PageEntry {
+        uint32_t pc;
+        uint32_t start;
+        uint32_t end;
+    };
+    std::vector<std::vector<PageEntry>> pages;  // Blocks overlapping each RAM page
+
+    void invalidatePage(uint32_t ramAddress);
+};
+
+}  // namespace mips
@@ -0,0 +1,114 @@
+#include "cached_interpreter.h"
+#include "cpu/cpu.h"
+#include "cpu/instructions.h"
+#include "system.h"
+
+namespace mips {
+
+CachedInterpreter::CachedInterpreter(CPU* cpu) : Backend(cpu) {}
+
+void CachedInterpreter::flush() {
+    blocks.clear();
+    clearPages();
+}
+
+CachedInterpreter::Block* CachedInterpreter::getBlock(uint32_t pc) {
+    auto it = blocks.find(pc);
+    if (it != blocks.end()) return it->second.get();
+    return compile(pc);
+}
+
+CachedInterpreter::Block* CachedInterpreter::compile(uint32_t pc) {
+    if (!isCompilable(pc)) return nullptr;
+
+    auto block = std::make_unique<Block>();
+    block->pc = pc;
+    block->inRam = ramOffset(pc, block->physStart);
+
+    auto decode = [&](uint32_t address) {
+        Opcode i(sys->readMemory32(address));
+
+        // Skip one level of dispatch for SPECIAL opcodes
+        auto handler = i.op == 0 ? instructions::SpecialTable[i.fun].instruction : instructions::OpcodeTable[i.op].instruction;
+        block->instructions.push_back({handler, i});
+        return i;
+    };
+
+    uint32_t address = pc;
+    for (int n = 0; n < MAX_BLOCK_LENGTH; n++, address += 4) {
+        if (isBranch(decode(address))) {
+            decode(address + 4);  // Delay slot
+            break;
+        }
+    }
+
+    block->physEnd = block->physStart + block->instructions.size() * 4;
+    if (block->inRam) registerBlock(pc, block->physStart, block->physEnd);
+
+    return blocks.emplace(pc, std::move(block)).first->second.get();
+}
+
+void CachedInterpreter::removeBlock(uint32_t pc) {
+    auto it = blocks.find(pc);
+    if (it == blocks.end()) return;
+
+    Block* block = it->second.get();
+    if (block->inRam) unregisterBlock(pc, block->physStart, block->physEnd);
+
+    if (block == currentBlock) {
+        retiredBlock = std::move(it->second);
+    }
+    blocks.erase(it);
+}
+
+bool CachedInterpreter::execute(int count) {
+    if (unlikely(cpu->breakpointsEnabled)) {
+        return cpu->interpret(count);
+    }
+
+    while (count > 0 && !sys->scheduler.yield) {
+        // Blocks assume that they are entered outside of branch delay slot
+        Block* block = nullptr;
+        if (cpu->nextPC == cpu->PC + 4) block = getBlock(cpu->PC);
+        if (block == nullptr) {
+            cpu->interpret(1);
+            count--;
+            continue;
+        }
+
+        currentBlock = block;
+        uint32_t address = block->pc;
+        for (const auto& i : block->instructions) {
+#ifdef ENABLE_BIOS_HOOKS
+            uint32_t maskedPc = address & 0x1fff'ffff;
+            if (maskedPc == 0xa0 || maskedPc == 0xb0 || maskedPc == 0xc0) sys->handleBiosFunction();
+#endif
+            cpu->saveStateForException();
+            cpu->checkForInterrupts();
+            if (cpu->PC != address) break;  // Interrupt taken
+
+            cpu->setPC(cpu->nextPC);
+            i.handler(cpu, i.opcode);
+            cpu->moveLoadDelaySlots();
+
+            sys->cycles++;
+            address += 4;
+
+            // Stop on exception, exhausted budget or if block overwrote itself
+            if (--count <= 0 || cpu->PC != address || retiredBlock || sys->scheduler.yield) break;
+        }
+
+        // Block closed by a backward branch might be a loop waiting for devices
+        uint32_t delaySlot = address - 4;
+        if (count > 0 && address == block->pc + block->instructions.size() * 4 && cpu->PC < delaySlot
+            && cpu->idleLoops.isIdle(cpu->PC, delaySlot)) {
+            cpu->idleLoops.skip(count);
+            count = 0;
+        }
+        currentBlock = nullptr;
+        retiredBlock.reset();
+    }
+    return true;
+}
+
+}  // namespace mips
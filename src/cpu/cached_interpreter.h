@@ -0,0 +1,51 @@
+#pragma once
+#include <memory>
+#include <unordered_map>
+#include <vector>
+#include "cpu/backend.h"
+#include "cpu/opcode.h"
+
+namespace mips {
+
+/**
+ * Interpreter executing pre-decoded basic blocks.
+ *
+ * Every block is fetched and decoded once, handlers from OpcodeTable/SpecialTable are resolved at that time.
+ * Instructions are still executed one by one with the same semantics as CPU::interpret,
+ * so it works on every host, unlike the recompiler.
+ */
+class CachedInterpreter : public Backend {
+   public:
+    CachedInterpreter(CPU* cpu);
+
+    bool execute(int count) override;
+    void flush() override;
+
+   private:
+    static const int MAX_BLOCK_LENGTH = 64;
+
+    struct Instruction {
+        void (*handler)(CPU*, Opcode);
+        Opcode opcode;
+    };
+
+    struct Block {
+        uint32_t pc;
+        uint32_t physStart;  // Offset into RAM, only valid for RAM blocks
+        uint32_t physEnd;
+        bool inRam;
+        std::vector<Instruction> instructions;
+    };
+
+    std::unordered_map<uint32_t, std::unique_ptr<Block>> blocks;
+
+    // Block being executed is kept alive when invalidated by its own store
+    Block* currentBlock = nullptr;
+    std::unique_ptr<Block> retiredBlock;
+
+    Block* getBlock(uint32_t pc);
+    Block* compile(uint32_t pc);
+    void removeBlock(uint32_t pc) override;
+};
+
+}  // namespace mips
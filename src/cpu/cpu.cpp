@@ -1,10 +1,14 @@
 #include "cpu.h"
+#include <fmt/core.h>
 #include "bios/functions.h"
+#include "config.h"
+#include "cpu/cached_interpreter.h"
 #include "cpu/instructions.h"
+#include "cpu/recompiler/recompiler.h"
 #include "system.h"
 
 namespace mips {
-CPU::CPU(System* sys) : sys(sys) {
+CPU::CPU(System* sys) : gte(sys->bus, sys->config), sys(sys), idleLoops(this), profiler(this) {
     setPC(0xBFC00000);
     inBranchDelay = false;
     icacheEnabled = false;
@@ -14,14 +18,22 @@ CPU::CPU(System* sys) : sys(sys) {
 
     for (auto& slot : slots) slot = {DUMMY_REG, 0};
     for (auto& line : icache) line = {0, 0};
-}
 
-INLINE void CPU::moveLoadDelaySlots() {
-    reg[slots[0].reg] = slots[0].data;
-    slots[0] = slots[1];
-    slots[1].reg = DUMMY_REG;  // invalidate
+    auto core = sys->config.options.system.cpuCore;
+    if (core == CpuCore::recompiler && !Recompiler::isSupported()) {
+        fmt::print("[CPU] Recompiler is not supported on this platform, using cached interpreter\n");
+        core = CpuCore::cachedInterpreter;
+    }
+
+    if (core == CpuCore::cachedInterpreter) {
+        backend = std::make_unique<CachedInterpreter>(this);
+    } else if (core == CpuCore::recompiler) {
+        backend = std::make_unique<Recompiler>(this);
+    }
 }
 
+CPU::~CPU() = default;
+
 void CPU::saveStateForException() {
     exceptionPC = PC;
     exceptionIsInBranchDelay = inBranchDelay;
@@ -77,6 +89,21 @@ INLINE uint32_t CPU::fetchInstruction(uint32_t address) {
 }
 
 bool CPU::executeInstructions(int count) {
+    if (unlikely(profiler.enabled)) {
+        uint64_t start = sys->cycles;
+        bool result = backend ? backend->execute(count) : interpret(count);
+        profiler.sample(PC, sys->cycles - start);
+        return result;
+    }
+
+    if (backend) {
+        return backend->execute(count);
+    }
+    return interpret(count);
+}
+
+bool CPU::interpret(int count) {
+    uint32_t idleLoopStart = 0, idleLoopEnd = 0;
     for (int i = 0; i < count; i++) {
 #ifdef ENABLE_BIOS_HOOKS
         uint32_t maskedPc = PC & 0x1fff'ffff;
@@ -98,12 +125,38 @@ bool CPU::executeInstructions(int count) {
         moveLoadDelaySlots();
 
         sys->cycles++;
+        if (unlikely(sys->scheduler.yield)) return true;
+
+        // Backward branch taken - finish its delay slot, then check if the loop is only waiting for devices
+        if (unlikely(branchTaken)) {
+            idleLoopStart = nextPC;
+            idleLoopEnd = PC;
+        } else if (unlikely(idleLoopEnd != 0)) {
+            if (PC == idleLoopStart && idleLoops.isIdle(idleLoopStart, idleLoopEnd)) {
+                idleLoops.skip(count - i - 1);
+                return true;
+            }
+            idleLoopEnd = 0;
+        }
     }
     return true;
 }
 
+bool CPU::executeOpcode(Opcode opcode) {
+    saveStateForException();
+
+    uint32_t expectedPC = nextPC;
+    const auto& op = instructions::OpcodeTable[opcode.op];
+
+    setPC(nextPC);
+    op.instruction(this, opcode);
+    moveLoadDelaySlots();
+
+    return PC == expectedPC && !sys->scheduler.yield;
+}
+
 void CPU::checkForInterrupts() {
-    if ((cop0.cause.interruptPending & cop0.status.interruptMask) && cop0.status.interruptEnable) {
+    if (interruptPending()) {
         instructions::exception(this, COP0::CAUSE::Exception::interrupt);
     }
 }
@@ -1,8 +1,11 @@
 #pragma once
 #include <cstdint>
+#include <memory>
 #include <unordered_map>
 #include "cpu/cop0.h"
 #include "cpu/gte/gte.h"
+#include "cpu/idle_loop.h"
+#include "cpu/profiler.h"
 #include "opcode.h"
 #include "utils/macros.h"
 
@@ -10,6 +13,8 @@ struct System;
 
 namespace mips {
 
+class Backend;
+
 /*
 Based on http://problemkaputt.de/psx-spx.htm
 0x00000000 - 0x20000000 is cache enabled
@@ -88,9 +93,22 @@ struct CPU {
 
     bool breakpointsEnabled = false;
 
+    // Block caching execution engine, interpreter loop is used if not set
+    std::unique_ptr<Backend> backend;
+    IdleLoopDetector idleLoops;
+    Profiler profiler;
+
     CPU(System* sys);
+    ~CPU();
     void checkForInterrupts();
-    INLINE void moveLoadDelaySlots();
+    bool interruptPending() const {
+        return (cop0.cause.interruptPending & cop0.status.interruptMask) && cop0.status.interruptEnable;
+    }
+    INLINE void moveLoadDelaySlots() {
+        reg[slots[0].reg] = slots[0].data;
+        slots[0] = slots[1];
+        slots[1].reg = DUMMY_REG;  // invalidate
+    }
     INLINE void loadDelaySlot(uint32_t r, uint32_t data) {
         if (r == 0) return;
         if (r == slots[0].reg) {
@@ -122,6 +140,9 @@ struct CPU {
     bool handleSoftwareBreakpoints();
     INLINE uint32_t fetchInstruction(uint32_t address);
     bool executeInstructions(int count);
+    bool interpret(int count);
+    // Executes single opcode (used by recompiler), returns false if exception occurred or device requested return to scheduler
+    bool executeOpcode(Opcode opcode);
 
     void busError();
 
@@ -0,0 +1,6 @@
+#pragma once
+enum class CpuCore {
+    interpreter,
+    cachedInterpreter,
+    recompiler,
+};
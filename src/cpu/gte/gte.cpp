@@ -1,7 +1,7 @@
 #include "gte.h"
 #include "config.h"
 
-GTE::GTE() : unrTable(generateUnrTable()) {
+GTE::GTE(Dexode::EventBus& bus, const avocado_config_t& config) : unrTable(generateUnrTable()), bus(bus), config(config) {
     busToken = bus.listen<Event::Config::Gte>([&](auto) { reload(); });
     reload();
 }
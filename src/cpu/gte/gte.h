@@ -7,6 +7,12 @@
 #include "math.h"
 #include "utils/logic.h"
 
+struct avocado_config_t;
+
+namespace Dexode {
+class EventBus;
+}
+
 namespace gui::debug {
 class GTE;
 }
@@ -66,30 +72,32 @@ class GTE {
     friend gui::debug::GTE;
 
     const std::array<uint8_t, 0x101> unrTable;
+    Dexode::EventBus& bus;
+    const avocado_config_t& config;
     int busToken;
     bool widescreenHack;
     bool logging;
-    bool sf;  // Used for setMac and setIr functions
-    bool lm;  // saved as fields to prevent passing them to every function
+    bool sf = false;  // Used for setMac and setIr functions
+    bool lm = false;  // saved as fields to prevent passing them to every function
 
     // GTE registers 0-63
-    gte::Vector<int16_t> v[3];
+    gte::Vector<int16_t> v[3] = {};
     Reg32 rgbc;
     uint16_t otz = 0;
     int16_t ir[4] = {0};
-    gte::Vector<int16_t, int16_t, uint16_t> s[4];
+    gte::Vector<int16_t, int16_t, uint16_t> s[4] = {};
     Reg32 rgb[3];
     uint32_t res1 = 0;     // prohibited
     int32_t mac[4] = {0};  // Sum of products
     int32_t lzcs = 0;
     int32_t lzcr = 0;
 
-    gte::Matrix rotation;
-    gte::Vector<int32_t> translation;
-    gte::Matrix light;
-    gte::Vector<int32_t> backgroundColor;
-    gte::Matrix color;
-    gte::Vector<int32_t> farColor;
+    gte::Matrix rotation = {};
+    gte::Vector<int32_t> translation = {};
+    gte::Matrix light = {};
+    gte::Vector<int32_t> backgroundColor = {};
+    gte::Matrix color = {};
+    gte::Vector<int32_t> farColor = {};
     int32_t of[2] = {0};
     uint16_t h = 0;
     int16_t dqa = 0;
@@ -168,7 +176,7 @@ class GTE {
     };
     std::vector<GTE_ENTRY> log;
 
-    GTE();
+    GTE(Dexode::EventBus& bus, const avocado_config_t& config);
     ~GTE();
 
     uint32_t read(uint8_t n);
@@ -0,0 +1,220 @@
+#include "idle_loop.h"
+#include <algorithm>
+#include "cpu/cpu.h"
+#include "system.h"
+#include "utils/address.h"
+#include "utils/file.h"
+
+namespace mips {
+
+namespace {
+struct Effects {
+    bool allowed = true;
+    uint64_t reads = 0;   // Register bitmasks
+    uint64_t writes = 0;  // Load target is excluded, it is visible one instruction later
+    uint32_t loadTarget = 0;
+    bool branch = false;
+    uint32_t target = 0;
+};
+
+// Decodes registers used by instructions which might be part of an idle loop
+Effects decode(Opcode i, uint32_t address) {
+    Effects e;
+    auto reg = [](uint32_t r) { return r == 0 ? 0ull : 1ull << r; };
+    auto branch = [&](uint64_t reads) {
+        e.reads = reads;
+        e.branch = true;
+        e.target = address + 4 + i.offset * 4;
+    };
+
+    switch (i.op) {
+        case 0:
+            switch (i.fun) {
+                case 0:
+                case 2:
+                case 3:
+                    e.reads = reg(i.rt);
+                    e.writes = reg(i.rd);
+                    break;
+                case 16:
+                case 18: e.writes = reg(i.rd); break;  // mfhi, mflo - nothing in the loop writes hi/lo
+                case 4:
+                case 6:
+                case 7:
+                case 32:
+                case 33:
+                case 34:
+                case 35:
+                case 36:
+                case 37:
+                case 38:
+                case 39:
+                case 42:
+                case 43:
+                    e.reads = reg(i.rs) | reg(i.rt);
+                    e.writes = reg(i.rd);
+                    break;
+                default: e.allowed = false; break;
+            }
+            break;
+        case 1:
+            if ((i.rt & 0x1e) == 0x10) e.allowed = false;  // Link variants
+            branch(reg(i.rs));
+            break;
+        case 2:
+            e.branch = true;
+            e.target = ((address + 4) & 0xf000'0000) | (i.target * 4);
+            break;
+        case 4:
+        case 5: branch(reg(i.rs) | reg(i.rt)); break;
+        case 6:
+        case 7: branch(reg(i.rs)); break;
+        case 8:
+        case 9:
+        case 10:
+        case 11:
+        case 12:
+        case 13:
+        case 14:
+            e.reads = reg(i.rs);
+            e.writes = reg(i.rt);
+            break;
+        case 15: e.writes = reg(i.rt); break;
+        case 32:
+        case 33:
+        case 35:
+        case 36:
+        case 37:
+            e.reads = reg(i.rs);
+            e.loadTarget = i.rt;
+            break;
+        default: e.allowed = false; break;
+    }
+    return e;
+}
+}  // namespace
+
+IdleLoopDetector::IdleLoopDetector(CPU* cpu) : enabled(cpu->sys->config.options.system.idleLoops.enabled), cpu(cpu) {}
+
+bool IdleLoopDetector::isIdle(uint32_t start, uint32_t end) {
+    if (!enabled) return false;
+
+    // Event scheduled during the loop has to be handled first
+    if (cpu->sys->scheduler.yield) return false;
+
+    // Pending interrupt will be taken on the next instruction
+    if ((cpu->cop0.cause.interruptPending & cpu->cop0.status.interruptMask) && cpu->cop0.status.interruptEnable) return false;
+
+    Loop* loop = getLoop(start, end);
+    if (loop == nullptr || !loop->idle) return false;
+
+    for (const auto& load : loop->loads) {
+        if (!isSideEffectFree(cpu->reg[load.base] + load.offset)) return false;
+    }
+    for (size_t n = 0; n < loop->code.size(); n++) {
+        if (cpu->sys->readMemory32(start + n * 4) != loop->code[n]) {
+            *loop = analyze(start, end);
+            return false;
+        }
+    }
+    return true;
+}
+
+bool IdleLoopDetector::isCandidate(uint32_t start, uint32_t end) {
+    if (!enabled) return false;
+    Loop* loop = getLoop(start, end);
+    return loop != nullptr && loop->idle;
+}
+
+void IdleLoopDetector::skip(int cycles) {
+    cpu->sys->cycles += cycles;
+    skippedCycles += cycles;
+}
+
+IdleLoopDetector::Loop* IdleLoopDetector::getLoop(uint32_t start, uint32_t end) {
+    if (end <= start || end - start >= MAX_LENGTH * 4) return nullptr;
+    if (last != nullptr && last->start == start && last->end == end) return last;
+
+    auto it = loops.find(start);
+    if (it == loops.end() || it->second.end != end) {
+        it = loops.insert_or_assign(start, analyze(start, end)).first;
+    }
+    return last = &it->second;
+}
+
+IdleLoopDetector::Loop IdleLoopDetector::analyze(uint32_t start, uint32_t end) {
+    Loop loop{start, end, false, {}, {}};
+
+    uint32_t physical = start & 0x1fff'ffff;
+    if (!in_range<System::RAM_BASE, System::RAM_SIZE_8MB>(physical) && !in_range<System::BIOS_BASE, System::BIOS_SIZE>(physical)) {
+        return loop;
+    }
+
+    // Per game overrides, keyed by disc image name
+    const auto& options = cpu->sys->config.options.system.idleLoops;
+    std::string game = getFilename(cpu->sys->cdrom->disc->getFile());
+    if (auto it = options.games.find(game); it != options.games.end() && !it->second) return loop;
+    if (auto it = options.ignored.find(game); it != options.ignored.end()) {
+        if (std::find(it->second.begin(), it->second.end(), start) != it->second.end()) return loop;
+    }
+
+    std::vector<Effects> effects;
+    uint64_t written = 0;
+    for (uint32_t address = start; address <= end; address += 4) {
+        Opcode i(cpu->sys->readMemory32(address));
+        Effects e = decode(i, address);
+        if (!e.allowed) return loop;
+
+        bool closing = address == end - 4;
+        if (closing && (!e.branch || e.target != start)) return loop;
+        if (!closing && e.branch && e.target >= start && e.target <= end) return loop;  // Only exits are allowed inside
+        if (address == end && (e.branch || e.loadTarget != 0)) return loop;             // Delay slot must not leak state
+
+        loop.code.push_back(i.opcode);
+        effects.push_back(e);
+        written |= e.writes | (e.loadTarget != 0 ? 1ull << e.loadTarget : 0);
+
+        if (i.op >= 32) {
+            loop.loads.push_back({i.rs, static_cast<uint32_t>(static_cast<int32_t>(i.offset))});
+        }
+    }
+
+    // Every register written in the loop has to be written before it is read, otherwise it carries state between iterations
+    uint64_t defined = 0;
+    uint64_t pendingLoad = 0;
+    for (const auto& e : effects) {
+        if (e.reads & written & ~defined) return loop;
+        defined |= pendingLoad | e.writes;
+        pendingLoad = e.loadTarget != 0 ? 1ull << e.loadTarget : 0;
+    }
+
+    // Load addresses have to be constant
+    for (const auto& load : loop.loads) {
+        if (written & (1ull << load.base)) return loop;
+    }
+
+    loop.idle = true;
+    return loop;
+}
+
+bool IdleLoopDetector::isSideEffectFree(uint32_t address) {
+    uint32_t addr = address & 0x1fff'ffff;
+    if (address >= 0xfffe'0000) return false;  // Cache control
+
+    if (in_range<System::RAM_BASE, System::RAM_SIZE_8MB>(addr)) return true;
+    if (in_range<System::SCRATCHPAD_BASE, System::SCRATCHPAD_SIZE>(addr)) return true;
+    if (in_range<System::BIOS_BASE, System::BIOS_SIZE>(addr)) return true;
+    if (in_range<System::EXPANSION_BASE, System::EXPANSION_SIZE>(addr)) return true;
+
+    if (in_range<0x1f801070, 8>(addr)) return true;     // Interrupt status and mask
+    if (in_range<0x1f801080, 0x80>(addr)) return true;  // DMA
+    if (addr >= 0x1f801100 && addr < 0x1f801130) {
+        return (addr & 0xf) >= 8 && (addr & 0xf) < 10;  // Timer target, value changes between events and mode read acks flags
+    }
+    if (addr == 0x1f801800) return true;                // CD-ROM status
+    if (in_range<0x1f801814, 4>(addr)) return true;     // GPUSTAT
+    if (in_range<0x1f801daa, 6>(addr)) return true;     // SPU control and status
+    return false;
+}
+
+}  // namespace mips
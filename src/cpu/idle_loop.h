@@ -0,0 +1,57 @@
+#pragma once
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+namespace mips {
+
+struct CPU;
+
+/**
+ * Detects short loops busy-waiting for a device or interrupt (polling I_STAT, GPUSTAT or a RAM flag set by IRQ handler).
+ *
+ * Loop qualifies when it is closed by a backward branch and:
+ * - contains only loads, ALU instructions and branches leaving the loop,
+ * - carries no register value between iterations, so every iteration is identical,
+ * - reads only memory and I/O registers without read side effects.
+ * Nothing such loop reads can change before the next scheduled event, so the rest of the CPU time slice can be skipped.
+ */
+class IdleLoopDetector {
+   public:
+    static const uint32_t MAX_LENGTH = 16;  // In instructions, including the delay slot
+
+    bool enabled;
+    uint64_t skippedCycles = 0;
+
+    IdleLoopDetector(CPU* cpu);
+
+    // Called when CPU is at the start of the loop, after the backward branch at end - 4 was taken
+    bool isIdle(uint32_t start, uint32_t end);
+    // Same checks without the CPU state dependent ones, used by the recompiler to decide which jumps to leave unlinked
+    bool isCandidate(uint32_t start, uint32_t end);
+    void skip(int cycles);
+
+   private:
+    struct Load {
+        uint32_t base;
+        uint32_t offset;
+    };
+
+    struct Loop {
+        uint32_t start;
+        uint32_t end;
+        bool idle;
+        std::vector<uint32_t> code;  // Detects overwritten loops
+        std::vector<Load> loads;
+    };
+
+    CPU* cpu;
+    std::unordered_map<uint32_t, Loop> loops;
+    Loop* last = nullptr;
+
+    Loop* getLoop(uint32_t start, uint32_t end);
+    Loop analyze(uint32_t start, uint32_t end);
+    static bool isSideEffectFree(uint32_t address);
+};
+
+}  // namespace mips
@@ -257,6 +257,7 @@ void op_jr(CPU *cpu, Opcode i) {
         return;
     }
     cpu->jump(addr);
+    if (unlikely(cpu->profiler.enabled)) cpu->profiler.jump(addr, i.rs == 31);
 }
 
 // Jump Register
@@ -270,6 +271,7 @@ void op_jalr(CPU *cpu, Opcode i) {
         exception(cpu, COP0::CAUSE::Exception::addressErrorLoad);
         return;
     }
+    if (unlikely(cpu->profiler.enabled)) cpu->profiler.call(addr, cpu->nextPC);
     cpu->jump(addr);
 }
 
@@ -458,6 +460,7 @@ void branch(CPU *cpu, Opcode i) {
 void op_j(CPU *cpu, Opcode i) {
     cpu->inBranchDelay = true;
     cpu->jump((cpu->nextPC & 0xf0000000) | (i.target * 4));
+    if (unlikely(cpu->profiler.enabled)) cpu->profiler.jump(cpu->nextPC, false);
 }
 
 // Jump And Link
@@ -466,6 +469,7 @@ void op_jal(CPU *cpu, Opcode i) {
     cpu->inBranchDelay = true;
     cpu->setReg(31, cpu->nextPC);
     cpu->jump((cpu->nextPC & 0xf0000000) | (i.target * 4));
+    if (unlikely(cpu->profiler.enabled)) cpu->profiler.call(cpu->nextPC, cpu->reg[31]);
 }
 
 // Branch On Equal
@@ -576,6 +580,7 @@ void op_cop0(CPU *cpu, Opcode i) {
             // MTC0 rt, cop0.rd
             cpu->cop0.write(i.rd, cpu->reg[i.rt]);
             cpu->updateBreakpointsFlag();
+            if (i.rd == 12) cpu->sys->updateCacheIsolation();
             break;
 
         case 16:
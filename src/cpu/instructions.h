@@ -83,4 +83,5 @@ void op_swc2(CPU* cpu, Opcode i);
 void op_breakpoint(CPU* cpu, Opcode i);
 
 extern std::array<PrimaryInstruction, 64> OpcodeTable;
+extern std::array<PrimaryInstruction, 64> SpecialTable;
 }  // namespace instructions
@@ -0,0 +1,173 @@
+#include "profiler.h"
+#include <fmt/core.h>
+#include <algorithm>
+#include "bios/functions.h"
+#include "cpu/cpu.h"
+#include "system.h"
+
+namespace mips {
+
+Profiler::Profiler(CPU* cpu) : cpu(cpu) { reset(); }
+
+void Profiler::reset() {
+    totalCycles = 0;
+    pcCycles.clear();
+    nodes.clear();
+    nodes.push_back({0, 0, 0});
+    children.clear();
+    stack.clear();
+}
+
+void Profiler::call(uint32_t target, uint32_t returnAddress) {
+    uint32_t masked = target & 0x1fff'ffff;
+    if (masked == 0xa0 || masked == 0xb0 || masked == 0xc0) {
+        push(biosFunction(masked), returnAddress);
+    } else {
+        push(target, returnAddress);
+    }
+}
+
+void Profiler::jump(uint32_t target, bool returns) {
+    if (returns) {
+        auto frame = std::find_if(stack.rbegin(), stack.rend(), [&](const Frame& f) { return f.returnAddress == target; });
+        if (frame == stack.rend()) return;  // Not a return from tracked call (eg. jump table), ignore
+
+        // Pops also the frames of functions which jumped to BIOS vector and return together with it
+        stack.erase(frame.base() - 1, stack.end());
+        while (!stack.empty() && stack.back().returnAddress == target) stack.pop_back();
+        return;
+    }
+
+    // BIOS functions are usually called through a stub doing "li t1, num; j 0xa0" or "jr t2"
+    uint32_t masked = target & 0x1fff'ffff;
+    if (masked == 0xa0 || masked == 0xb0 || masked == 0xc0) {
+        push(biosFunction(masked), cpu->reg[31]);
+    }
+}
+
+void Profiler::push(uint32_t function, uint32_t returnAddress) {
+    // Unbalanced calls (longjmp, thread switches) would eventually fill the stack, start over from the root
+    if (stack.size() >= MAX_DEPTH) stack.clear();
+
+    uint32_t parent = current();
+    uint64_t key = static_cast<uint64_t>(parent) << 32 | function;
+    auto it = children.find(key);
+    if (it == children.end()) {
+        it = children.emplace(key, static_cast<uint32_t>(nodes.size())).first;
+        nodes.push_back({parent, function, 0});
+    }
+    stack.push_back({it->second, returnAddress});
+}
+
+uint32_t Profiler::biosFunction(uint32_t vector) const {
+    uint32_t table = (vector >> 4) - 0xa;
+
+    // Function number is loaded to t1 in the delay slot of the jump, PC points to it at this point
+    uint32_t number = cpu->reg[9];
+    Opcode i(cpu->sys->readMemory32(cpu->PC));
+    if ((i.op == 9 || i.op == 13) && i.rs == 0 && i.rt == 9) {  // addiu/ori t1, zero, num
+        number = i.imm;
+    }
+    return BIOS_FUNCTION | table << 8 | (number & 0xff);
+}
+
+std::vector<Profiler::Entry> Profiler::sorted(const std::unordered_map<uint32_t, uint64_t>& cycles, size_t count) {
+    std::vector<Entry> entries;
+    entries.reserve(cycles.size());
+    for (const auto& [address, c] : cycles) {
+        entries.push_back({address, c});
+    }
+
+    count = std::min(count, entries.size());
+    std::partial_sort(entries.begin(), entries.begin() + count, entries.end(), [](const Entry& a, const Entry& b) {
+        return a.cycles != b.cycles ? a.cycles > b.cycles : a.address < b.address;
+    });
+    entries.resize(count);
+    return entries;
+}
+
+std::vector<Profiler::Entry> Profiler::hottestAddresses(size_t count) const { return sorted(pcCycles, count); }
+
+std::vector<Profiler::Entry> Profiler::hottestFunctions(size_t count) const {
+    std::unordered_map<uint32_t, uint64_t> functions;
+    for (size_t n = 1; n < nodes.size(); n++) {
+        if (nodes[n].cycles != 0) functions[nodes[n].function] += nodes[n].cycles;
+    }
+    return sorted(functions, count);
+}
+
+std::vector<Profiler::Entry> Profiler::hottestBiosFunctions(size_t count) const {
+    std::unordered_map<uint32_t, uint64_t> functions;
+    std::vector<uint32_t> seen;
+    for (const auto& node : nodes) {
+        if (node.cycles == 0) continue;
+
+        // Recursive calls are counted once
+        seen.clear();
+        for (const Node* n = &node; n != &nodes[0]; n = &nodes[n->parent]) {
+            if ((n->function & BIOS_FUNCTION) != BIOS_FUNCTION) continue;
+            if (std::find(seen.begin(), seen.end(), n->function) != seen.end()) continue;
+            seen.push_back(n->function);
+            functions[n->function] += node.cycles;
+        }
+    }
+    return sorted(functions, count);
+}
+
+std::string Profiler::functionName(uint32_t function) const {
+    if ((function & BIOS_FUNCTION) != BIOS_FUNCTION) {
+        return fmt::format("func_{:08x}", function);
+    }
+
+    uint32_t table = (function >> 8) & 0xff;
+    uint8_t number = function & 0xff;
+    const auto& functions = bios::tables[table];
+    if (auto it = functions.find(number); it != functions.end()) {
+        return fmt::format("{:X}0:{}", 0xa + table, it->second.name);
+    }
+    return fmt::format("{:X}0:{:02x}", 0xa + table, number);
+}
+
+std::string Profiler::report(size_t count) const {
+    auto percent = [&](uint64_t cycles) { return totalCycles == 0 ? 0.0 : 100.0 * cycles / totalCycles; };
+
+    std::string out = fmt::format("Profiled cycles: {}\n", totalCycles);
+
+    out += "\nHottest addresses:\n";
+    for (const auto& e : hottestAddresses(count)) {
+        out += fmt::format("{:>14} {:6.2f}%  0x{:08x}\n", e.cycles, percent(e.cycles), e.address);
+    }
+
+    out += "\nHottest functions (self):\n";
+    for (const auto& e : hottestFunctions(count)) {
+        out += fmt::format("{:>14} {:6.2f}%  {}\n", e.cycles, percent(e.cycles), functionName(e.address));
+    }
+
+    out += "\nBIOS calls (total):\n";
+    for (const auto& e : hottestBiosFunctions(count)) {
+        out += fmt::format("{:>14} {:6.2f}%  {}\n", e.cycles, percent(e.cycles), functionName(e.address));
+    }
+    return out;
+}
+
+std::string Profiler::collapsedStacks() const {
+    std::string out;
+    std::vector<uint32_t> path;
+    for (size_t n = 0; n < nodes.size(); n++) {
+        if (nodes[n].cycles == 0) continue;
+
+        path.clear();
+        for (uint32_t i = n; i != 0; i = nodes[i].parent) {
+            path.push_back(nodes[i].function);
+        }
+
+        std::string line = "root";
+        for (auto it = path.rbegin(); it != path.rend(); ++it) {
+            line += ";" + functionName(*it);
+        }
+        out += fmt::format("{} {}\n", line, nodes[n].cycles);
+    }
+    return out;
+}
+
+}  // namespace mips
@@ -0,0 +1,83 @@
+#pragma once
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include "utils/macros.h"
+
+namespace mips {
+
+struct CPU;
+
+/**
+ * Sampling profiler of guest code.
+ *
+ * At the end of every CPU time slice the cycles executed in it are charged to the current PC and to the current call stack,
+ * so the cost does not depend on the number of executed instructions and works the same for every execution core.
+ * Call stack is shadowed from jal/jalr and jr ra, BIOS A0/B0/C0 calls get their own frames named after bios::tables.
+ */
+class Profiler {
+   public:
+    static const size_t MAX_DEPTH = 64;
+
+    struct Entry {
+        uint32_t address;  // PC, function address or BIOS function id
+        uint64_t cycles;
+    };
+
+    bool enabled = false;
+
+    Profiler(CPU* cpu);
+    void reset();
+
+    // Called after CPU time slice with the PC it ended on
+    INLINE void sample(uint32_t pc, uint64_t cycles) {
+        pcCycles[pc] += cycles;
+        nodes[current()].cycles += cycles;
+        totalCycles += cycles;
+    }
+    // Called by jal and jalr
+    void call(uint32_t target, uint32_t returnAddress);
+    // Called by j and jr, returns when jumping to ra and follows tail calls to BIOS vectors
+    void jump(uint32_t target, bool returns);
+
+    uint64_t getTotalCycles() const { return totalCycles; }
+    // Sorted by cycles, descending
+    std::vector<Entry> hottestAddresses(size_t count) const;
+    std::vector<Entry> hottestFunctions(size_t count) const;     // Self cycles
+    std::vector<Entry> hottestBiosFunctions(size_t count) const;  // Including everything called from BIOS function
+    std::string functionName(uint32_t function) const;
+
+    std::string report(size_t count = 50) const;
+    // One line per unique call stack, "root;func_80012345;A0:printf 1234", readable by flamegraph.pl and speedscope
+    std::string collapsedStacks() const;
+
+   private:
+    // BIOS functions are stored as BIOS_FUNCTION | table << 8 | number, there is no code at these addresses
+    static const uint32_t BIOS_FUNCTION = 0xffff'0000;
+
+    struct Node {
+        uint32_t parent;
+        uint32_t function;
+        uint64_t cycles;  // Self cycles
+    };
+
+    struct Frame {
+        uint32_t node;
+        uint32_t returnAddress;
+    };
+
+    CPU* cpu;
+    uint64_t totalCycles = 0;
+    std::unordered_map<uint32_t, uint64_t> pcCycles;
+    std::vector<Node> nodes;                          // Call tree, node 0 is the root
+    std::unordered_map<uint64_t, uint32_t> children;  // parent << 32 | function -> node
+    std::vector<Frame> stack;
+
+    uint32_t current() const { return stack.empty() ? 0 : stack.back().node; }
+    void push(uint32_t function, uint32_t returnAddress);
+    uint32_t biosFunction(uint32_t vector) const;
+    static std::vector<Entry> sorted(const std::unordered_map<uint32_t, uint64_t>& cycles, size_t count);
+};
+
+}  // namespace mips
@@ -0,0 +1,670 @@
+#include "recompiler.h"
+#include <fmt/core.h>
+#include <algorithm>
+#include "cpu/cpu.h"
+#include "system.h"
+#include "x64_emitter.h"
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <sys/mman.h>
+#endif
+
+#if defined(__linux__) && defined(__x86_64__)
+#include <signal.h>
+#include <mutex>
+#define FASTMEM_FAULT_HANDLER
+#endif
+
+namespace mips {
+using namespace x64;
+
+namespace {
+uint8_t* allocateExecutable(size_t size) {
+#ifdef _WIN32
+    return static_cast<uint8_t*>(VirtualAlloc(nullptr, size, MEM_COMMIT | MEM_RESERVE, PAGE_EXECUTE_READWRITE));
+#else
+    void* ptr = mmap(nullptr, size, PROT_READ | PROT_WRITE | PROT_EXEC, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    return ptr == MAP_FAILED ? nullptr : static_cast<uint8_t*>(ptr);
+#endif
+}
+
+void freeExecutable(uint8_t* ptr, size_t size) {
+#ifdef _WIN32
+    UNUSED(size);
+    VirtualFree(ptr, 0, MEM_RELEASE);
+#else
+    munmap(ptr, size);
+#endif
+}
+
+template <typename Base, typename T>
+int32_t offsetOf(const Base* base, const T* field) {
+    return static_cast<int32_t>(reinterpret_cast<const uint8_t*>(field) - reinterpret_cast<const uint8_t*>(base));
+}
+
+// Instructions writing GPR through load delay slot
+bool isLoad(Opcode i) {
+    if (i.op >= 32 && i.op <= 38) return true;                  // lb, lh, lwl, lw, lbu, lhu, lwr
+    if (i.op == 18 && (i.rs == 0 || i.rs == 2)) return true;  // mfc2, cfc2
+    return i.op == 16 && i.rs == 0;                            // mfc0
+}
+
+// COP0 writes might unmask interrupts or return from exception, dispatcher has to check them
+bool endsBlock(Opcode i) { return i.op == 16; }
+
+#ifdef FASTMEM_FAULT_HANDLER
+thread_local Recompiler* activeRecompiler = nullptr;
+struct sigaction previousFaultAction;
+
+void faultHandler(int sig, siginfo_t* info, void* context) {
+    auto uc = static_cast<ucontext_t*>(context);
+    uintptr_t pc = uc->uc_mcontext.gregs[REG_RIP];
+    if (activeRecompiler != nullptr && activeRecompiler->handleFault(pc, info->si_addr)) {
+        uc->uc_mcontext.gregs[REG_RIP] = pc;
+        return;
+    }
+
+    // Not caused by generated code, faulting instruction is retried with the previous handler
+    sigaction(sig, &previousFaultAction, nullptr);
+}
+
+void installFaultHandler() {
+    static std::once_flag installed;
+    std::call_once(installed, [] {
+        struct sigaction action = {};
+        action.sa_sigaction = faultHandler;
+        action.sa_flags = SA_SIGINFO;
+        sigemptyset(&action.sa_mask);
+        sigaction(SIGSEGV, &action, &previousFaultAction);
+    });
+}
+#endif
+
+bool isBiosHook(uint32_t pc) {
+#ifdef ENABLE_BIOS_HOOKS
+    uint32_t maskedPc = pc & 0x1fff'ffff;
+    return maskedPc == 0xa0 || maskedPc == 0xb0 || maskedPc == 0xc0;
+#else
+    UNUSED(pc);
+    return false;
+#endif
+}
+};  // namespace
+
+bool Recompiler::isSupported() {
+#if defined(__x86_64__) || defined(_M_X64)
+    return true;
+#else
+    return false;
+#endif
+}
+
+Recompiler::Recompiler(CPU* cpu) : Backend(cpu) {
+    offsetPC = offsetOf(cpu, &cpu->PC);
+    offsetNextPC = offsetOf(cpu, &cpu->nextPC);
+    offsetInBranchDelay = offsetOf(cpu, &cpu->inBranchDelay);
+    offsetBranchTaken = offsetOf(cpu, &cpu->branchTaken);
+    offsetSlotReg = offsetOf(cpu, &cpu->slots[0].reg);
+    offsetSlotData = offsetOf(cpu, &cpu->slots[0].data);
+    offsetReg = offsetOf(cpu, &cpu->reg[0]);
+    offsetHi = offsetOf(cpu, &cpu->hi);
+    offsetLo = offsetOf(cpu, &cpu->lo);
+    offsetStatus = offsetOf(cpu, &cpu->cop0.status._reg);
+    offsetCause = offsetOf(cpu, &cpu->cop0.cause._reg);
+
+    codeBuffer = allocateExecutable(CODE_BUFFER_SIZE);
+    if (codeBuffer == nullptr) {
+        fmt::print("[JIT] Unable to allocate executable memory\n");
+        return;
+    }
+    emitTrampolines();
+
+#ifdef FASTMEM_FAULT_HANDLER
+    if (sys->hostMemory) installFaultHandler();
+#endif
+}
+
+Recompiler::~Recompiler() {
+    if (codeBuffer != nullptr) freeExecutable(codeBuffer, CODE_BUFFER_SIZE);
+}
+
+void Recompiler::emitTrampolines() {
+    Emitter e(codeBuffer, CODE_BUFFER_SIZE);
+
+    // void enter(CPU* cpu, Recompiler* rec, const uint8_t* code)
+    // rbx holds CPU*, r12 holds Recompiler* and r13 fastmem base for the whole generated code
+    enter = reinterpret_cast<EnterFunc>(e.current());
+    e.push(RBX);
+    e.push(R12);
+    e.push(R13);
+    e.alu64(Alu::SUB, RSP, 32);  // Align stack to 16 bytes and reserve Win64 shadow space
+    e.mov64(RBX, ARG0);
+    e.mov64(R12, ARG1);
+    e.mov64(R13, Mem{R12, offsetOf(this, &fastmemBase)});
+    e.jmp(ARG2);
+
+    exitStub = e.current();
+    e.alu64(Alu::ADD, RSP, 32);
+    e.pop(R13);
+    e.pop(R12);
+    e.pop(RBX);
+    e.ret();
+
+    codeStart = codeUsed = e.offset();
+}
+
+void Recompiler::flush() {
+    blocks.clear();
+    pendingLinks.clear();
+    slowPaths.clear();
+    clearPages();
+    codeUsed = codeStart;
+}
+
+bool Recompiler::interpretOpcode(CPU* cpu, uint32_t opcode) {
+    if (!cpu->executeOpcode(Opcode(opcode))) return false;
+    // Interrupt raised by I/O access is taken before the next instruction, like in the interpreter
+    return !cpu->interruptPending();
+}
+
+bool Recompiler::execute(int count) {
+    if (codeBuffer == nullptr || unlikely(cpu->breakpointsEnabled)) {
+        return cpu->interpret(count);
+    }
+
+#ifdef FASTMEM_FAULT_HANDLER
+    activeRecompiler = this;
+#endif
+    fastmemBase = sys->fastmem;
+    sliceEnd = sys->cycles + count;
+    while (sys->cycles < sliceEnd && !sys->scheduler.yield) {
+        // Blocks assume that they are entered outside of branch delay slot
+        if (cpu->nextPC != cpu->PC + 4 || !isCompilable(cpu->PC)) {
+            cpu->interpret(1);
+            continue;
+        }
+
+#ifdef ENABLE_BIOS_HOOKS
+        if (isBiosHook(cpu->PC)) sys->handleBiosFunction();
+#endif
+
+        cpu->saveStateForException();
+        cpu->checkForInterrupts();
+
+        Block* block = getBlock(cpu->PC);
+        if (block == nullptr) {
+            cpu->interpret(1);
+            continue;
+        }
+        // Rest of the time slice is interpreted if the block doesn't fit, so it ends at the same instruction as with the interpreter
+        if (sys->cycles + block->length > sliceEnd) {
+            cpu->interpret(static_cast<int>(sliceEnd - sys->cycles));
+            break;
+        }
+
+        enter(cpu, this, block->code);
+
+        if (unlikely(idleLoopEnd != 0)) {
+            if (sys->cycles < sliceEnd && cpu->idleLoops.isIdle(cpu->PC, idleLoopEnd)) {
+                cpu->idleLoops.skip(static_cast<int>(sliceEnd - sys->cycles));
+            }
+            idleLoopEnd = 0;
+        }
+    }
+#ifdef FASTMEM_FAULT_HANDLER
+    activeRecompiler = nullptr;
+#endif
+    return true;
+}
+
+bool Recompiler::handleFault(uintptr_t& hostPc, const void* address) {
+    if (!sys->hostMemory || !sys->hostMemory->contains(address)) return false;
+
+    auto it = slowPaths.find(reinterpret_cast<uint8_t*>(hostPc));
+    if (it == slowPaths.end()) return false;
+
+    // Replace the access with a jump, so next executions go straight to the slow path
+    Emitter e(it->first, Emitter::MAX_INSTRUCTION_SIZE);
+    e.jmp(it->second);
+
+    hostPc = reinterpret_cast<uintptr_t>(it->second);
+    slowPaths.erase(it);
+    return true;
+}
+
+Recompiler::Block* Recompiler::getBlock(uint32_t pc) {
+    auto it = blocks.find(pc);
+    if (it != blocks.end()) return &it->second;
+    return compile(pc);
+}
+
+bool Recompiler::emitNative(Emitter& e, Opcode i, bool loadPending) {
+    auto reg = [&](uint32_t r) { return Mem{RBX, offsetReg + static_cast<int32_t>(r * 4)}; };
+    const Mem hi{RBX, offsetHi};
+    const Mem lo{RBX, offsetLo};
+    const uint32_t imm = i.imm;
+    const uint32_t simm = static_cast<uint32_t>(static_cast<int32_t>(i.offset));
+
+    // Compute result into eax, destination is GPR unless hi/lo is set
+    uint32_t rd = 0;
+    const Mem* special = nullptr;
+
+    auto binary = [&](Alu op, uint32_t dst) {
+        e.mov(RAX, reg(i.rs));
+        e.alu(op, RAX, reg(i.rt));
+        rd = dst;
+    };
+    auto immediate = [&](Alu op, uint32_t value) {
+        e.mov(RAX, reg(i.rs));
+        e.alu(op, RAX, value);
+        rd = i.rt;
+    };
+    auto setOnCompare = [&](Cond cond, bool withImmediate) {
+        e.mov(RAX, reg(i.rs));
+        if (withImmediate) {
+            e.alu(Alu::CMP, RAX, simm);
+            rd = i.rt;
+        } else {
+            e.alu(Alu::CMP, RAX, reg(i.rt));
+            rd = i.rd;
+        }
+        e.setcc(cond, RAX);
+        e.movzx8(RAX, RAX);
+    };
+    auto shift = [&](Shift op, bool variable) {
+        e.mov(RAX, reg(i.rt));
+        if (variable) {
+            e.mov(RCX, reg(i.rs));
+            e.shiftCl(op, RAX);
+        } else {
+            e.shift(op, RAX, i.sh);
+        }
+        rd = i.rd;
+    };
+
+    // NOP (sll r0, r0, 0)
+    if (i.opcode == 0 && !loadPending) return true;
+
+    switch (i.op) {
+        case 0:
+            switch (i.fun) {
+                case 0: shift(Shift::SHL, false); break;
+                case 2: shift(Shift::SHR, false); break;
+                case 3: shift(Shift::SAR, false); break;
+                case 4: shift(Shift::SHL, true); break;
+                case 6: shift(Shift::SHR, true); break;
+                case 7: shift(Shift::SAR, true); break;
+                case 16:
+                    e.mov(RAX, hi);
+                    rd = i.rd;
+                    break;
+                case 17:
+                    e.mov(RAX, reg(i.rs));
+                    special = &hi;
+                    break;
+                case 18:
+                    e.mov(RAX, lo);
+                    rd = i.rd;
+                    break;
+                case 19:
+                    e.mov(RAX, reg(i.rs));
+                    special = &lo;
+                    break;
+                case 33: binary(Alu::ADD, i.rd); break;
+                case 35: binary(Alu::SUB, i.rd); break;
+                case 36: binary(Alu::AND, i.rd); break;
+                case 37: binary(Alu::OR, i.rd); break;
+                case 38: binary(Alu::XOR, i.rd); break;
+                case 39:
+                    binary(Alu::OR, i.rd);
+                    e.not_(RAX);
+                    break;
+                case 42: setOnCompare(Cond::L, false); break;
+                case 43: setOnCompare(Cond::B, false); break;
+                default: return false;
+            }
+            break;
+        case 9: immediate(Alu::ADD, simm); break;
+        case 10: setOnCompare(Cond::L, true); break;
+        case 11: setOnCompare(Cond::B, true); break;
+        case 12: immediate(Alu::AND, imm); break;
+        case 13: immediate(Alu::OR, imm); break;
+        case 14: immediate(Alu::XOR, imm); break;
+        case 15:
+            e.mov(RAX, imm << 16);
+            rd = i.rt;
+            break;
+        default: return false;
+    }
+
+    // Previous instruction was a load - commit it before writing result,
+    // so write to the same register overrides loaded value (like CPU::setReg does)
+    if (loadPending) {
+        e.mov(RCX, Mem{RBX, offsetSlotReg});
+        e.mov(RDX, Mem{RBX, offsetSlotData});
+        e.mov(Mem{RBX, offsetReg, RCX}, RDX);
+        e.mov(Mem{RBX, offsetSlotReg}, static_cast<uint32_t>(DUMMY_REG));
+    }
+
+    if (special != nullptr) {
+        e.mov(*special, RAX);
+    } else if (rd != 0) {
+        e.mov(reg(rd), RAX);
+    }
+    return true;
+}
+
+bool Recompiler::emitFastmem(Emitter& e, Opcode i, bool loadPending, SlowPath& slow) {
+    auto reg = [&](uint32_t r) { return Mem{RBX, offsetReg + static_cast<int32_t>(r * 4)}; };
+    const Mem guest{R13, 0, RAX, 1};
+    const uint32_t simm = static_cast<uint32_t>(static_cast<int32_t>(i.offset));
+
+    uint32_t alignMask;
+    switch (i.op) {
+        case 32:
+        case 36:
+        case 40: alignMask = 0; break;  // lb, lbu, sb
+        case 33:
+        case 37:
+        case 41: alignMask = 1; break;  // lh, lhu, sh
+        case 35:
+        case 43: alignMask = 3; break;  // lw, sw
+        default: return false;
+    }
+    const bool store = i.op >= 40;
+
+    e.mov(RAX, reg(i.rs));
+    e.alu(Alu::ADD, RAX, simm);
+    if (alignMask != 0) {
+        e.test(RAX, alignMask);
+        slow.jumps.push_back(e.jcc(Cond::NE));  // Address error
+    }
+    if (store) {
+        e.test(Mem{RBX, offsetStatus}, 1 << 16);
+        slow.jumps.push_back(e.jcc(Cond::NE));  // Isolated cache
+        e.mov(RCX, reg(i.rt));
+    }
+    e.alu(Alu::AND, RAX, 0x1fff'ffff);
+
+    slow.access = e.current();
+    switch (i.op) {
+        case 32: e.movsx8(RAX, guest); break;
+        case 33: e.movsx16(RAX, guest); break;
+        case 35: e.mov(RAX, guest); break;
+        case 36: e.movzx8(RAX, guest); break;
+        case 37: e.movzx16(RAX, guest); break;
+        case 40: e.mov8(guest, RCX); break;
+        case 41: e.mov16(guest, RCX); break;
+        case 43: e.mov(guest, RCX); break;
+    }
+
+    // Commit previous load, unless this load overrides the same register (like CPU::loadDelaySlot does)
+    if (loadPending) {
+        e.mov(RCX, Mem{RBX, offsetSlotReg});
+        uint8_t* overridden = nullptr;
+        if (!store && i.rt != 0) {
+            e.alu(Alu::CMP, RCX, i.rt);
+            overridden = e.jcc(Cond::E);
+        }
+        e.mov(RDX, Mem{RBX, offsetSlotData});
+        e.mov(Mem{RBX, offsetReg, RCX}, RDX);
+        if (overridden != nullptr) Emitter::patch(overridden, e.current());
+    }
+
+    if (!store && i.rt != 0) {
+        e.mov(Mem{RBX, offsetSlotReg}, i.rt);
+        e.mov(Mem{RBX, offsetSlotData}, RAX);
+    } else if (loadPending) {
+        e.mov(Mem{RBX, offsetSlotReg}, static_cast<uint32_t>(DUMMY_REG));
+    }
+    return true;
+}
+
+void Recompiler::emitSlowPath(Emitter& e, const SlowPath& slow) {
+    for (uint8_t* rel : slow.jumps) Emitter::patch(rel, e.current());
+    slowPaths[slow.access] = e.current();
+
+    if (slow.syncPC) {
+        e.mov(Mem{RBX, offsetPC}, slow.address);
+        e.mov(Mem{RBX, offsetNextPC}, slow.address + 4);
+    }
+    uint8_t* ok = emitInterpreterCall(e, slow.opcode, slow.count, slow.synced);
+    Emitter::patch(ok, e.current());
+
+    // Fast path continues with fewer instructions added to System::cycles
+    emitAddCycles(e, slow.synced - slow.count);
+    e.jmp(slow.resume);
+}
+
+void Recompiler::emitAddCycles(Emitter& e, int cycles) {
+    if (cycles == 0) return;
+    e.mov64(RAX, reinterpret_cast<uint64_t>(&sys->cycles));
+    e.alu64(Alu::ADD, Mem{RAX, 0}, static_cast<uint32_t>(cycles));
+}
+
+uint8_t* Recompiler::emitInterpreterCall(Emitter& e, Opcode i, int count, int synced) {
+    // Devices synchronized during the call see time of this instruction
+    emitAddCycles(e, count - synced);
+
+    e.mov64(ARG0, RBX);
+    e.mov(ARG1, i.opcode);
+    e.mov64(RAX, reinterpret_cast<uint64_t>(&Recompiler::interpretOpcode));
+    e.call(RAX);
+    e.movzx8(RAX, RAX);
+    e.test(RAX, RAX);
+    uint8_t* ok = e.jcc(Cond::NE);
+    // Exception, interrupt or scheduler yield - PC already points to the next instruction (or exception handler)
+    emitAddCycles(e, 1);
+    e.jmp(exitStub);
+    return ok;
+}
+
+Recompiler::Block* Recompiler::compile(uint32_t pc) {
+    if (!isCompilable(pc)) return nullptr;
+    if (CODE_BUFFER_SIZE - codeUsed < MAX_BLOCK_SIZE) {
+        flush();
+    }
+
+    Emitter e(codeBuffer, CODE_BUFFER_SIZE, codeUsed);
+    const Mem memPC{RBX, offsetPC};
+    const Mem memNextPC{RBX, offsetNextPC};
+
+    Block block;
+    block.pc = pc;
+    block.code = e.current();
+    block.inRam = ramOffset(pc, block.physStart);
+
+    // Chained block is entered only if it fits in the time slice, length is patched once it is known
+    e.mov64(RAX, reinterpret_cast<uint64_t>(&sys->cycles));
+    e.mov64(RAX, Mem{RAX, 0});
+    e.alu64(Alu::ADD, RAX, 0);
+    uint8_t* lengthImm = e.current() - 4;
+    e.alu64(Alu::CMP, RAX, Mem{R12, offsetOf(this, &sliceEnd)});
+    e.jcc(Cond::A, exitStub);
+
+    std::vector<uint32_t> successors;
+    std::vector<SlowPath> slowPathList;
+    uint32_t idleStart = 0;  // Backward branch which might close an idle loop is never chained
+    uint32_t idleEnd = 0;
+    bool exitToDispatcher = false;
+    bool loadPending = true;  // Previous block might have ended with a load
+    bool pcSynced = true;     // PC and nextPC in CPU struct match currently compiled instruction
+    bool delaySlot = false;
+    uint32_t address = pc;
+    int count = 0;
+    int synced = 0;  // Instructions added to System::cycles so far
+
+    auto syncPC = [&](uint32_t at) {
+        e.mov(memPC, at);
+        e.mov(memNextPC, at + 4);
+    };
+
+    for (;;) {
+        Opcode i(sys->readMemory32(address));
+
+        // Branch in branch delay slot - leave it for the interpreter
+        if (isBranch(i) && !delaySlot && isBranch(Opcode(sys->readMemory32(address + 4)))) {
+            if (count == 0) return nullptr;
+            if (!pcSynced) syncPC(address);
+            successors.push_back(address);
+            break;
+        }
+
+        SlowPath slow{{}, nullptr, nullptr, i, address, count, synced, !pcSynced};
+        bool native = emitNative(e, i, loadPending);
+        if (!native && sys->fastmem != nullptr) native = emitFastmem(e, i, loadPending, slow);
+
+        if (native) {
+            pcSynced = false;
+            loadPending = slow.access != nullptr && isLoad(i) && i.rt != 0;
+        } else {
+            if (!pcSynced) syncPC(address);
+            uint8_t* ok = emitInterpreterCall(e, i, count, synced);
+            Emitter::patch(ok, e.current());
+            synced = count;
+
+            pcSynced = true;
+            loadPending = isLoad(i);
+        }
+        count++;
+
+        if (delaySlot && native) {
+            // Finish the branch, interpreter does the same in setPC(nextPC) and saveStateForException
+            e.mov(RAX, memNextPC);
+            e.mov(memPC, RAX);
+            e.alu(Alu::ADD, RAX, 4);
+            e.mov(memNextPC, RAX);
+            e.mov8(Mem{RBX, offsetInBranchDelay}, 0);
+            e.mov8(Mem{RBX, offsetBranchTaken}, 0);
+        }
+        if (slow.access != nullptr) {
+            slow.resume = e.current();
+            slowPathList.push_back(std::move(slow));
+        }
+        if (delaySlot) break;
+
+        if (isBranch(i)) {
+            uint32_t delaySlotAddress = address + 4;
+            if (i.op == 2 || i.op == 3) {
+                successors.push_back((delaySlotAddress & 0xf000'0000) | (i.target * 4));
+            } else if (i.op != 0) {
+                successors.push_back(delaySlotAddress + i.offset * 4);
+                successors.push_back(delaySlotAddress + 4);
+            }
+            if (i.op != 0 && successors.front() < delaySlotAddress && cpu->idleLoops.isCandidate(successors.front(), delaySlotAddress)) {
+                idleStart = successors.front();
+                idleEnd = delaySlotAddress;
+            }
+            delaySlot = true;
+        } else if (endsBlock(i)) {
+            exitToDispatcher = true;
+            break;
+        } else if (count >= MAX_BLOCK_LENGTH) {
+            if (!pcSynced) syncPC(address + 4);
+            successors.push_back(address + 4);
+            break;
+        }
+        address += 4;
+    }
+
+    emitAddCycles(e, count - synced);
+    if (!exitToDispatcher && !successors.empty()) {
+        // Chain to next block only if no interrupt is pending, time slice is checked by the next block
+        e.mov(RAX, Mem{RBX, offsetStatus});
+        e.alu(Alu::AND, RAX, Mem{RBX, offsetCause});
+        e.alu(Alu::AND, RAX, 0xff00);
+        uint8_t* noInterrupt = e.jcc(Cond::E);
+        e.test(Mem{RBX, offsetStatus}, 1);
+        e.jcc(Cond::NE, exitStub);
+        Emitter::patch(noInterrupt, e.current());
+
+        if (idleEnd != 0) {
+            // Let the dispatcher check if the loop is waiting for devices
+            e.alu(Alu::CMP, memPC, idleStart);
+            uint8_t* notTaken = e.jcc(Cond::NE);
+            e.mov(Mem{R12, offsetOf(this, &idleLoopEnd)}, idleEnd);
+            e.jmp(exitStub);
+            Emitter::patch(notTaken, e.current());
+        }
+
+        for (uint32_t target : successors) {
+            e.alu(Alu::CMP, memPC, target);
+            block.outgoing.push_back({target, e.jcc(Cond::E, exitStub)});
+        }
+    }
+    e.jmp(exitStub);
+    for (auto& slow : slowPathList) emitSlowPath(e, slow);
+    codeUsed = e.offset();
+
+    block.physEnd = block.physStart + count * 4;
+    block.length = count;
+    memcpy(lengthImm, &count, sizeof(count));
+
+    Block& b = blocks.emplace(pc, std::move(block)).first->second;
+
+    if (b.inRam) registerBlock(pc, b.physStart, b.physEnd);
+
+    std::vector<Link> outgoing;
+    outgoing.swap(b.outgoing);
+    for (auto& l : outgoing) link(b, l.target, l.rel);
+
+    // Resolve jumps from already compiled blocks
+    if (!isBiosHook(pc)) {
+        auto range = pendingLinks.equal_range(pc);
+        for (auto link = range.first; link != range.second; ++link) {
+            Emitter::patch(link->second, b.code);
+            b.incoming.push_back(link->second);
+        }
+        pendingLinks.erase(range.first, range.second);
+    }
+
+    return &b;
+}
+
+void Recompiler::link(Block& block, uint32_t target, uint8_t* rel) {
+    block.outgoing.push_back({target, rel});
+
+    auto it = blocks.find(target);
+    if (it != blocks.end() && !isBiosHook(target)) {
+        Emitter::patch(rel, it->second.code);
+        it->second.incoming.push_back(rel);
+    } else {
+        pendingLinks.emplace(target, rel);
+    }
+}
+
+void Recompiler::removeBlock(uint32_t pc) {
+    auto it = blocks.find(pc);
+    if (it == blocks.end()) return;
+    Block& block = it->second;
+
+    // Code itself stays in the buffer (it might be executing right now), only jumps into it are removed
+    for (uint8_t* rel : block.incoming) {
+        Emitter::patch(rel, exitStub);
+        pendingLinks.emplace(pc, rel);
+    }
+
+    for (auto& l : block.outgoing) {
+        auto target = blocks.find(l.target);
+        if (target != blocks.end() && target != it) {
+            auto& incoming = target->second.incoming;
+            incoming.erase(std::remove(incoming.begin(), incoming.end(), l.rel), incoming.end());
+        }
+
+        auto range = pendingLinks.equal_range(l.target);
+        for (auto link = range.first; link != range.second; ++link) {
+            if (link->second == l.rel) {
+                pendingLinks.erase(link);
+                break;
+            }
+        }
+    }
+
+    if (block.inRam) unregisterBlock(pc, block.physStart, block.physEnd);
+
+    blocks.erase(it);
+}
+
+}  // namespace mips
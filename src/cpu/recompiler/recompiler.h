@@ -0,0 +1,121 @@
+#pragma once
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+#include "cpu/backend.h"
+#include "cpu/opcode.h"
+
+namespace mips {
+
+namespace x64 {
+class Emitter;
+}
+
+/**
+ * Dynamic recompiler translating R3000A basic blocks into x86-64 machine code.
+ *
+ * Simple ALU instructions are emitted natively, everything else (branches, coprocessors)
+ * calls back into the interpreter through CPU::executeOpcode, so exceptions and load delay
+ * slots behave exactly like in the interpreter.
+ * Blocks are chained directly while the next block fits in the time slice and no interrupt is pending.
+ * Generated code keeps System::cycles up to date before every call back into the interpreter,
+ * so devices synchronized from Scheduler::now() see the same time as with the interpreter.
+ * Guest registers are not cached in host registers, every instruction reads and writes them in CPU struct.
+ *
+ * With fastmem, aligned loads and stores access guest memory mirrored in host address space
+ * (System::fastmem) directly. I/O, scratchpad and pages with cached code are not mapped there,
+ * the first access to them faults and the host instruction is patched into a jump
+ * to an out of line path which interprets the instruction instead.
+ */
+class Recompiler : public Backend {
+   public:
+    // Returns false if the host can't run generated code
+    static bool isSupported();
+
+    Recompiler(CPU* cpu);
+    ~Recompiler() override;
+
+    bool execute(int count) override;
+    void flush() override;
+
+    // Called from SIGSEGV handler, redirects faulting fastmem access to its slow path
+    bool handleFault(uintptr_t& hostPc, const void* address);
+
+   private:
+    static const int MAX_BLOCK_LENGTH = 32;
+    static const size_t CODE_BUFFER_SIZE = 32 * 1024 * 1024;
+    static const size_t MAX_BLOCK_SIZE = 8 * 1024;
+
+    struct Link {
+        uint32_t target;
+        uint8_t* rel;
+    };
+
+    struct Block {
+        uint32_t pc;
+        uint32_t physStart;  // Offset into RAM, only valid for RAM blocks
+        uint32_t physEnd;
+        bool inRam;
+        int length;  // In instructions
+        const uint8_t* code;
+
+        std::vector<Link> outgoing;
+        std::vector<uint8_t*> incoming;
+    };
+
+    // Native memory access falling back to the interpreter
+    struct SlowPath {
+        std::vector<uint8_t*> jumps;      // rel32 fields jumping to the slow path
+        uint8_t* access = nullptr;        // Host instruction patched on fault
+        const uint8_t* resume = nullptr;  // Continuation after the whole guest instruction
+        Opcode opcode;
+        uint32_t address;
+        int count;   // Instructions executed before this one in the block
+        int synced;  // Instructions already added to System::cycles at this point
+        bool syncPC;
+    };
+
+    using EnterFunc = void (*)(CPU* cpu, Recompiler* rec, const uint8_t* code);
+
+    uint8_t* codeBuffer = nullptr;
+    size_t codeStart = 0;  // First byte after trampolines
+    size_t codeUsed = 0;
+    EnterFunc enter = nullptr;
+    const uint8_t* exitStub = nullptr;
+
+    uint64_t sliceEnd = 0;           // System::cycles at the end of current time slice
+    uint8_t* fastmemBase = nullptr;  // Loaded into r13 by the trampoline
+    uint32_t idleLoopEnd = 0;        // Set by blocks exiting on a backward branch which might close an idle loop
+
+    std::unordered_map<uint32_t, Block> blocks;
+    std::unordered_multimap<uint32_t, uint8_t*> pendingLinks;  // Jumps waiting for target block to be compiled
+    std::unordered_map<uint8_t*, const uint8_t*> slowPaths;  // Fastmem access -> its slow path
+
+    // Field offsets relative to CPU*
+    int32_t offsetPC;
+    int32_t offsetNextPC;
+    int32_t offsetInBranchDelay;
+    int32_t offsetBranchTaken;
+    int32_t offsetSlotReg;
+    int32_t offsetSlotData;
+    int32_t offsetReg;
+    int32_t offsetHi;
+    int32_t offsetLo;
+    int32_t offsetStatus;
+    int32_t offsetCause;
+
+    void emitTrampolines();
+    bool emitNative(x64::Emitter& e, Opcode i, bool loadPending);
+    bool emitFastmem(x64::Emitter& e, Opcode i, bool loadPending, SlowPath& slow);
+    void emitSlowPath(x64::Emitter& e, const SlowPath& slow);
+    void emitAddCycles(x64::Emitter& e, int cycles);
+    uint8_t* emitInterpreterCall(x64::Emitter& e, Opcode i, int count, int synced);
+    Block* getBlock(uint32_t pc);
+    Block* compile(uint32_t pc);
+    void link(Block& block, uint32_t target, uint8_t* rel);
+    void removeBlock(uint32_t pc) override;
+
+    static bool interpretOpcode(CPU* cpu, uint32_t opcode);
+};
+
+}  // namespace mips
@@ -0,0 +1,244 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+namespace mips::x64 {
+
+enum Reg : uint8_t { RAX, RCX, RDX, RBX, RSP, RBP, RSI, RDI, R8, R9, R10, R11, R12, R13, R14, R15 };
+
+// Condition codes as encoded in Jcc/SETcc opcodes
+enum class Cond : uint8_t { O, NO, B, AE, E, NE, BE, A, S, NS, P, NP, L, GE, LE, G };
+
+// Group 1 ALU operations, value is the /digit used by the 0x81 opcode
+enum class Alu : uint8_t { ADD = 0, OR = 1, AND = 4, SUB = 5, XOR = 6, CMP = 7 };
+
+// Group 2 shift operations, value is the /digit used by the 0xC1/0xD3 opcodes
+enum class Shift : uint8_t { SHL = 4, SHR = 5, SAR = 7 };
+
+// [base + index * scale + disp32] memory operand, RSP as index means no index
+struct Mem {
+    Reg base;
+    int32_t disp;
+    Reg index = RSP;
+    uint8_t scale = 4;
+};
+
+#ifdef _WIN32
+const Reg ARG0 = RCX;
+const Reg ARG1 = RDX;
+const Reg ARG2 = R8;
+#else
+const Reg ARG0 = RDI;
+const Reg ARG1 = RSI;
+const Reg ARG2 = RDX;
+#endif
+
+/**
+ * Minimal x86-64 machine code emitter.
+ * Only the instruction forms required by the recompiler are implemented,
+ * 32bit operand size is used unless the function name says otherwise.
+ */
+class Emitter {
+    uint8_t* code;
+    size_t capacity;
+    size_t pos = 0;
+
+    void emit8(uint8_t v) { code[pos++] = v; }
+    void emit32(uint32_t v) {
+        memcpy(code + pos, &v, sizeof(v));
+        pos += sizeof(v);
+    }
+    void emit64(uint64_t v) {
+        memcpy(code + pos, &v, sizeof(v));
+        pos += sizeof(v);
+    }
+
+    void rex(bool w, int reg, int rm, bool force = false, int index = 0) {
+        uint8_t r = 0x40 | (w << 3) | ((reg & 8) >> 1) | ((index & 8) >> 2) | ((rm & 8) >> 3);
+        if (r != 0x40 || force) emit8(r);
+    }
+
+    void modrm(int reg, Reg rm) { emit8(0xc0 | ((reg & 7) << 3) | (rm & 7)); }
+
+    void modrm(int reg, Mem m) {
+        if (m.index != RSP) {
+            uint8_t ss = m.scale == 8 ? 3 : m.scale == 4 ? 2 : m.scale == 2 ? 1 : 0;
+            emit8(0x80 | ((reg & 7) << 3) | RSP);
+            emit8((ss << 6) | ((m.index & 7) << 3) | (m.base & 7));
+        } else if ((m.base & 7) == RSP) {
+            emit8(0x80 | ((reg & 7) << 3) | RSP);
+            emit8(0x24);  // SIB required for rsp/r12 base
+        } else {
+            emit8(0x80 | ((reg & 7) << 3) | (m.base & 7));
+        }
+        emit32(m.disp);
+    }
+
+    template <typename Operand>
+    void op(bool w, uint8_t opcode, int reg, Operand rm) {
+        rex(w, reg, rmBase(rm), false, rmIndex(rm));
+        emit8(opcode);
+        modrm(reg, rm);
+    }
+
+    // Two byte (0x0f prefixed) opcode
+    void op2(uint8_t opcode, Reg reg, Mem rm) {
+        rex(false, reg, rm.base, false, rmIndex(rm));
+        emit8(0x0f);
+        emit8(opcode);
+        modrm(reg, rm);
+    }
+
+    static int rmBase(Reg r) { return r; }
+    static int rmBase(Mem m) { return m.base; }
+    static int rmIndex(Reg) { return 0; }
+    static int rmIndex(Mem m) { return m.index == RSP ? 0 : m.index; }
+
+   public:
+    // Longest instruction emitted by a single call
+    static const size_t MAX_INSTRUCTION_SIZE = 16;
+
+    Emitter(uint8_t* code, size_t capacity, size_t pos = 0) : code(code), capacity(capacity), pos(pos) {}
+
+    uint8_t* current() const { return code + pos; }
+    size_t offset() const { return pos; }
+    size_t remaining() const { return capacity - pos; }
+
+    // 32bit moves
+    void mov(Reg dst, Reg src) { op(false, 0x89, src, dst); }
+    void mov(Reg dst, Mem src) { op(false, 0x8b, dst, src); }
+    void mov(Mem dst, Reg src) { op(false, 0x89, src, dst); }
+    void mov(Reg dst, uint32_t imm) {
+        rex(false, 0, dst);
+        emit8(0xb8 + (dst & 7));
+        emit32(imm);
+    }
+    void mov(Mem dst, uint32_t imm) {
+        op(false, 0xc7, 0, dst);
+        emit32(imm);
+    }
+    void mov8(Mem dst, uint8_t imm) {
+        op(false, 0xc6, 0, dst);
+        emit8(imm);
+    }
+
+    // Narrow stores
+    void mov8(Mem dst, Reg src) {
+        rex(false, src, dst.base, src >= RSP, rmIndex(dst));
+        emit8(0x88);
+        modrm(src, dst);
+    }
+    void mov16(Mem dst, Reg src) {
+        emit8(0x66);
+        op(false, 0x89, src, dst);
+    }
+
+    // 64bit moves
+    void mov64(Reg dst, Reg src) { op(true, 0x89, src, dst); }
+    void mov64(Reg dst, Mem src) { op(true, 0x8b, dst, src); }
+    void mov64(Reg dst, uint64_t imm) {
+        rex(true, 0, dst);
+        emit8(0xb8 + (dst & 7));
+        emit64(imm);
+    }
+
+    void movzx8(Reg dst, Reg src) {
+        rex(false, dst, src, src >= RSP);
+        emit8(0x0f);
+        emit8(0xb6);
+        modrm(dst, src);
+    }
+
+    // Narrow loads extended to 32bit
+    void movzx8(Reg dst, Mem src) { op2(0xb6, dst, src); }
+    void movzx16(Reg dst, Mem src) { op2(0xb7, dst, src); }
+    void movsx8(Reg dst, Mem src) { op2(0xbe, dst, src); }
+    void movsx16(Reg dst, Mem src) { op2(0xbf, dst, src); }
+
+    // Arithmetic
+    void alu(Alu o, Reg dst, Reg src) { op(false, (static_cast<uint8_t>(o) << 3) | 1, src, dst); }
+    void alu(Alu o, Reg dst, Mem src) { op(false, (static_cast<uint8_t>(o) << 3) | 3, dst, src); }
+    void alu(Alu o, Reg dst, uint32_t imm) {
+        op(false, 0x81, static_cast<uint8_t>(o), dst);
+        emit32(imm);
+    }
+    void alu(Alu o, Mem dst, uint32_t imm) {
+        op(false, 0x81, static_cast<uint8_t>(o), dst);
+        emit32(imm);
+    }
+    void alu64(Alu o, Reg dst, Mem src) { op(true, (static_cast<uint8_t>(o) << 3) | 3, dst, src); }
+    void alu64(Alu o, Reg dst, uint32_t imm) {
+        op(true, 0x81, static_cast<uint8_t>(o), dst);
+        emit32(imm);
+    }
+    void alu64(Alu o, Mem dst, uint32_t imm) {
+        op(true, 0x81, static_cast<uint8_t>(o), dst);
+        emit32(imm);
+    }
+    void not_(Reg r) { op(false, 0xf7, 2, r); }
+    void test(Reg a, Reg b) { op(false, 0x85, b, a); }
+    void test(Reg r, uint32_t imm) {
+        op(false, 0xf7, 0, r);
+        emit32(imm);
+    }
+    void test64(Reg a, Reg b) { op(true, 0x85, b, a); }
+    void test(Mem m, uint32_t imm) {
+        op(false, 0xf7, 0, m);
+        emit32(imm);
+    }
+
+    void shift(Shift o, Reg r, uint8_t imm) {
+        op(false, 0xc1, static_cast<uint8_t>(o), r);
+        emit8(imm);
+    }
+    // Shift by cl, count is masked to 5 bits by the hardware
+    void shiftCl(Shift o, Reg r) { op(false, 0xd3, static_cast<uint8_t>(o), r); }
+
+    void setcc(Cond c, Reg r) {
+        rex(false, 0, r, r >= RSP);
+        emit8(0x0f);
+        emit8(0x90 | static_cast<uint8_t>(c));
+        modrm(0, r);
+    }
+
+    // Stack and control flow
+    void push(Reg r) {
+        rex(false, 0, r);
+        emit8(0x50 + (r & 7));
+    }
+    void pop(Reg r) {
+        rex(false, 0, r);
+        emit8(0x58 + (r & 7));
+    }
+    void call(Reg r) { op(false, 0xff, 2, r); }
+    void jmp(Reg r) { op(false, 0xff, 4, r); }
+    void jmp(Mem m) { op(false, 0xff, 4, m); }
+    void ret() { emit8(0xc3); }
+
+    // Relative jumps return pointer to rel32 field, so it can be patched later
+    uint8_t* jmp(const uint8_t* target = nullptr) {
+        emit8(0xe9);
+        return rel32(target);
+    }
+    uint8_t* jcc(Cond c, const uint8_t* target = nullptr) {
+        emit8(0x0f);
+        emit8(0x80 | static_cast<uint8_t>(c));
+        return rel32(target);
+    }
+
+    static void patch(uint8_t* rel, const uint8_t* target) {
+        int32_t offset = static_cast<int32_t>(target - (rel + 4));
+        memcpy(rel, &offset, sizeof(offset));
+    }
+
+   private:
+    uint8_t* rel32(const uint8_t* target) {
+        uint8_t* at = current();
+        emit32(0);
+        if (target != nullptr) patch(at, target);
+        return at;
+    }
+};
+
+}  // namespace mips::x64
@@ -1,6 +1,8 @@
 #include "cdrom.h"
 #include <fmt/core.h>
+#include <algorithm>
 #include <cassert>
+#include <climits>
 #include <disc/track.h>
 #include "config.h"
 #include "disc/empty.h"
@@ -13,8 +15,9 @@ namespace device {
 namespace cdrom {
 
 CDROM::CDROM(System* sys) : sys(sys) {
-    verbose = config.debug.log.cdrom;
+    verbose = sys->config.debug.log.cdrom;
     disc = std::make_unique<disc::Empty>();
+    lastSync = sys->scheduler.now();
 }
 
 void CDROM::handleSector() {
@@ -148,7 +151,7 @@ void CDROM::handleSector() {
             }
 
             if (this->mode.xaEnabled && !this->mute) {
-                auto frame = ADPCM::decodeXA(rawSector.data() + 24, codinginfo);
+                auto frame = ADPCM::decodeXA(rawSector.data() + 24, codinginfo, xaDecoder);
 
                 for (auto sample : frame) {
                     audio.push_back(mixSample(sample));
@@ -169,14 +172,6 @@ void CDROM::handleSector() {
 void CDROM::step(int cycles) {
     if (!interruptQueue.is_empty()) {
         interruptQueue.ref().delay -= cycles;
-
-        if (interruptQueue.peek().delay <= 0) {
-            status.transmissionBusy = 0;
-
-            if ((interruptEnable & 7) & (interruptQueue.peek().irq & 7)) {
-                sys->interrupt->trigger(interrupt::CDROM);
-            }
-        }
     }
 
     busyFor -= cycles;
@@ -184,14 +179,63 @@ void CDROM::step(int cycles) {
         status.transmissionBusy = 0;
     }
 
-    const int sectorsPerSecond = mode.speed ? 150 : 75;
-    const int cyclesPerSector = timing::CPU_CLOCK / sectorsPerSecond;
-
     readcnt += cycles;
-    for (int i = 0; i < readcnt / cyclesPerSector; i++) {
+    for (int i = 0; i < readcnt / cyclesPerSector(); i++) {
         handleSector();
     }
-    readcnt %= cyclesPerSector;
+    readcnt %= cyclesPerSector();
+
+    // Sector might have queued response without delay
+    if (!interruptQueue.is_empty() && interruptQueue.peek().delay <= 0) {
+        status.transmissionBusy = 0;
+
+        if ((interruptEnable & 7) & (interruptQueue.peek().irq & 7)) {
+            sys->interrupt->trigger(interrupt::CDROM);
+        }
+    }
+}
+
+int CDROM::cyclesPerSector() const {
+    const int sectorsPerSecond = mode.speed ? 150 : 75;
+    return timing::CPU_CLOCK / sectorsPerSecond;
+}
+
+// Drive is clocked at 2/3 of the system clock
+void CDROM::sync() {
+    uint64_t now = sys->scheduler.now();
+    // Nothing is pending when no event was scheduled for a long time, only the sector phase is lost
+    step(static_cast<int>(std::min<uint64_t>((now - lastSync) * 2 / 3, timing::CPU_CLOCK)));
+    lastSync = now;
+}
+
+void CDROM::scheduleEvent() {
+    int cycles = INT_MAX;
+    if (!interruptQueue.is_empty() && interruptQueue.peek().delay > 0) cycles = interruptQueue.peek().delay;
+    if (busyFor >= 0) cycles = std::min(cycles, busyFor + 1);
+    if (stat.read || stat.play) cycles = std::min(cycles, cyclesPerSector() - readcnt);
+
+    if (cycles == INT_MAX) {
+        sys->scheduler.cancel(Scheduler::Event::cdrom);
+        return;
+    }
+    sys->scheduler.schedule(Scheduler::Event::cdrom, lastSync + (static_cast<uint64_t>(cycles) * 3 + 1) / 2);
+}
+
+// Register access might enable interrupt or move another response to the front of the queue,
+// step(0) raises it without waiting for the next event
+uint8_t CDROM::read(uint32_t address) {
+    sync();
+    uint8_t data = readRegister(address);
+    step(0);
+    scheduleEvent();
+    return data;
+}
+
+void CDROM::write(uint32_t address, uint8_t data) {
+    sync();
+    writeRegister(address, data);
+    step(0);
+    scheduleEvent();
 }
 
 void CDROM::writeResponse(uint8_t byte) {
@@ -206,7 +250,7 @@ void CDROM::writeResponse(uint8_t byte) {
     entry.response.add(byte);
 }
 
-uint8_t CDROM::read(uint32_t address) {
+uint8_t CDROM::readRegister(uint32_t address) {
     if (address == 0) {  // CD Status
         // status.transmissionBusy = !interruptQueue.empty();
         if (verbose == 2) fmt::print("CDROM: R STATUS: 0x{:02x}\n", status._reg);
@@ -359,7 +403,7 @@ void CDROM::handleCommand(uint8_t cmd) {
     status.xaFifoEmpty = 0;
 }
 
-void CDROM::write(uint32_t address, uint8_t data) {
+void CDROM::writeRegister(uint32_t address, uint8_t data) {
     if (address == 0) {
         if (verbose == 3) fmt::print("CDROM: W INDEX: 0x{:02x}\n", data);
         status.index = data & 3;
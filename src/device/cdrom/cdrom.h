@@ -4,6 +4,7 @@
 #include <memory>
 #include "disc/disc.h"
 #include "fifo.h"
+#include "sound/adpcm.h"
 
 struct System;
 
@@ -136,6 +137,8 @@ class CDROM {
     AudioStatus audioStatus = AudioStatus::Stop;
 
     int scexCounter = 0;
+    uint64_t lastSync = 0;
+    ADPCM::XADecoder xaDecoder;
 
     void cmdGetstat();
     void cmdSetloc();
@@ -181,6 +184,9 @@ class CDROM {
     std::pair<int16_t, int16_t> mixSample(std::pair<int16_t, int16_t> sample);
 
     void handleSector();
+    int cyclesPerSector() const;
+    uint8_t readRegister(uint32_t address);
+    void writeRegister(uint32_t address, uint8_t data);
 
    public:
     std::deque<std::pair<int16_t, int16_t>> audio;
@@ -201,10 +207,15 @@ class CDROM {
 
     CDROM(System* sys);
     void step(int cycles);
+    // Steps the drive up to current time
+    void sync();
+    // Schedules event for the next pending interrupt or sector
+    void scheduleEvent();
     uint8_t read(uint32_t address);
     void write(uint32_t address, uint8_t data);
 
     void setShell(bool opened) {
+        sync();
         stat.setShell(opened);
 
         if (opened) {
@@ -214,6 +225,7 @@ class CDROM {
                 writeResponse(0x08);
             }
         }
+        scheduleEvent();
     }
     bool getShell() const { return stat.getShell(); }
     void ackMoreData() {
@@ -242,6 +254,7 @@ class CDROM {
         ar(dataBuffer);
         ar(dataBufferPointer);
         ar(readcnt);
+        ar(lastSync);
         ar(trackType);
         ar(lastQ);
         ar(mute);
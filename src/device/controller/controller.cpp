@@ -26,7 +26,7 @@ void Controller::handleByte(uint8_t byte) {
         rxData = controller[port]->handle(byte);
         ack = controller[port]->getAck();
         if (ack) {
-            irqTimer = 5;
+            sys->scheduler.schedule(Scheduler::Event::controller, sys->scheduler.now() + ACK_DELAY_CONTROLLER);
         }
         if (controller[port]->state == 0) deviceSelected = DeviceSelected::None;
     }
@@ -34,35 +34,35 @@ void Controller::handleByte(uint8_t byte) {
         rxData = card[port]->handle(byte);
         ack = card[port]->getAck();
         if (ack) {
-            irqTimer = 3;
+            sys->scheduler.schedule(Scheduler::Event::controller, sys->scheduler.now() + ACK_DELAY_MEMORY_CARD);
         }
         if (card[port]->state == 0) deviceSelected = DeviceSelected::None;
     }
 }
 
 Controller::Controller(System* sys) : sys(sys) {
-    busToken = bus.listen<Event::Config::Controller>([&](auto) { reload(); });
+    busToken = sys->bus.listen<Event::Config::Controller>([&](auto) { reload(); });
 
     reload();
 
     for (auto i = 0; i < (int)card.size(); i++) {
-        card[i] = std::make_unique<peripherals::MemoryCard>(i + 1);
+        card[i] = std::make_unique<peripherals::MemoryCard>(sys, i + 1);
     }
 }
 
-Controller::~Controller() { bus.unlistenAll(busToken); }
+Controller::~Controller() { sys->bus.unlistenAll(busToken); }
 void Controller::reload() {
-    auto createDevice = [](int num) -> std::unique_ptr<peripherals::AbstractDevice> {
+    auto createDevice = [this](int num) -> std::unique_ptr<peripherals::AbstractDevice> {
         num += 1;
-        ControllerType type = config.controller[num - 1].type;
+        ControllerType type = sys->config.controller[num - 1].type;
         if (type == ControllerType::digital) {
-            return std::make_unique<peripherals::DigitalController>(num);
+            return std::make_unique<peripherals::DigitalController>(sys, num);
         } else if (type == ControllerType::analog) {
-            return std::make_unique<peripherals::AnalogController>(num);
+            return std::make_unique<peripherals::AnalogController>(sys, num);
         } else if (type == ControllerType::mouse) {
-            return std::make_unique<peripherals::Mouse>(num);
+            return std::make_unique<peripherals::Mouse>(sys, num);
         } else {
-            return std::make_unique<peripherals::None>(num);
+            return std::make_unique<peripherals::None>(sys, num);
         }
     };
 
@@ -72,15 +72,9 @@ void Controller::reload() {
 }
 
 void Controller::step() {
-    if (irqTimer > 0) {
-        if (--irqTimer == 0) {
-            irq = true;
-            ack = false;
-        }
-    }
-    if (irq) {
-        sys->interrupt->trigger(interrupt::CONTROLLER);
-    }
+    irq = true;
+    ack = false;
+    sys->interrupt->trigger(interrupt::CONTROLLER);
 }
 
 uint8_t Controller::read(uint32_t address) {
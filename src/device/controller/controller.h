@@ -26,7 +26,10 @@ class Controller {
     Reg16 control;
     Reg16 baud;
     bool irq = false;
-    int irqTimer = 0;
+
+    // Delay between received byte and /ACK pulse raising the interrupt
+    static const int ACK_DELAY_CONTROLLER = 1500;
+    static const int ACK_DELAY_MEMORY_CARD = 900;
 
     void handleByte(uint8_t byte);
 
@@ -49,6 +52,7 @@ class Controller {
     Controller(System* sys);
     ~Controller();
     void reload();
+    // Called by the scheduler after /ACK delay elapsed
     void step();
     uint8_t read(uint32_t address);
     void write(uint32_t address, uint8_t data);
@@ -56,7 +60,7 @@ class Controller {
 
     template <class Archive>
     void serialize(Archive& ar) {
-        ar(deviceSelected, mode, control, baud, irq, irqTimer, rxData, rxPending, ack);
+        ar(deviceSelected, mode, control, baud, irq, rxData, rxPending, ack);
         // TODO: serialize controller && card state
     }
 };
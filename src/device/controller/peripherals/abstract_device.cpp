@@ -1,7 +1,7 @@
 #include "abstract_device.h"
 
 namespace peripherals {
-AbstractDevice::AbstractDevice(Type type, int port) : type(type), port(port) {}
+AbstractDevice::AbstractDevice(System* sys, Type type, int port) : sys(sys), type(type), port(port) {}
 
 AbstractDevice::~AbstractDevice() {}
 
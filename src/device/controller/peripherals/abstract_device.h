@@ -1,14 +1,17 @@
 #pragma once
 #include "device/device.h"
 
+struct System;
+
 namespace peripherals {
 enum class Type { None, Digital, Analog, Mouse, MemoryCard };
 struct AbstractDevice {
+    System* sys;
     Type type;
     int port;  // Physical port number (numbered from 1..n)
     int state = 0;
 
-    AbstractDevice(Type type, int port);
+    AbstractDevice(System* sys, Type type, int port);
     bool getAck();
     void resetState();
 
@@ -1,11 +1,11 @@
 #include "analog_controller.h"
 #include <fmt/core.h>
 #include <magic_enum.hpp>
-#include "config.h"
 #include "input/input_manager.h"
+#include "system.h"
 
 namespace peripherals {
-AnalogController::AnalogController(int port) : DigitalController(Type::Analog, port) {}
+AnalogController::AnalogController(System* sys, int port) : DigitalController(sys, Type::Analog, port) {}
 
 uint8_t AnalogController::_handle(uint8_t byte) {
     if (state == 0) command = Command::None;
@@ -115,7 +115,7 @@ uint8_t AnalogController::handleReadAnalog(uint8_t byte) {
             state = 0;
             // Do not send vibration events on continuous 0 values
             if (vibration != prevVibration || vibration != 0) {
-                bus.notify(Event::Controller::Vibration{port, vibration.small, vibration.big});
+                sys->bus.notify(Event::Controller::Vibration{port, vibration.small, vibration.big});
             }
             prevVibration = vibration;
             return left.y;
@@ -158,7 +158,6 @@ uint8_t AnalogController::handleExitConfiguration(uint8_t byte) {
 }
 
 uint8_t AnalogController::handleSetLed(uint8_t byte) {
-    static uint8_t param;
     switch (state) {
         case 2: state++; return 0x5a;
         case 3:
@@ -196,31 +195,30 @@ uint8_t AnalogController::handleLedStatus(uint8_t byte) {
 }
 
 uint8_t AnalogController::handleUnlockRumble(uint8_t byte) {
-    static uint8_t a, b, c, d, e, f;
     switch (state) {
         case 2: state++; return 0x5a;
         case 3:
-            a = byte;
+            rumbleConfig[0] = byte;
             state++;
             return 0;
         case 4:
-            b = byte;
+            rumbleConfig[1] = byte;
             state++;
             return 0;
         case 5:
-            c = byte;
+            rumbleConfig[2] = byte;
             state++;
             return 0;
         case 6:
-            d = byte;
+            rumbleConfig[3] = byte;
             state++;
             return 0;
         case 7:
-            e = byte;
+            rumbleConfig[4] = byte;
             state++;
             return 0;
         case 8:
-            f = byte;
+            rumbleConfig[5] = byte;
             state = 0;
             // Note: 40 Winks does not use Unlock rumble command
             // It enables analog mode using 0x4c command
@@ -232,7 +230,6 @@ uint8_t AnalogController::handleUnlockRumble(uint8_t byte) {
 }
 
 uint8_t AnalogController::handleUnknown46(uint8_t byte) {
-    static uint8_t param;
     switch (state) {
         case 2: state++; return 0x5a;
         case 3:
@@ -286,8 +283,6 @@ void AnalogController::update() {
     auto inputManager = InputManager::getInstance();
     if (inputManager == nullptr) return;
 
-    static bool analogPressed = false;
-
     if (inputManager->getDigital(path + "analog")) {
         if (!analogPressed) {
             analogPressed = true;
@@ -1,4 +1,5 @@
 #pragma once
+#include <array>
 #include "digital_controller.h"
 
 namespace peripherals {
@@ -56,9 +57,12 @@ struct AnalogController : public DigitalController {
     bool ledEnabled = false;
     bool configurationMode = false;
     Vibration prevVibration, vibration;
+    uint8_t param = 0;                      // First parameter of SetLed and Unknown46 commands
+    std::array<uint8_t, 6> rumbleConfig{};  // Motor mapping from UnlockRumble command
+    bool analogPressed = false;
 
    public:
-    AnalogController(int Port);
+    AnalogController(System* sys, int port);
     uint8_t handle(uint8_t byte) override;
     void update() override;
 };
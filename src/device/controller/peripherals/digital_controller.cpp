@@ -1,7 +1,7 @@
 #include "digital_controller.h"
 #include <fmt/core.h>
-#include "config.h"
 #include "input/input_manager.h"
+#include "system.h"
 
 namespace peripherals {
 void DigitalController::ButtonState::setByName(const std::string& name, bool value) {
@@ -27,10 +27,10 @@ void DigitalController::ButtonState::setByName(const std::string& name, bool val
 #undef BUTTON
 }
 
-DigitalController::DigitalController(Type type, int port)
-    : AbstractDevice(type, port), verbose(config.debug.log.controller), path(fmt::format("controller/{}/", port)) {}
+DigitalController::DigitalController(System* sys, Type type, int port)
+    : AbstractDevice(sys, type, port), verbose(sys->config.debug.log.controller), path(fmt::format("controller/{}/", port)) {}
 
-DigitalController::DigitalController(int port) : DigitalController(Type::Digital, port) {}
+DigitalController::DigitalController(System* sys, int port) : DigitalController(sys, Type::Digital, port) {}
 
 uint8_t DigitalController::_handle(uint8_t byte) {
     switch (state) {
@@ -1,10 +1,12 @@
 #include "memory_card.h"
 #include <fmt/core.h>
-#include "config.h"
+#include "system.h"
 
 namespace peripherals {
 
-MemoryCard::MemoryCard(int port) : AbstractDevice(Type::MemoryCard, port) { verbose = config.debug.log.memoryCard; }
+MemoryCard::MemoryCard(System* sys, int port) : AbstractDevice(sys, Type::MemoryCard, port) {
+    verbose = sys->config.debug.log.memoryCard;
+}
 
 uint8_t MemoryCard::handle(uint8_t byte) {
     if (state == 0) command = Command::None;
@@ -150,7 +152,7 @@ uint8_t MemoryCard::handleWrite(uint8_t byte) {
             state = 0;
             command = Command::None;
 
-            bus.notify(Event::Controller::MemoryCardContentsChanged{port - 1});
+            sys->bus.notify(Event::Controller::MemoryCardContentsChanged{port - 1});
 
             return static_cast<uint8_t>(writeStatus);
 
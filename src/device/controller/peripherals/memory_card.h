@@ -36,7 +36,7 @@ struct MemoryCard : public AbstractDevice {
     bool inserted = true;
     bool dirty = false;
 
-    MemoryCard(int port);
+    MemoryCard(System* sys, int port);
     uint8_t handle(uint8_t byte) override;
 
     void setFresh() { flag.fresh = true; }
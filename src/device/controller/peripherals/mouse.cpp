@@ -5,7 +5,7 @@
 #include "utils/math.h"
 
 namespace peripherals {
-Mouse::Mouse(int port) : AbstractDevice(Type::Mouse, port), path(fmt::format("controller/{}/", port)) {}
+Mouse::Mouse(System* sys, int port) : AbstractDevice(sys, Type::Mouse, port), path(fmt::format("controller/{}/", port)) {}
 
 uint8_t Mouse::handle(uint8_t byte) {
     switch (state) {
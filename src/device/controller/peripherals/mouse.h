@@ -10,7 +10,7 @@ class Mouse : public AbstractDevice {
     int8_t x = 0, y = 0;
 
    public:
-    Mouse(int port);
+    Mouse(System* sys, int port);
     uint8_t handle(uint8_t byte) override;
     void update() override;
 };
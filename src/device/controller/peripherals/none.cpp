@@ -1,7 +1,7 @@
 #include "none.h"
 
 namespace peripherals {
-None::None(int port) : AbstractDevice(Type::None, port) {}
+None::None(System* sys, int port) : AbstractDevice(sys, Type::None, port) {}
 
 uint8_t None::handle(uint8_t byte) {
     (void)byte;
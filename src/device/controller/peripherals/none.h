@@ -5,7 +5,7 @@
 
 namespace peripherals {
 struct None : public AbstractDevice {
-    None(int port);
+    None(System* sys, int port);
     uint8_t handle(uint8_t byte) override;
 };
 };  // namespace peripherals
\ No newline at end of file
@@ -28,6 +28,7 @@ void DMA::reset() {
 }
 
 void DMA::step() {
+    bool pending = false;
     for (int channel = 0; channel < 7; channel++) {
         dma[channel]->step();
         if (dma[channel]->irqFlag) {
@@ -37,6 +38,12 @@ void DMA::step() {
                 pendingInterrupt = status.calcMasterFlag();
             }
         }
+        pending |= dma[channel]->isPending();
+    }
+
+    // Device request lines (MDEC, CD-ROM) are polled, chopped transfers move one block per step
+    if (pending) {
+        sys->scheduler.schedule(Scheduler::Event::dma, sys->scheduler.now() + STEP_INTERVAL);
     }
 
     if (pendingInterrupt) {
@@ -61,6 +68,9 @@ uint8_t DMA::read(uint32_t address) {
 }
 
 void DMA::write(uint32_t address, uint8_t data) {
+    // Started transfers and interrupts are handled in step()
+    sys->scheduler.schedule(Scheduler::Event::dma, sys->scheduler.now());
+
     int channel = address / 0x10;
     if (channel > 6)  // control
     {
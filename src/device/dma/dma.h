@@ -102,6 +102,9 @@ class DMA {
 
     System* sys;
 
+    // Pending transfers are stepped with the granularity of the former fixed time slices
+    static const int STEP_INTERVAL = 300;
+
    public:
     DMA(System* sys);
     void reset();
@@ -7,4 +7,6 @@ DMA2Channel::DMA2Channel(Channel channel, System *sys, gpu::GPU *gpu) : DMAChann
 uint32_t DMA2Channel::readDevice() { return gpu->read(0); }
 
 void DMA2Channel::writeDevice(uint32_t data) { gpu->write(0, data); }
+
+void DMA2Channel::writeDeviceBlock(const uint32_t *data, size_t count) { gpu->writeGP0Block(data, count); }
 }  // namespace device::dma
\ No newline at end of file
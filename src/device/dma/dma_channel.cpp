@@ -1,12 +1,11 @@
 #include "dma_channel.h"
 #include <fmt/core.h>
 #include <magic_enum.hpp>
-#include "config.h"
 #include "system.h"
-#include <unordered_set>
+#include "utils/address.h"
 
 namespace device::dma {
-DMAChannel::DMAChannel(Channel channel, System* sys) : channel(channel), sys(sys) { verbose = config.debug.log.dma; }
+DMAChannel::DMAChannel(Channel channel, System* sys) : channel(channel), sys(sys) { verbose = sys->config.debug.log.dma; }
 
 DMAChannel::~DMAChannel() {}
 
@@ -14,13 +13,45 @@ uint32_t DMAChannel::readDevice() { return 0; }
 
 void DMAChannel::writeDevice(uint32_t data) { (void)data; }
 
+void DMAChannel::writeDeviceBlock(const uint32_t* data, size_t count) {
+    for (size_t i = 0; i < count; i++) {
+        writeDevice(data[i]);
+    }
+}
+
+uint32_t DMAChannel::writeDeviceFromRam(uint32_t addr, size_t wordCount) {
+    if (control.memoryAddressStep == CHCR::MemoryAddressStep::backward) {
+        for (size_t i = 0; i < wordCount; i++, addr += control.step()) {
+            writeDevice(sys->readMemory32(addr));
+        }
+        return addr;
+    }
+
+    // Forward transfers are split at page boundaries, directly accessible pages are passed to the device in one block
+    while (wordCount > 0) {
+        uint32_t physical = align_mips<uint32_t>(addr);
+        uint32_t offset = physical & (System::PAGE_SIZE - 1);
+        size_t n = std::min<size_t>(wordCount, (System::PAGE_SIZE - offset) / 4);
+
+        if (uint8_t* page = sys->readPages[physical >> System::PAGE_BITS]) {
+            writeDeviceBlock(reinterpret_cast<const uint32_t*>(page + offset), n);
+        } else {
+            for (size_t i = 0; i < n; i++) {
+                writeDevice(sys->readMemory32(addr + i * 4));
+            }
+        }
+        addr += n * 4;
+        wordCount -= n;
+    }
+    return addr;
+}
+
 uint8_t DMAChannel::read(uint32_t address) {
     if (address < 0x4) return baseAddress._byte[address];
     if (address >= 0x4 && address < 0x8) return count._byte[address - 4];
     if (address >= 0x8 && address < 0xc) return control._byte[address - 8];
     return 0;
 }
-static bool canLog = true;
 void DMAChannel::write(uint32_t address, uint8_t data) {
     if (address < 0x4) {
         baseAddress._byte[address] = data;
@@ -54,6 +85,12 @@ void DMAChannel::step() {
     }
 }
 
+bool DMAChannel::isPending() const {
+    if (!sys->dma->isChannelEnabled(channel)) return false;
+    if (control.enabled != CHCR::Enabled::start) return false;
+    return !(control.syncMode == CHCR::SyncMode::block && control.startTrigger != CHCR::StartTrigger::manual);
+}
+
 void DMAChannel::maskControl() { control._reg &= ~CHCR::MASK; }
 
 // Sync 0 - no cpu execution in between
@@ -73,9 +110,7 @@ void DMAChannel::burstTransfer() {
             sys->writeMemory32(addr, readDevice());
         }
     } else if (control.direction == CHCR::Direction::fromRam) {
-        for (size_t i = 0; i < wordCount; i++, addr += control.step()) {
-            writeDevice(sys->readMemory32(addr));
-        }
+        writeDeviceFromRam(addr, wordCount);
     }
 
     irqFlag = true;
@@ -103,9 +138,7 @@ hack_transferLoop:
             sys->writeMemory32(addr, readDevice());
         }
     } else if (control.direction == CHCR::Direction::fromRam) {
-        for (int i = 0; i < count.syncMode1.blockSize; i++, addr += control.step()) {
-            writeDevice(sys->readMemory32(addr));
-        }
+        addr = writeDeviceFromRam(addr, count.syncMode1.blockSize);
     }
     // TODO: Need proper Chopping implementation for SPU READ to work
 
@@ -129,7 +162,9 @@ void DMAChannel::linkedListTransfer() {
     }
 
     // TODO: Break execution in between
-    std::unordered_set<uint32_t> visited;
+    if (visitedNodes.empty()) visitedNodes.resize(VISITED_NODES_SIZE);
+    const uint32_t start = addr;
+
     for (;;) {
         uint32_t blockInfo = sys->readMemory32(addr);
         int commandCount = blockInfo >> 24;
@@ -140,19 +175,23 @@ void DMAChannel::linkedListTransfer() {
                        control.dir(), addr, magic_enum::enum_name(control.syncMode), commandCount, nextAddr);
         }
 
-        addr += control.step();
-        for (int i = 0; i < commandCount; i++, addr += control.step()) {
-            writeDevice(sys->readMemory32(addr));
-        }
+        writeDeviceFromRam(addr + control.step(), commandCount);
 
         addr = nextAddr;
         if (addr == 0xffffff || addr == 0) break;
 
-        if (visited.find(addr) != visited.end()) {
+        if (visitedNode(addr)) {
             fmt::print("[DMA{}] GPU DMA transfer loop detected, breaking.\n", (int)channel);
             break;
         }
-        visited.insert(addr);
+        markNode(addr, true);
+    }
+
+    // RAM is not modified during the transfer, walking the list again visits exactly the marked nodes
+    for (uint32_t node = start;;) {
+        node = sys->readMemory32(node) & 0xffffff;
+        if (node == 0xffffff || node == 0 || !visitedNode(node)) break;
+        markNode(node, false);
     }
 
     baseAddress.address = addr;
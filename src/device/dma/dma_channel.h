@@ -1,4 +1,5 @@
 #pragma once
+#include <vector>
 #include "device/device.h"
 
 struct System;
@@ -81,6 +82,7 @@ union CHCR {
 class DMAChannel {
    protected:
     int verbose;
+    bool canLog = true;  // Only the first transfer after the channel is started is logged
     Channel channel;
 
     CHCR control;
@@ -89,10 +91,28 @@ class DMAChannel {
 
     System* sys;
 
+    // Linked list nodes reached during current transfer, one bit per word of 24bit address space
+    static const size_t VISITED_NODES_SIZE = (1 << 22) / 64;
+    std::vector<uint64_t> visitedNodes;
+
+    bool visitedNode(uint32_t addr) const { return visitedNodes[addr >> 8] & (1ull << ((addr >> 2) & 63)); }
+    void markNode(uint32_t addr, bool visited) {
+        if (visited) {
+            visitedNodes[addr >> 8] |= 1ull << ((addr >> 2) & 63);
+        } else {
+            visitedNodes[addr >> 8] &= ~(1ull << ((addr >> 2) & 63));
+        }
+    }
+
     virtual uint32_t readDevice();
     virtual void writeDevice(uint32_t data);
+    // Words read directly from RAM, devices accepting bulk data override it
+    virtual void writeDeviceBlock(const uint32_t* data, size_t count);
     virtual void maskControl();
 
+    // Returns address after the last transferred word
+    uint32_t writeDeviceFromRam(uint32_t addr, size_t wordCount);
+
     virtual void burstTransfer();
     void syncBlockTransfer();
     void linkedListTransfer();
@@ -109,6 +129,8 @@ class DMAChannel {
     uint8_t read(uint32_t address);
     void write(uint32_t address, uint8_t data);
     void step();
+    // Transfer was started and waits for the device request or continues with the next chopped block
+    bool isPending() const;
 
     template <class Archive>
     void serialize(Archive& ar) {
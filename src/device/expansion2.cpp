@@ -1,8 +1,8 @@
 #include "expansion2.h"
-#include "config.h"
 #include <cstdio>
+#include "system.h"
 
-Expansion2::Expansion2() { reset(); }
+Expansion2::Expansion2(System* sys) : sys(sys) { reset(); }
 
 void Expansion2::reset() { post = 0; }
 
@@ -17,7 +17,7 @@ void Expansion2::write(uint32_t address, uint8_t data) {
     if (address == 0x22) {  // DUART Command
         // Ignore (Enable Tx/Rx, reset/flush commands)
     } else if (address == 0x23) {  // DUART Tx
-        if (config.debug.log.system) {
+        if (sys->config.debug.log.system) {
             putchar(data);
         }
     } else if (address == 0x24) {  // DUART Aux Control
@@ -25,7 +25,7 @@ void Expansion2::write(uint32_t address, uint8_t data) {
     } else if (address == 0x41) {
         post = data;
     } else if (address == 0x80) {  // PCSX-Redux/Openbios stdout channel
-        if (config.debug.log.system) {
+        if (sys->config.debug.log.system) {
             putchar(data);
         }
     }
@@ -1,12 +1,15 @@
 #pragma once
 #include "device.h"
 
+struct System;
+
 class Expansion2 {
     static const uint32_t BASE_ADDRESS = 0x1F802000;
+    System* sys;
     uint8_t post;
 
    public:
-    Expansion2();
+    Expansion2(System* sys);
     void reset();
     uint8_t read(uint32_t address);
     void write(uint32_t address, uint8_t data);
@@ -1,8 +1,12 @@
 #include "gpu.h"
 #include <fmt/core.h>
+#include <algorithm>
 #include <cassert>
+#include <cstring>
 #include "config.h"
+#include "render/banded_renderer.h"
 #include "render/render.h"
+#include "render/span.h"
 #include "system.h"
 #include "utils/file.h"
 #include "utils/logic.h"
@@ -14,19 +18,30 @@
 
 namespace gpu {
 GPU::GPU(System* sys) : sys(sys) {
-    busToken = bus.listen<Event::Config::Graphics>([&](auto) { reload(); });
+    busToken = sys->bus.listen<Event::Config::Graphics>([&](auto) { reload(); });
     reload();
     reset();
 }
 
-GPU::~GPU() { bus.unlistenAll(busToken); }
+GPU::~GPU() { sys->bus.unlistenAll(busToken); }
 
 void GPU::reload() {
-    verbose = config.debug.log.gpu;
-    forceNtsc = config.options.graphics.forceNtsc;
-    auto mode = config.options.graphics.renderingMode;
+    verbose = sys->config.debug.log.gpu;
+    forceNtsc = sys->config.options.graphics.forceNtsc;
+    auto mode = sys->config.options.graphics.renderingMode;
     softwareRendering = (mode & RenderingMode::software) != 0;
     hardwareRendering = (mode & RenderingMode::hardware) != 0;
+
+    int threads = softwareRendering ? sys->config.options.graphics.renderingThreads : 0;
+    if (bandedRenderer && bandedRenderer->threadCount() != threads) {
+        flushRendering();
+        clutCache = bandedRenderer->clutCache();
+        bandedRenderer.reset();
+        textureCache.invalidate();  // Workers were drawing without it
+    }
+    if (!bandedRenderer && threads > 0) {
+        bandedRenderer = std::make_unique<BandedRenderer>(vram.data(), threads, clutCache);
+    }
 }
 
 void GPU::reset() {
@@ -51,7 +66,9 @@ void GPU::reset() {
 
     gp0_e6._reg = 0;
 
-    clutCachePos = ivec2(-1, -1);
+    clutCache.invalidate();
+    if (bandedRenderer) bandedRenderer->invalidateClut();
+    invalidateTextureCache();
 }
 
 void GPU::drawTriangle(const primitive::Triangle& triangle) {
@@ -82,7 +99,11 @@ void GPU::drawTriangle(const primitive::Triangle& triangle) {
     }
 
     if (softwareRendering) {
-        Render::drawTriangle(this, triangle);
+        if (bandedRenderer) {
+            bandedRenderer->drawTriangle(renderContext(), triangle);
+        } else {
+            Render::drawTriangle(this, triangle);
+        }
     }
 }
 
@@ -127,7 +148,11 @@ void GPU::drawLine(const primitive::Line& line) {
     }
 
     if (softwareRendering) {
-        Render::drawLine(this, line);
+        if (bandedRenderer) {
+            bandedRenderer->drawLine(renderContext(), line);
+        } else {
+            Render::drawLine(this, line);
+        }
     }
 }
 
@@ -189,7 +214,11 @@ void GPU::drawRectangle(const primitive::Rect& rect) {
     }
 
     if (softwareRendering) {
-        Render::drawRectangle(this, rect);
+        if (bandedRenderer) {
+            bandedRenderer->drawRectangle(renderContext(), rect);
+        } else {
+            Render::drawRectangle(this, rect);
+        }
     }
 }
 
@@ -209,10 +238,15 @@ void GPU::cmdFillRectangle() {
     uint32_t color = to15bit(arguments[0] & 0xffffff);
 
     // Note: not sure if coords should include last column and row
-    for (int y = startY; y < endY; y++) {
-        for (int x = startX; x < endX; x++) {
-            VRAM[y][x] = color;
+    if (bandedRenderer) {
+        bandedRenderer->fill(renderContext(), startX, startY, endX - startX, endY - startY, color);
+    } else {
+        const int skipField = displayedFieldSkipped();
+        for (int y = startY; y < endY; y++) {
+            if ((y & 1) == skipField) continue;
+            fillSpan(&VRAM[y][startX], endX - startX, color);
         }
+        textureCache.markDirty(startX, startY, endX - startX, endY - startY);
     }
 
     cmd = Command::None;
@@ -432,6 +466,10 @@ void GPU::cmdCpuToVram1() {
     cmd = Command::CopyCpuToVram2;
     argumentCount = 1;
     currentArgument = 0;
+
+    uploadData.clear();
+    // Banded renderer workers mark the region when upload is executed
+    if (!bandedRenderer) textureCache.markDirty(startX, startY, endX - startX, endY - startY);
 }
 
 void GPU::maskedWrite(int x, int y, uint16_t value) {
@@ -452,22 +490,86 @@ void GPU::cmdCpuToVram2() {
             currX = startX;
             if (++currY >= endY) {
                 cmd = Command::None;
+                submitUpload();
                 return true;
             }
         }
         return false;
     };
 
+    // Banded renderer applies collected data when transfer ends, keeping it ordered with queued primitives
+    const auto write = [&](uint16_t data) {
+        if (bandedRenderer) {
+            uploadData.push_back(data);
+        } else {
+            maskedWrite(currX, currY, data);
+        }
+    };
+
     uint32_t value = arguments[0];
     currentArgument = 0;
 
-    maskedWrite(currX, currY, value & 0xffff);
+    write(value & 0xffff);
     if (advanceOrBreak()) return;
 
-    maskedWrite(currX, currY, (value >> 16) & 0xffff);
+    write((value >> 16) & 0xffff);
     if (advanceOrBreak()) return;
 }
 
+void GPU::submitUpload() {
+    if (!bandedRenderer || uploadData.empty()) return;
+
+    int w = endX - startX;
+    int h = endY - startY;
+    int offset = std::min((currY - startY) * w + (currX - startX), w * h) - (int)uploadData.size();
+    bandedRenderer->upload(renderContext(), startX, startY, w, h, offset, std::move(uploadData));
+    uploadData.clear();
+}
+
+size_t GPU::writeVramData(const uint32_t* data, size_t count) {
+    // Halfwords are consumed in the same order as by cmdCpuToVram2, odd pixel count drops upper half of the last word
+    const auto src = reinterpret_cast<const uint16_t*>(data);
+    const size_t remaining = (size_t)(endY - currY) * (endX - startX) - (currX - startX);
+    const size_t pixels = std::min(count * 2, remaining);
+    const uint16_t mask = gp0_e6.setMaskWhileDrawing << 15;
+
+    if (bandedRenderer) {
+        uploadData.insert(uploadData.end(), src, src + pixels);
+    }
+
+    for (size_t i = 0; i < pixels;) {
+        int y = currY % VRAM_HEIGHT;
+        int x = currX % VRAM_WIDTH;
+        // Run ends with the transfer row or at the VRAM edge where it wraps around
+        int n = (int)std::min<size_t>({(size_t)(endX - currX), (size_t)(VRAM_WIDTH - x), pixels - i});
+
+        if (!bandedRenderer) {
+            uint16_t* dst = &VRAM[y][x];
+            if (gp0_e6.checkMaskBeforeDraw) {
+                for (int j = 0; j < n; j++) maskedWrite(x + j, y, src[i + j]);
+            } else if (mask) {
+                for (int j = 0; j < n; j++) dst[j] = src[i + j] | mask;
+            } else {
+                std::memcpy(dst, &src[i], n * sizeof(uint16_t));
+            }
+        }
+
+        i += n;
+        if ((currX += n) >= endX) {
+            currX = startX;
+            currY++;
+        }
+    }
+
+    size_t words = (pixels + 1) / 2;
+    if (words > 0) arguments[0] = data[words - 1];
+    if (pixels == remaining) {
+        cmd = Command::None;
+        submitUpload();
+    }
+    return words;
+}
+
 void GPU::cmdVramToCpu() {
     readMode = ReadMode::Vram;
     startX = currX = MaskCopy::x(arguments[1] & 0xffff);
@@ -479,6 +581,8 @@ void GPU::cmdVramToCpu() {
 }
 
 uint32_t GPU::readVramData() {
+    flushRendering();
+
     const auto advanceOrBreak = [&]() {
         if (++currX >= endX) {
             currX = startX;
@@ -500,6 +604,7 @@ uint32_t GPU::readVramData() {
 
 void GPU::cmdVramToVram() {
     cmd = Command::None;
+    flushRendering();
 
     int srcX = MaskCopy::x(arguments[1] & 0xffff);
     int srcY = MaskCopy::y((arguments[1] & 0xffff0000) >> 16);
@@ -515,6 +620,27 @@ void GPU::cmdVramToVram() {
     // See gpu/vram-to-vram-overlap test
     bool dir = srcX < dstX;
 
+    // Copy is done on this thread, banded renderer workers have their own decoded textures
+    if (bandedRenderer) {
+        bandedRenderer->invalidateTextures(dstX, dstY, w, h);
+    } else {
+        textureCache.markDirty(dstX, dstY, w, h);
+    }
+
+    // Rows are copied top-to-bottom, memmove handles overlap in the same row just like the direction above
+    bool wraps = srcX + w > VRAM_WIDTH || dstX + w > VRAM_WIDTH || srcY + h > VRAM_HEIGHT || dstY + h > VRAM_HEIGHT;
+    if (!wraps && !gp0_e6.checkMaskBeforeDraw) {
+        const uint16_t mask = gp0_e6.setMaskWhileDrawing << 15;
+        for (int y = 0; y < h; y++) {
+            uint16_t* dst = &VRAM[dstY + y][dstX];
+            std::memmove(dst, &VRAM[srcY + y][srcX], w * sizeof(uint16_t));
+            if (mask) {
+                for (int x = 0; x < w; x++) dst[x] |= mask;
+            }
+        }
+        return;
+    }
+
     for (int y = 0; y < h; y++) {
         for (int _x = 0; _x < w; _x++) {
             int x = (!dir) ? _x : w - 1 - _x;
@@ -600,7 +726,8 @@ void GPU::writeGP0(uint32_t data) {
             }
         } else if (command == 0x01) {
             // Clear Cache
-            clutCachePos = ivec2(-1, -1);
+            clutCache.invalidate();
+            if (bandedRenderer) bandedRenderer->invalidateClut();
         } else if (command == 0x02) {
             // Fill rectangle
             cmd = Command::FillRectangle;
@@ -662,7 +789,7 @@ void GPU::writeGP0(uint32_t data) {
         }
 
         if (gpuLogEnabled && cmd == Command::None) {
-            gpuLogList.push_back(LogEntry::GP0(arguments[0]));
+            gpuLogList.gp0(arguments[0]);
         }
         // TODO: Refactor gpu log to handle copies && multiline
 
@@ -684,29 +811,77 @@ void GPU::writeGP0(uint32_t data) {
         }
     }
 
+    dispatchCommand();
+}
+
+void GPU::dispatchCommand() {
     if (gpuLogEnabled) {
         if (cmd == Command::CopyCpuToVram2) {
-            // Find last gp0(0xa0) command
-            int n = 5;
-            for (int i = gpuLogList.size() - 1; i >= 0; i--) {
-                auto& last = gpuLogList[i];
-                if (last.cmd() == 0xa0) {
-                    last.args.push_back(arguments[0]);
-                    break;
-                }
-                if (n-- == 0) break;
-            }
+            logCpuToVram(&arguments[0], 1);
         } else {
-            LogEntry entry;
-            entry.type = 0;
-            entry.args = std::vector<uint32_t>(arguments.begin(), arguments.begin() + argumentCount);
-            gpuLogList.push_back(entry);
+            gpuLogList.push(0, arguments.data(), argumentCount);
         }
     }
     if (verbose && cmd != Command::CopyCpuToVram2) {
         fmt::print("[GPU] W GP0(0x{:02x}): 0x{:06x}\n", command, arguments[0]);
     }
 
+    if (unlikely(sys->hostTime.enabled)) {
+        uint64_t start = timing::hostNanoseconds();
+        executeCommand();
+        sys->hostTime.gpu += timing::hostNanoseconds() - start;
+    } else {
+        executeCommand();
+    }
+}
+
+void GPU::writeGP0Block(const uint32_t* data, size_t count) {
+    while (count > 0) {
+        // Remaining arguments of a packet are copied at once, polyline length is only known from its terminator
+        if (cmd != Command::None && cmd != Command::CopyCpuToVram2 && currentArgument < argumentCount &&
+            !(cmd == Command::Line && LineArgs(command).polyLine)) {
+            size_t n = std::min<size_t>(count, argumentCount - currentArgument);
+            std::copy_n(data, n, arguments.begin() + currentArgument);
+            currentArgument += n;
+            data += n;
+            count -= n;
+            if (currentArgument == argumentCount) dispatchCommand();
+            continue;
+        }
+
+        if (cmd != Command::CopyCpuToVram2) {
+            writeGP0(*data++);
+            count--;
+            continue;
+        }
+
+        size_t n;
+        if (unlikely(sys->hostTime.enabled)) {
+            uint64_t start = timing::hostNanoseconds();
+            n = writeVramData(data, count);
+            sys->hostTime.gpu += timing::hostNanoseconds() - start;
+        } else {
+            n = writeVramData(data, count);
+        }
+        if (gpuLogEnabled) logCpuToVram(data, n);
+        data += n;
+        count -= n;
+    }
+}
+
+void GPU::logCpuToVram(const uint32_t* data, size_t count) {
+    // Find last gp0(0xa0) command
+    int n = 5;
+    for (int i = gpuLogList.size() - 1; i >= 0; i--) {
+        if (gpuLogList[i].cmd() == 0xa0) {
+            gpuLogList.append(i, data, count);
+            break;
+        }
+        if (n-- == 0) break;
+    }
+}
+
+void GPU::executeCommand() {
     if (cmd == Command::FillRectangle) {
         cmdFillRectangle();
     } else if (cmd == Command::Polygon) {
@@ -733,6 +908,7 @@ void GPU::writeGP1(uint32_t data) {
     if (command == 0x00) {  // Reset GPU
         reset();
     } else if (command == 0x01) {  // Reset command buffer
+        submitUpload();
         cmd = Command::None;
     } else if (command == 0x02) {  // Acknowledge IRQ1
         irqRequest = false;
@@ -782,7 +958,7 @@ void GPU::writeGP1(uint32_t data) {
         fmt::print("[GPU] W GP1(0x{:02x}): 0x{:06x}\n", command, argument);
     }
     if (gpuLogEnabled) {
-        gpuLogList.push_back(LogEntry::GP1(data));
+        gpuLogList.gp1(data);
     }
 }
 
@@ -803,9 +979,9 @@ int GPU::linesPerFrame() const {
 bool GPU::emulateGpuCycles(int cycles) {
     gpuDot += cycles;
 
-    int newLines = gpuDot / 3413;
+    int newLines = gpuDot / CYCLES_PER_LINE;
     if (newLines == 0) return false;
-    gpuDot %= 3413;
+    gpuDot %= CYCLES_PER_LINE;
     gpuLine += newLines;
 
     if (gpuLine < linesPerFrame() - 20 - 1) {
@@ -821,6 +997,7 @@ bool GPU::emulateGpuCycles(int cycles) {
     if (gpuLine == linesPerFrame() - 1) {
         gpuLine = 0;
         frames++;
+        flushRendering();  // Frame is presented from VRAM
         return true;
     }
     return false;
@@ -841,7 +1018,33 @@ bool GPU::insideDrawingArea(int x, int y) const {
 
 bool GPU::isNtsc() const { return forceNtsc || gp1_08.videoMode == GP1_08::VideoMode::ntsc; }
 
+void GPU::flushRendering() {
+    if (!bandedRenderer) return;
+
+    submitUpload();
+    bandedRenderer->flush();
+}
+
+void GPU::invalidateTextureCache() {
+    textureCache.invalidate();
+    if (bandedRenderer) bandedRenderer->invalidateTextures(0, 0, VRAM_WIDTH, VRAM_HEIGHT);
+}
+
+int GPU::displayedFieldSkipped() const {
+    if (gp1_08.verticalResolution != GP1_08::VerticalResolution::r480 || !gp1_08.interlace) return -1;
+    if (gp0_e1.drawingToDisplayArea == GP0_E1::DrawingToDisplayArea::allowed) return -1;
+    return (displayAreaStartY + displayedField()) & 1;
+}
+
+RenderContext GPU::renderContext() {
+    RenderContext ctx{vram.data(), &clutCache, &textureCache, gp0_e1, gp0_e2, drawingArea, gp0_e6};
+    ctx.skipField = displayedFieldSkipped();
+    return ctx;
+}
+
 void GPU::dumpVram() {
+    flushRendering();
+
     const char* dumpName = "vram.png";
     std::vector<uint8_t> vram(VRAM_WIDTH * VRAM_HEIGHT * 3);
 
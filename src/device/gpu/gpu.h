@@ -1,10 +1,14 @@
 #pragma once
 #include <array>
+#include <memory>
 #include <vector>
 #include "color_depth.h"
+#include "gpu_log.h"
 #include "primitive.h"
 #include "psx_color.h"
 #include "registers.h"
+#include "render/context.h"
+#include "render/texture_cache.h"
 
 #define VRAM ((uint16_t(*)[VRAM_WIDTH])vram.data())
 
@@ -14,8 +18,7 @@ class OpenGL;
 
 namespace gpu {
 
-const int VRAM_WIDTH = 1024;
-const int VRAM_HEIGHT = 512;
+class BandedRenderer;
 
 class GPU {
     friend struct ::System;
@@ -97,9 +100,8 @@ class GPU {
     std::array<uint16_t, VRAM_WIDTH * VRAM_HEIGHT> vram{};
 
     // TODO: Serialize?
-    std::array<uint16_t, 256> clutCache{};
-    ivec2 clutCachePos{-1, -1};
-    ColorDepth clutCacheColorDepth = ColorDepth::NONE;
+    ClutCache clutCache;
+    TextureCache textureCache;
 
    private:
     // Hardware rendering
@@ -109,6 +111,10 @@ class GPU {
     bool softwareRendering;
     bool hardwareRendering;
 
+    // Software rendering on worker threads, nullptr when primitives are drawn immediately
+    std::unique_ptr<BandedRenderer> bandedRenderer;
+    std::vector<uint16_t> uploadData;  // CPU to VRAM transfer collected for the banded renderer
+
     void reset();
     void cmdFillRectangle();
     void cmdPolygon(PolygonArgs arg);
@@ -118,22 +124,34 @@ class GPU {
     void cmdCpuToVram2();
     void cmdVramToCpu();
     void cmdVramToVram();
+    void executeCommand();
 
     void drawTriangle(const primitive::Triangle& triangle);
     void drawLine(const primitive::Line& line);
     void drawRectangle(const primitive::Rect& rect);
 
     void writeGP0(uint32_t data);
+    // Logs and executes command with all arguments received
+    void dispatchCommand();
     void writeGP1(uint32_t data);
+    void submitUpload();
+    void logCpuToVram(const uint32_t* data, size_t count);
 
     void reload();
+    // Parity of VRAM rows not drawn in interlaced mode (rows of the displayed field), -1 if all rows are drawn
+    int displayedFieldSkipped() const;
     void maskedWrite(int x, int y, uint16_t value);
 
     uint32_t readVramData();
+    // Copies pixels of active CPU to VRAM transfer in whole rows, returns number of words consumed
+    size_t writeVramData(const uint32_t* data, size_t count);
     uint32_t getStat();
 
+    static const int CYCLES_PER_LINE = 3413;  // In system clock cycles
+
     float cyclesPerLine() const;
     int linesPerFrame() const;
+    int cyclesUntilNextLine() const { return CYCLES_PER_LINE - gpuDot; }
 
    public:
     GPU(System* sys);
@@ -142,7 +160,17 @@ class GPU {
     bool emulateGpuCycles(int cycles);
     uint32_t read(uint32_t address);
     void write(uint32_t address, uint32_t data);
+    // GP0 words sent by DMA, CPU to VRAM transfer data is copied in bulk
+    void writeGP0Block(const uint32_t* data, size_t count);
     bool isNtsc() const;
+    // Interlaced field scanned out during current frame (0 - even rows counted from display area start),
+    // primitives are drawn to the other one
+    int displayedField() const { return frames & 1; }
+    // Waits until primitives queued to the banded renderer are drawn, VRAM has to be flushed before it is read
+    void flushRendering();
+    // VRAM was replaced outside of GP0 commands (state load, replay), decoded textures have to be dropped
+    void invalidateTextureCache();
+    RenderContext renderContext();
 
     int minDrawingX(int x) const;
     int minDrawingY(int y) const;
@@ -151,15 +179,19 @@ class GPU {
     bool insideDrawingArea(int x, int y) const;
 
     // Debug && replay
-    bool gpuLogEnabled = true;
-    std::vector<LogEntry> gpuLogList;
+    bool gpuLogEnabled = false;  // Enabled by the debugger while GPU log is displayed
+    GpuLog gpuLogList;
     std::array<uint16_t, VRAM_WIDTH * VRAM_HEIGHT> prevVram{};
+    int framesToCapture = 0;  // Emulation pauses after capturing this many frames, 0 - capture a single frame continuously
+    int currentCaptureFrame = 0;
 
     void clear() { vertices.clear(); }
     void dumpVram();
 
     template <class Archive>
     void serialize(Archive& ar) {
+        flushRendering();
+
         ar(startX, startY);
         ar(endX, endY);
         ar(currX, currY);
@@ -190,6 +222,7 @@ class GPU {
         ar(textureDisableAllowed);
 
         ar(vram);
+        invalidateTextureCache();
     }
 };
 
@@ -0,0 +1,48 @@
+#include "gpu_log.h"
+#include <stdexcept>
+
+namespace gpu {
+
+namespace {
+// Enough for a typical frame, including a full screen upload
+const size_t RESERVED_WORDS = 256 * 1024;
+const size_t RESERVED_ITEMS = 16 * 1024;
+}  // namespace
+
+LogEntry GpuLog::operator[](size_t i) const {
+    const Item& item = items[i];
+    return LogEntry{item.type, LogArgs{words.data() + item.offset, item.count}};
+}
+
+LogEntry GpuLog::at(size_t i) const {
+    if (i >= items.size()) throw std::out_of_range("GpuLog::at");
+    return (*this)[i];
+}
+
+void GpuLog::clear() {
+    words.clear();
+    items.clear();
+}
+
+void GpuLog::push(uint8_t type, const uint32_t* args, size_t count) {
+    // Buffers are allocated only once logging is enabled
+    if (items.capacity() == 0) {
+        words.reserve(RESERVED_WORDS);
+        items.reserve(RESERVED_ITEMS);
+    }
+    items.push_back(Item{static_cast<uint32_t>(words.size()), static_cast<uint32_t>(count), type});
+    words.insert(words.end(), args, args + count);
+}
+
+void GpuLog::append(size_t i, const uint32_t* data, size_t count) {
+    Item& item = items[i];
+    words.insert(words.begin() + item.offset + item.count, data, data + count);
+    item.count += count;
+
+    // Entries logged after it (GP1 writes in the middle of transfer) are moved
+    for (size_t j = i + 1; j < items.size(); j++) {
+        items[j].offset += count;
+    }
+}
+
+}  // namespace gpu
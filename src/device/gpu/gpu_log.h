@@ -0,0 +1,60 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace gpu {
+
+// Arguments of logged command, valid until the log is modified
+struct LogArgs {
+    const uint32_t* data = nullptr;
+    size_t count = 0;
+
+    size_t size() const { return count; }
+    uint32_t operator[](size_t i) const { return data[i]; }
+    const uint32_t* begin() const { return data; }
+    const uint32_t* end() const { return data + count; }
+};
+
+struct LogEntry {
+    uint8_t type;  // 0 - gp0, 1 - gp1
+    LogArgs args;
+
+    uint8_t cmd() const { return (args[0] >> 24) & 0xff; }
+};
+
+/**
+ * Debug/rewind log of GP0 and GP1 commands.
+ *
+ * Arguments of all entries are stored back to back in one word buffer, clearing the log keeps its capacity
+ * so capturing frame after frame does not allocate once the buffers grew to the size of a frame.
+ * Nothing is allocated until the first command is logged.
+ */
+class GpuLog {
+    struct Item {
+        uint32_t offset;
+        uint32_t count;
+        uint8_t type;
+    };
+
+    std::vector<uint32_t> words;
+    std::vector<Item> items;
+
+   public:
+    size_t size() const { return items.size(); }
+    bool empty() const { return items.empty(); }
+    LogEntry operator[](size_t i) const;
+    LogEntry at(size_t i) const;
+
+    void clear();
+    void push(uint8_t type, const uint32_t* args, size_t count);
+    void gp0(uint32_t word) { push(0, &word, 1); }
+    void gp0(uint8_t cmd, uint32_t data) { gp0((cmd << 24) | (data & 0x00ffffff)); }
+    void gp1(uint32_t word) { push(1, &word, 1); }
+    void gp1(uint8_t cmd, uint32_t data) { gp1((cmd << 24) | (data & 0x00ffffff)); }
+
+    // Adds arguments to existing entry, used for CPU to VRAM data sent after the command
+    void append(size_t i, const uint32_t* data, size_t count);
+};
+
+}  // namespace gpu
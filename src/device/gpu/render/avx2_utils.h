@@ -0,0 +1,114 @@
+#pragma once
+#include <immintrin.h>
+#include <algorithm>
+#include "texture_utils.h"
+#include "utils/macros.h"
+
+/**
+ * Pixel kernels shared by the AVX2 rasterizers, lanes hold 32bit pixels or color channels.
+ *
+ * Has to be included after AVX2 code generation was enabled (see render_triangle_avx2.cpp),
+ * headers above have to be included before that to stay at baseline.
+ */
+namespace {
+INLINE __m256i set1(int v) { return _mm256_set1_epi32(v); }
+
+// 32bit gather of halfword array, neighbour halfword is read and discarded (VRAM and CLUT are never last in their structures)
+INLINE __m256i gather16(const uint16_t* base, __m256i index, __m256i mask) {
+    __m256i v = _mm256_mask_i32gather_epi32(_mm256_setzero_si256(), reinterpret_cast<const int*>(base), index, mask, 2);
+    return _mm256_and_si256(v, set1(0xffff));
+}
+
+INLINE __m256i channel(__m256i c, int shift) { return _mm256_and_si256(_mm256_srli_epi32(c, shift), set1(31)); }
+
+INLINE __m256i pack(__m256i r, __m256i g, __m256i b, __m256i k) {
+    return _mm256_or_si256(_mm256_or_si256(r, _mm256_slli_epi32(g, 5)), _mm256_or_si256(_mm256_slli_epi32(b, 10), k));
+}
+
+INLINE __m256i modulateChannel(__m256i ch, __m256i m) {
+    return _mm256_min_epi32(_mm256_srli_epi32(_mm256_mullo_epi32(ch, m), 7), set1(31));
+}
+
+// Same as PSXColor::operator*(RGB)
+INLINE __m256i modulate(__m256i c, __m256i r, __m256i g, __m256i b) {
+    return pack(modulateChannel(channel(c, 0), r), modulateChannel(channel(c, 5), g), modulateChannel(channel(c, 10), b),
+                _mm256_and_si256(c, set1(0x8000)));
+}
+
+// Same as PSXColor::blend
+INLINE __m256i blend(__m256i bg, __m256i c, gpu::SemiTransparency transparency) {
+    __m256i ch[3];
+    for (int i = 0; i < 3; i++) {
+        __m256i b = channel(bg, i * 5);
+        __m256i f = channel(c, i * 5);
+        switch (transparency) {
+            case gpu::SemiTransparency::Bby2plusFby2: ch[i] = _mm256_srli_epi32(_mm256_add_epi32(b, f), 1); break;
+            case gpu::SemiTransparency::BplusF: ch[i] = _mm256_min_epi32(_mm256_add_epi32(b, f), set1(31)); break;
+            case gpu::SemiTransparency::BminusF: ch[i] = _mm256_max_epi32(_mm256_sub_epi32(b, f), _mm256_setzero_si256()); break;
+            case gpu::SemiTransparency::BplusFby4:
+                ch[i] = _mm256_min_epi32(_mm256_add_epi32(b, _mm256_srli_epi32(f, 2)), set1(31));
+                break;
+        }
+    }
+    return pack(ch[0], ch[1], ch[2], _mm256_and_si256(c, set1(0x8000)));
+}
+
+INLINE __m256i ditherChannel(__m256i c, __m256i offset) {
+    return _mm256_min_epi32(_mm256_max_epi32(_mm256_add_epi32(c, offset), _mm256_setzero_si256()), set1(255));
+}
+
+template <ColorDepth bits>
+INLINE __m256i fetchTexAvx2(const gpu::RenderContext* ctx, const uint16_t* texels, __m256i u, __m256i v, __m256i texPageX,
+                             __m256i texPageY, __m256i mask) {
+    if constexpr (bits == ColorDepth::BIT_4 || bits == ColorDepth::BIT_8) {
+        if (texels) return gather16(texels, _mm256_or_si256(_mm256_slli_epi32(v, 8), u), mask);
+    }
+
+    const __m256i row = _mm256_slli_epi32(_mm256_and_si256(_mm256_add_epi32(texPageY, v), set1(511)), 10);
+    const auto address = [&](__m256i x) { return _mm256_or_si256(row, _mm256_and_si256(_mm256_add_epi32(texPageX, x), set1(1023))); };
+
+    if constexpr (bits == ColorDepth::BIT_4) {
+        __m256i index = gather16(ctx->vram, address(_mm256_srli_epi32(u, 2)), mask);
+        __m256i shift = _mm256_slli_epi32(_mm256_and_si256(u, set1(3)), 2);
+        __m256i entry = _mm256_and_si256(_mm256_srlv_epi32(index, shift), set1(0xf));
+        return gather16(ctx->clutCache->entries.data(), entry, mask);
+    } else if constexpr (bits == ColorDepth::BIT_8) {
+        __m256i index = gather16(ctx->vram, address(_mm256_srli_epi32(u, 1)), mask);
+        __m256i shift = _mm256_slli_epi32(_mm256_and_si256(u, set1(1)), 3);
+        __m256i entry = _mm256_and_si256(_mm256_srlv_epi32(index, shift), set1(0xff));
+        return gather16(ctx->clutCache->entries.data(), entry, mask);
+    } else {
+        return gather16(ctx->vram, address(u), mask);
+    }
+}
+
+// Result of primitive sampling its own output depends on pixel order, such primitives are drawn by the scalar rasterizers
+inline bool samplesOwnOutput(int bits, ivec2 texpage, ivec2 min, ivec2 max) {
+    if (bits == 0) return false;
+
+    // Texture page wraps around VRAM width
+    const int width = 256 * bits / 16;
+    const int x = texpage.x, y = texpage.y;
+    if (min.y > y + 255 || max.y < y) return false;
+    return (min.x < x + width && max.x >= x) || (min.x < x + width - gpu::VRAM_WIDTH && max.x >= x - gpu::VRAM_WIDTH);
+}
+
+// Reads 8 consecutive VRAM pixels
+INLINE __m256i load8(const uint16_t* src) { return _mm256_cvtepu16_epi32(_mm_loadu_si128(reinterpret_cast<const __m128i*>(src))); }
+
+// Writes 8 consecutive VRAM pixels, lanes have to be 16bit values
+INLINE void store8(uint16_t* dst, __m256i c) {
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(dst), _mm_packus_epi32(_mm256_castsi256_si128(c), _mm256_extracti128_si256(c, 1)));
+}
+
+// Writes pixels of lanes set in mask to VRAM addresses (y * VRAM_WIDTH + x)
+INLINE void scatter16(uint16_t* base, __m256i address, __m256i c, __m256i mask) {
+    alignas(32) uint32_t addresses[8], pixels[8];
+    _mm256_store_si256(reinterpret_cast<__m256i*>(addresses), address);
+    _mm256_store_si256(reinterpret_cast<__m256i*>(pixels), c);
+    for (int lanes = _mm256_movemask_ps(_mm256_castsi256_ps(mask)); lanes != 0; lanes &= lanes - 1) {
+        int i = __builtin_ctz(lanes);
+        base[addresses[i]] = pixels[i];
+    }
+}
+}  // namespace
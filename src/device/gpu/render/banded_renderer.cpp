@@ -0,0 +1,308 @@
+#include "banded_renderer.h"
+#include <algorithm>
+#include "render.h"
+#include "span.h"
+
+namespace gpu {
+
+namespace {
+// Iterations worker busy waits for new commands before going to sleep
+const int SPIN_COUNT = 4096;
+}  // namespace
+
+BandedRenderer::BandedRenderer(uint16_t* vram, int threads, const ClutCache& clutCache) : vram(vram), queue(QUEUE_SIZE) {
+    for (int i = 0; i < threads; i++) {
+        auto worker = std::make_unique<Worker>();
+        worker->clutCache = clutCache;
+        workers.push_back(std::move(worker));
+    }
+    for (int i = 0; i < threads; i++) {
+        workers[i]->thread = std::thread(&BandedRenderer::workerLoop, this, i);
+    }
+}
+
+BandedRenderer::~BandedRenderer() {
+    flush();
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        quit = true;
+    }
+    wakeUp.notify_all();
+    for (auto& worker : workers) {
+        worker->thread.join();
+    }
+}
+
+void BandedRenderer::markRegion(Tiles& tiles, int x, int y, int w, int h) {
+    if (w <= 0 || h <= 0) return;
+
+    // Regions wrap around VRAM edges
+    uint16_t columns = 0;
+    if (w >= VRAM_WIDTH) {
+        columns = 0xffff;
+    } else {
+        for (int tx = x >> TILE_SHIFT; tx <= (x + w - 1) >> TILE_SHIFT; tx++) {
+            columns |= 1 << (tx % TILES_X);
+        }
+    }
+
+    int rows = std::min(h, VRAM_HEIGHT);
+    for (int ty = y >> TILE_SHIFT; ty <= (y + rows - 1) >> TILE_SHIFT; ty++) {
+        tiles[ty % TILES_Y] |= columns;
+    }
+}
+
+void BandedRenderer::markTexture(Tiles& tiles, int bits, ivec2 texpage, ivec2 clut) {
+    if (bits == 0) return;
+
+    // Texture page is 256x256 texels, 4 or 2 of them packed in halfword for paletted textures
+    markRegion(tiles, texpage.x, texpage.y, 256 * bits / 16, 256);
+
+    if (bits == 4 || bits == 8) {
+        markRegion(tiles, clut.x, clut.y, bits == 8 ? 256 : 16, 1);
+    }
+}
+
+bool BandedRenderer::overlaps(const Tiles& a, const Tiles& b) {
+    for (int i = 0; i < TILES_Y; i++) {
+        if (a[i] & b[i]) return true;
+    }
+    return false;
+}
+
+BandedRenderer::Command BandedRenderer::command(Command::Type type, const RenderContext& ctx) {
+    Command cmd{};
+    cmd.type = type;
+    cmd.gp0_e1 = ctx.gp0_e1;
+    cmd.gp0_e2 = ctx.gp0_e2;
+    cmd.drawingArea = ctx.drawingArea;
+    cmd.gp0_e6 = ctx.gp0_e6;
+    cmd.skipField = ctx.skipField;
+    return cmd;
+}
+
+bool BandedRenderer::resolveHazards(const Command& cmd, const Tiles& reads, const Tiles& writes) {
+    // Primitive sampling its own output depends on the order lines are drawn in - draw it on this thread
+    if (overlaps(reads, writes)) {
+        flush();
+        RenderContext ctx{};
+        ctx.vram = vram;
+        ctx.clutCache = &workers[0]->clutCache;
+        ctx.textureCache = &workers[0]->textureCache;
+        execute(cmd, ctx);
+        for (auto& worker : workers) {
+            worker->clutCache = workers[0]->clutCache;
+            if (worker != workers[0]) worker->textureCache.invalidate();
+        }
+        return true;
+    }
+
+    if (overlaps(writes, pendingReads) || overlaps(reads, pendingWrites)) {
+        flush();
+    }
+    for (int i = 0; i < TILES_Y; i++) {
+        pendingReads[i] |= reads[i];
+        pendingWrites[i] |= writes[i];
+    }
+    return false;
+}
+
+void BandedRenderer::submit(Command&& cmd, const Tiles& reads, const Tiles& writes) {
+    // Single worker executes everything in order, no hazards possible
+    if (workers.size() > 1 && resolveHazards(cmd, reads, writes)) return;
+
+    uint64_t h = head.load(std::memory_order_relaxed);
+    for (auto& worker : workers) {
+        while (h - worker->tail.load(std::memory_order_acquire) >= QUEUE_SIZE) {
+            std::this_thread::yield();
+        }
+    }
+    queue[h & (QUEUE_SIZE - 1)] = std::move(cmd);
+    head.store(h + 1);
+
+    if (sleeping.load() > 0) {
+        std::lock_guard<std::mutex> lock(mutex);
+        wakeUp.notify_all();
+    }
+}
+
+void BandedRenderer::execute(const Command& cmd, RenderContext& ctx) const {
+    ctx.gp0_e1 = cmd.gp0_e1;
+    ctx.gp0_e2 = cmd.gp0_e2;
+    ctx.drawingArea = cmd.drawingArea;
+    ctx.gp0_e6 = cmd.gp0_e6;
+    ctx.skipField = cmd.skipField;
+
+    auto pixels = (uint16_t(*)[VRAM_WIDTH])vram;
+
+    switch (cmd.type) {
+        case Command::Type::Triangle: Render::drawTriangle(&ctx, cmd.triangle); break;
+        case Command::Type::Rectangle: Render::drawRectangle(&ctx, cmd.rect); break;
+        case Command::Type::Line: Render::drawLine(&ctx, cmd.line); break;
+
+        case Command::Type::Fill:
+            for (int y = cmd.y; y < cmd.y + cmd.h; y++) {
+                if (!ctx.drawsRow(y)) continue;
+                fillSpan(&pixels[y][cmd.x], cmd.w, cmd.color);
+            }
+            ctx.textureCache->markDirty(cmd.x, cmd.y, cmd.w, cmd.h);
+            break;
+
+        case Command::Type::Upload: {
+            ctx.textureCache->markDirty(cmd.x, cmd.y, cmd.w, cmd.h);
+
+            const uint16_t mask = ctx.gp0_e6.setMaskWhileDrawing << 15;
+            const auto& data = *cmd.data;
+            for (size_t i = 0; i < data.size(); i++) {
+                int n = cmd.offset + (int)i;
+                int y = (cmd.y + n / cmd.w) % VRAM_HEIGHT;
+                if (!ctx.ownsRow(y)) continue;
+                int x = (cmd.x + n % cmd.w) % VRAM_WIDTH;
+
+                if (ctx.gp0_e6.checkMaskBeforeDraw && (pixels[y][x] & 0x8000)) continue;
+                pixels[y][x] = data[i] | mask;
+            }
+            break;
+        }
+
+        case Command::Type::InvalidateClut: ctx.clutCache->invalidate(); break;
+        case Command::Type::InvalidateTextures: ctx.textureCache->markDirty(cmd.x, cmd.y, cmd.w, cmd.h); break;
+    }
+}
+
+void BandedRenderer::workerLoop(int band) {
+    Worker& worker = *workers[band];
+    RenderContext ctx{};
+    ctx.vram = vram;
+    ctx.clutCache = &worker.clutCache;
+    ctx.textureCache = &worker.textureCache;
+    ctx.bandShift = BAND_SHIFT;
+    ctx.bandCount = (int)workers.size();
+    ctx.band = band;
+
+    uint64_t tail = worker.tail.load(std::memory_order_relaxed);
+    for (;;) {
+        uint64_t h = head.load(std::memory_order_acquire);
+        for (int i = 0; h == tail && i < SPIN_COUNT; i++) {
+            h = head.load(std::memory_order_acquire);
+        }
+
+        if (h == tail) {
+            std::unique_lock<std::mutex> lock(mutex);
+            sleeping++;
+            wakeUp.wait(lock, [&] { return quit || head.load() != tail; });
+            sleeping--;
+            if (head.load() == tail) return;  // Quit with empty queue
+            continue;
+        }
+
+        for (; tail != h; tail++) {
+            execute(queue[tail & (QUEUE_SIZE - 1)], ctx);
+            worker.tail.store(tail + 1, std::memory_order_release);
+        }
+    }
+}
+
+bool BandedRenderer::isIdle() const {
+    uint64_t h = head.load(std::memory_order_relaxed);
+    for (auto& worker : workers) {
+        if (worker->tail.load(std::memory_order_acquire) != h) return false;
+    }
+    return true;
+}
+
+void BandedRenderer::flush() {
+    while (!isIdle()) {
+        std::this_thread::yield();
+    }
+    pendingReads.fill(0);
+    pendingWrites.fill(0);
+}
+
+void BandedRenderer::drawTriangle(const RenderContext& ctx, const primitive::Triangle& triangle) {
+    int minX = std::min({triangle.v[0].pos.x, triangle.v[1].pos.x, triangle.v[2].pos.x});
+    int minY = std::min({triangle.v[0].pos.y, triangle.v[1].pos.y, triangle.v[2].pos.y});
+    int maxX = std::max({triangle.v[0].pos.x, triangle.v[1].pos.x, triangle.v[2].pos.x});
+    int maxY = std::max({triangle.v[0].pos.y, triangle.v[1].pos.y, triangle.v[2].pos.y});
+
+    Tiles reads{}, writes{};
+    markTexture(reads, triangle.bits, triangle.texpage, triangle.clut);
+    markRegion(writes, ctx.minDrawingX(minX), ctx.minDrawingY(minY), ctx.maxDrawingX(maxX) - ctx.minDrawingX(minX) + 1,
+               ctx.maxDrawingY(maxY) - ctx.minDrawingY(minY) + 1);
+
+    Command cmd = command(Command::Type::Triangle, ctx);
+    cmd.triangle = triangle;
+    submit(std::move(cmd), reads, writes);
+}
+
+void BandedRenderer::drawRectangle(const RenderContext& ctx, const primitive::Rect& rect) {
+    int minX = ctx.minDrawingX(rect.pos.x);
+    int minY = ctx.minDrawingY(rect.pos.y);
+
+    Tiles reads{}, writes{};
+    markTexture(reads, rect.bits, rect.texpage, rect.clut);
+    markRegion(writes, minX, minY, ctx.maxDrawingX(rect.pos.x + rect.size.x - 1) - minX + 1,
+               ctx.maxDrawingY(rect.pos.y + rect.size.y - 1) - minY + 1);
+
+    Command cmd = command(Command::Type::Rectangle, ctx);
+    cmd.rect = rect;
+    submit(std::move(cmd), reads, writes);
+}
+
+void BandedRenderer::drawLine(const RenderContext& ctx, const primitive::Line& line) {
+    int minX = ctx.minDrawingX(std::min(line.pos[0].x, line.pos[1].x));
+    int minY = ctx.minDrawingY(std::min(line.pos[0].y, line.pos[1].y));
+
+    Tiles reads{}, writes{};
+    markRegion(writes, minX, minY, ctx.maxDrawingX(std::max(line.pos[0].x, line.pos[1].x)) - minX + 1,
+               ctx.maxDrawingY(std::max(line.pos[0].y, line.pos[1].y)) - minY + 1);
+
+    Command cmd = command(Command::Type::Line, ctx);
+    cmd.line = line;
+    submit(std::move(cmd), reads, writes);
+}
+
+void BandedRenderer::fill(const RenderContext& ctx, int x, int y, int w, int h, uint16_t color) {
+    Tiles reads{}, writes{};
+    markRegion(writes, x, y, w, h);
+
+    Command cmd = command(Command::Type::Fill, ctx);
+    cmd.x = x;
+    cmd.y = y;
+    cmd.w = w;
+    cmd.h = h;
+    cmd.color = color;
+    submit(std::move(cmd), reads, writes);
+}
+
+void BandedRenderer::upload(const RenderContext& ctx, int x, int y, int w, int h, int offset, std::vector<uint16_t> data) {
+    Tiles reads{}, writes{};
+    markRegion(writes, x, y, w, h);
+
+    Command cmd = command(Command::Type::Upload, ctx);
+    cmd.x = x;
+    cmd.y = y;
+    cmd.w = w;
+    cmd.h = h;
+    cmd.offset = offset;
+    cmd.data = std::make_shared<const std::vector<uint16_t>>(std::move(data));
+    submit(std::move(cmd), reads, writes);
+}
+
+void BandedRenderer::invalidateClut() {
+    Command cmd{};
+    cmd.type = Command::Type::InvalidateClut;
+    submit(std::move(cmd), Tiles{}, Tiles{});
+}
+
+void BandedRenderer::invalidateTextures(int x, int y, int w, int h) {
+    Command cmd{};
+    cmd.type = Command::Type::InvalidateTextures;
+    cmd.x = x;
+    cmd.y = y;
+    cmd.w = w;
+    cmd.h = h;
+    submit(std::move(cmd), Tiles{}, Tiles{});
+}
+
+}  // namespace gpu
@@ -0,0 +1,116 @@
+#pragma once
+#include <array>
+#include <atomic>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include "context.h"
+#include "device/gpu/primitive.h"
+#include "texture_cache.h"
+
+namespace gpu {
+
+/**
+ * Software rasterizer running on worker threads.
+ *
+ * GPU commands are still decoded on the emulation thread (GPUSTAT, GPUREAD and IRQ stay synchronous),
+ * only drawing is deferred. With a single worker it acts as GPU thread fed by single producer/single consumer queue.
+ *
+ * VRAM is split into interleaved horizontal bands (8 lines each), every worker draws only lines of its bands.
+ * Primitives are queued in submission order and every worker executes all of them, so the result is bit-exact
+ * with drawing on the emulation thread.
+ *
+ * Primitives reading VRAM (textures, palettes) written by queued primitives (or the other way around)
+ * would race between workers - such hazards are tracked in 64x64 tiles and the queue is drained before
+ * submitting conflicting primitive. VRAM reads done by the emulation thread require full flush().
+ */
+class BandedRenderer {
+    static const int BAND_SHIFT = 3;
+    static const int QUEUE_SIZE = 4096;  // Must be power of 2
+
+    static const int TILE_SHIFT = 6;
+    static const int TILES_X = VRAM_WIDTH >> TILE_SHIFT;
+    static const int TILES_Y = VRAM_HEIGHT >> TILE_SHIFT;
+
+    // Bitmask of 64x64 VRAM tiles, one bit per tile column
+    using Tiles = std::array<uint16_t, TILES_Y>;
+
+    struct Command {
+        enum class Type { Triangle, Rectangle, Line, Fill, Upload, InvalidateClut, InvalidateTextures } type;
+
+        // GPU state when the command was submitted
+        GP0_E1 gp0_e1;
+        GP0_E2 gp0_e2;
+        Rect<int16_t> drawingArea;
+        GP0_E6 gp0_e6;
+        int skipField;
+
+        primitive::Triangle triangle;
+        primitive::Rect rect;
+        primitive::Line line;
+
+        // Fill, Upload and InvalidateTextures destination
+        int x, y, w, h;
+        uint16_t color;
+        int offset;  // Index of first uploaded pixel in the destination rectangle
+        std::shared_ptr<const std::vector<uint16_t>> data;
+    };
+
+    struct Worker {
+        std::thread thread;
+        std::atomic<uint64_t> tail{0};
+        ClutCache clutCache;
+        TextureCache textureCache;
+    };
+
+    uint16_t* vram;
+    std::vector<Command> queue;
+    std::vector<std::unique_ptr<Worker>> workers;
+
+    std::atomic<uint64_t> head{0};
+    std::atomic<bool> quit{false};
+    std::atomic<int> sleeping{0};
+    std::mutex mutex;
+    std::condition_variable wakeUp;
+
+    // Regions accessed by commands still in the queue
+    Tiles pendingReads{};
+    Tiles pendingWrites{};
+
+    static void markRegion(Tiles& tiles, int x, int y, int w, int h);
+    static void markTexture(Tiles& tiles, int bits, ivec2 texpage, ivec2 clut);
+    static bool overlaps(const Tiles& a, const Tiles& b);
+
+    static Command command(Command::Type type, const RenderContext& ctx);
+    // Returns true if command was drawn immediately
+    bool resolveHazards(const Command& cmd, const Tiles& reads, const Tiles& writes);
+    void submit(Command&& cmd, const Tiles& reads, const Tiles& writes);
+    void execute(const Command& cmd, RenderContext& ctx) const;
+    void workerLoop(int band);
+    bool isIdle() const;
+
+   public:
+    BandedRenderer(uint16_t* vram, int threads, const ClutCache& clutCache);
+    ~BandedRenderer();
+
+    void drawTriangle(const RenderContext& ctx, const primitive::Triangle& triangle);
+    void drawRectangle(const RenderContext& ctx, const primitive::Rect& rect);
+    void drawLine(const RenderContext& ctx, const primitive::Line& line);
+    void fill(const RenderContext& ctx, int x, int y, int w, int h, uint16_t color);
+    void upload(const RenderContext& ctx, int x, int y, int w, int h, int offset, std::vector<uint16_t> data);
+    void invalidateClut();
+    // VRAM region was written outside of the renderer
+    void invalidateTextures(int x, int y, int w, int h);
+
+    // Waits until all queued commands are executed
+    void flush();
+
+    int threadCount() const { return (int)workers.size(); }
+
+    // Palette cache state, valid after flush()
+    const ClutCache& clutCache() const { return workers[0]->clutCache; }
+};
+
+}  // namespace gpu
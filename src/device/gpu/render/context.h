@@ -0,0 +1,64 @@
+#pragma once
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include "device/gpu/color_depth.h"
+#include "device/gpu/registers.h"
+#include "utils/vector.h"
+
+namespace gpu {
+
+const int VRAM_WIDTH = 1024;
+const int VRAM_HEIGHT = 512;
+
+// Color look-up table cache, reloaded only when palette position or color depth changes (or after GP0(0x01))
+struct ClutCache {
+    std::array<uint16_t, 256> entries{};
+    ivec2 pos{-1, -1};
+    ColorDepth colorDepth = ColorDepth::NONE;
+    uint32_t generation = 0;  // Incremented on every reload
+
+    void invalidate() { pos = ivec2(-1, -1); }
+};
+
+class TextureCache;
+
+/**
+ * GPU state used by the software rasterizers.
+ *
+ * Banded renderer workers keep their own copy, captured when the primitive was submitted,
+ * and draw only rows of their bands. Primitives are still traversed from their first row,
+ * so interpolated values are identical no matter how VRAM is split.
+ */
+struct RenderContext {
+    uint16_t* vram;
+    ClutCache* clutCache;
+    TextureCache* textureCache = nullptr;  // Optional, without it all texels are fetched from VRAM
+
+    GP0_E1 gp0_e1;
+    GP0_E2 gp0_e2;
+    Rect<int16_t> drawingArea;
+    GP0_E6 gp0_e6;
+
+    // Row y belongs to this context if (y >> bandShift) % bandCount == band
+    int bandShift = 0;
+    int bandCount = 1;
+    int band = 0;
+
+    // Rows of the displayed interlaced field are not drawn (480i with drawing to display area prohibited), -1 - all rows are drawn
+    int skipField = -1;
+
+    bool ownsRow(int y) const { return bandCount == 1 || ((y >> bandShift) % bandCount) == band; }
+    bool drawsRow(int y) const { return (y & 1) != skipField && ownsRow(y); }
+
+    int minDrawingX(int x) const { return std::max((int)drawingArea.left, std::max(0, x)); }
+    int minDrawingY(int y) const { return std::max((int)drawingArea.top, std::max(0, y)); }
+    int maxDrawingX(int x) const { return std::min((int)drawingArea.right, std::min(VRAM_WIDTH, x)); }
+    int maxDrawingY(int y) const { return std::min((int)drawingArea.bottom, std::min(VRAM_HEIGHT, y)); }
+    bool insideDrawingArea(int x, int y) const {
+        return (x >= drawingArea.left) && (x < drawingArea.right) && (x < VRAM_WIDTH) && (y >= drawingArea.top)
+               && (y < drawingArea.bottom) && (y < VRAM_HEIGHT);
+    }
+};
+
+}  // namespace gpu
@@ -1,9 +1,25 @@
 #pragma once
 #include "device/gpu/gpu.h"
+#include "utils/cpu_features.h"
 
 class Render {
    public:
     static void drawLine(gpu::GPU* gpu, const primitive::Line& line);
     static void drawTriangle(gpu::GPU* gpu, const primitive::Triangle& triangle);
     static void drawRectangle(gpu::GPU* gpu, const primitive::Rect& rect);
-};
\ No newline at end of file
+
+    static void drawLine(const gpu::RenderContext* ctx, const primitive::Line& line);
+    static void drawTriangle(const gpu::RenderContext* ctx, const primitive::Triangle& triangle);
+    static void drawRectangle(const gpu::RenderContext* ctx, const primitive::Rect& rect);
+
+    // Scalar rasterizers, reference for the SIMD versions
+    static void drawLineReference(const gpu::RenderContext* ctx, const primitive::Line& line);
+    static void drawTriangleReference(const gpu::RenderContext* ctx, const primitive::Triangle& triangle);
+    static void drawRectangleReference(const gpu::RenderContext* ctx, const primitive::Rect& rect);
+#ifdef CPU_FEATURES_X64
+    // Require cpu_features::hasAvx2()
+    static void drawLineAvx2(const gpu::RenderContext* ctx, const primitive::Line& line);
+    static void drawTriangleAvx2(const gpu::RenderContext* ctx, const primitive::Triangle& triangle);
+    static void drawRectangleAvx2(const gpu::RenderContext* ctx, const primitive::Rect& rect);
+#endif
+};
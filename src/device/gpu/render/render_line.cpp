@@ -1,16 +1,16 @@
 #include <algorithm>
 #include "dither.h"
 #include "render.h"
+#include "texture_utils.h"
 #include "utils/macros.h"
 
 #undef VRAM
-#define VRAM ((uint16_t(*)[gpu::VRAM_WIDTH])gpu->vram.data())
+#define VRAM ((uint16_t(*)[gpu::VRAM_WIDTH])ctx->vram)
 
-void Render::drawLine(gpu::GPU* gpu, const primitive::Line& line) {
-    const auto transparency = gpu->gp0_e1.semiTransparency;
-    const bool checkMaskBeforeDraw = gpu->gp0_e6.checkMaskBeforeDraw;
-    const bool setMaskWhileDrawing = gpu->gp0_e6.setMaskWhileDrawing;
-    const bool dithering = gpu->gp0_e1.dither24to15;
+template <bool isSemiTransparent, bool isGouraudShaded, bool checkMaskBeforeDraw, bool dithering>
+void rasterizeLine(const gpu::RenderContext* ctx, const primitive::Line& line) {
+    const auto transparency = ctx->gp0_e1.semiTransparency;
+    const bool setMaskWhileDrawing = ctx->gp0_e6.setMaskWhileDrawing;
 
     int x0 = line.pos[0].x;
     int y0 = line.pos[0].y;
@@ -25,6 +25,10 @@ void Render::drawLine(gpu::GPU* gpu, const primitive::Line& line) {
     if (abs(x0 - x1) >= 1024) return;
     if (abs(y0 - y1) >= 512) return;
 
+    const ivec2 min(ctx->minDrawingX(std::min(x0, x1)), ctx->minDrawingY(std::min(y0, y1)));
+    const ivec2 max(ctx->maxDrawingX(std::max(x0, x1)), ctx->maxDrawingY(std::max(y0, y1)));
+    markDrawn(ctx, min, max);
+
     bool steep = false;
     if (std::abs(x0 - x1) < std::abs(y0 - y1)) {
         std::swap(x0, y0);
@@ -43,31 +47,21 @@ void Render::drawLine(gpu::GPU* gpu, const primitive::Line& line) {
     int error = !steep;
     int y = y0;
 
-    float length = sqrtf(powf(x1 - x0, 2) + powf(y1 - y0, 2));
-    if (length == 0) {
-        length = 1.f;  // Prevent NaN in getColor
-    }
-
-    // TODO: Precalculate color stepping
-    auto getColor = [&](int x, int y) -> RGB {
-        if (!line.gouraudShading) {
-            return c0;
-        }
-        float relPos = sqrtf(powf(x0 - x, 2) + powf(y0 - y, 2));
-
-        float progress = relPos / length;
-
-        return c0 * (1.f - progress) + c1 * progress;
-    };
+    // Color is stepped along the major axis in 16.16 fixed point
+    const int steps = std::max(dx, 1);
+    const auto start = [](int c) { return (c << 16) + (1 << 15); };
+    const auto step = [&](int from, int to) { return ((to - from) * (1 << 16)) / steps; };
+    int r = start(c0.r), g = start(c0.g), b = start(c0.b);
+    const int dr = step(c0.r, c1.r), dg = step(c0.g, c1.g), db = step(c0.b, c1.b);
 
     auto putPixel = [&](int x, int y, RGB fullColor) {
         PSXColor bg = VRAM[y][x];
-        if (unlikely(checkMaskBeforeDraw)) {
+        if constexpr (checkMaskBeforeDraw) {
             if (bg.k) return;
         }
 
         PSXColor c(fullColor.r, fullColor.g, fullColor.b);
-        if (dithering) {
+        if constexpr (dithering) {
             c = PSXColor(                                //
                 ditherLUT[y & 3u][x & 3u][fullColor.r],  //
                 ditherLUT[y & 3u][x & 3u][fullColor.g],  //
@@ -75,7 +69,7 @@ void Render::drawLine(gpu::GPU* gpu, const primitive::Line& line) {
             );
         }
 
-        if (line.isSemiTransparent) {
+        if constexpr (isSemiTransparent) {
             c = PSXColor::blend(bg, c, transparency);
         }
 
@@ -85,11 +79,19 @@ void Render::drawLine(gpu::GPU* gpu, const primitive::Line& line) {
     };
 
     for (int x = x0; x <= x1; x++) {
+        RGB color = c0;
+        if constexpr (isGouraudShaded) {
+            color = RGB(r >> 16, g >> 16, b >> 16);
+            r += dr;
+            g += dg;
+            b += db;
+        }
+
         if (steep) {
             // TODO: Remove insideDrawingArea calls
-            if (gpu->insideDrawingArea(y, x)) putPixel(y, x, getColor(x, y));
+            if (ctx->insideDrawingArea(y, x) && ctx->drawsRow(x)) putPixel(y, x, color);
         } else {
-            if (gpu->insideDrawingArea(x, y)) putPixel(x, y, getColor(x, y));
+            if (ctx->insideDrawingArea(x, y) && ctx->drawsRow(y)) putPixel(x, y, color);
         }
         error += derror;
         if (error > dx) {
@@ -98,3 +100,56 @@ void Render::drawLine(gpu::GPU* gpu, const primitive::Line& line) {
         }
     }
 }
+
+// Generate all permutations of rasterizeLine
+using rasterizeLine_t = void(const gpu::RenderContext* ctx, const primitive::Line& line);
+
+#define E(isSemiTransparent, isGouraudShaded, checkMaskBit, dithering) \
+    &rasterizeLine<isSemiTransparent, isGouraudShaded, checkMaskBit, dithering>
+
+/* Kotlin script for lookup array generation:
+
+    fun Iterable<Int>.wrap(f: (Int) -> String): String =
+        "{" + joinToString(",", transform = f) + "}"
+
+    fun generateTable(): String =
+        (0..1).wrap { isSemiTransparent ->
+        (0..1).wrap { isGouraudShaded ->
+        (0..1).wrap { checkMaskBit ->
+        (0..1).wrap { dithering ->
+            "E($isSemiTransparent, $isGouraudShaded, $checkMaskBit, $dithering)"
+        }}}}
+
+    generateTable()
+*/
+
+static constexpr rasterizeLine_t* rasterizeLineDispatchTable[2][2][2][2] =  //
+    {{{{E(0, 0, 0, 0), E(0, 0, 0, 1)}, {E(0, 0, 1, 0), E(0, 0, 1, 1)}}, {{E(0, 1, 0, 0), E(0, 1, 0, 1)}, {E(0, 1, 1, 0), E(0, 1, 1, 1)}}},
+     {{{E(1, 0, 0, 0), E(1, 0, 0, 1)}, {E(1, 0, 1, 0), E(1, 0, 1, 1)}}, {{E(1, 1, 0, 0), E(1, 1, 0, 1)}, {E(1, 1, 1, 0), E(1, 1, 1, 1)}}}};
+#undef E
+
+void Render::drawLineReference(const gpu::RenderContext* ctx, const primitive::Line& line) {
+    auto isSemiTransparent = line.isSemiTransparent;
+    auto isGouraudShaded = line.gouraudShading;
+    auto checkMaskBit = ctx->gp0_e6.checkMaskBeforeDraw;
+    auto dithering = ctx->gp0_e1.dither24to15;
+
+    auto rasterize = rasterizeLineDispatchTable[isSemiTransparent][isGouraudShaded][checkMaskBit][dithering];
+
+    rasterize(ctx, line);
+}
+
+void Render::drawLine(const gpu::RenderContext* ctx, const primitive::Line& line) {
+#ifdef CPU_FEATURES_X64
+    if (cpu_features::hasAvx2()) {
+        drawLineAvx2(ctx, line);
+        return;
+    }
+#endif
+    drawLineReference(ctx, line);
+}
+
+void Render::drawLine(gpu::GPU* gpu, const primitive::Line& line) {
+    auto ctx = gpu->renderContext();
+    drawLine(&ctx, line);
+}
@@ -0,0 +1,165 @@
+#include "render.h"
+#ifdef CPU_FEATURES_X64
+#include <immintrin.h>
+#include <algorithm>
+#include "dither.h"
+#include "texture_utils.h"
+#include "utils/macros.h"
+
+// Functions below are compiled for AVX2 and only called after runtime check, shared headers above stay at baseline
+#if defined(__clang__)
+#pragma clang attribute push(__attribute__((target("avx2"))), apply_to = function)
+#elif defined(__GNUC__)
+#pragma GCC push_options
+#pragma GCC target("avx2")
+#endif
+#include "avx2_utils.h"
+
+/**
+ * AVX2 version of rasterizeLine, must produce exactly the same pixels.
+ *
+ * Lanes hold 8 consecutive steps along the major axis. Positions are stepped by the same Bresenham loop as
+ * in the scalar rasterizer, color, dithering, blending and masking are done for all lanes at once.
+ * Line never visits a pixel twice, so reading background of the whole group before writing it is safe.
+ */
+namespace {
+const int LANES = 8;
+}  // namespace
+
+template <bool isSemiTransparent, bool isGouraudShaded, bool checkMaskBeforeDraw, bool dithering>
+void rasterizeLineAvx2(const gpu::RenderContext* ctx, const primitive::Line& line) {
+    const auto transparency = ctx->gp0_e1.semiTransparency;
+    constexpr bool readsBackground = isSemiTransparent || checkMaskBeforeDraw;
+
+    int x0 = line.pos[0].x;
+    int y0 = line.pos[0].y;
+    int x1 = line.pos[1].x;
+    int y1 = line.pos[1].y;
+    RGB c0 = line.color[0];
+    RGB c1 = line.color[1];
+
+    // Skip rendering when distance between vertices is bigger than 1023x511
+    if (abs(x0 - x1) >= 1024) return;
+    if (abs(y0 - y1) >= 512) return;
+
+    const ivec2 min(ctx->minDrawingX(std::min(x0, x1)), ctx->minDrawingY(std::min(y0, y1)));
+    const ivec2 max(ctx->maxDrawingX(std::max(x0, x1)), ctx->maxDrawingY(std::max(y0, y1)));
+    markDrawn(ctx, min, max);
+
+    bool steep = false;
+    if (std::abs(x0 - x1) < std::abs(y0 - y1)) {
+        std::swap(x0, y0);
+        std::swap(x1, y1);
+        steep = true;
+    }
+    if (x0 > x1) {
+        std::swap(x0, x1);
+        std::swap(y0, y1);
+        std::swap(c0, c1);
+    }
+
+    int dx = x1 - x0;
+    int dy = y1 - y0;
+    int derror = std::abs(dy) * 2;
+    int error = !steep;
+    int y = y0;
+
+    // Same 16.16 color stepping as rasterizeLine, lane i is i steps ahead
+    const int steps = std::max(dx, 1);
+    const auto start = [](int c) { return (c << 16) + (1 << 15); };
+    const auto step = [&](int from, int to) { return ((to - from) * (1 << 16)) / steps; };
+    const __m256i lane = _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7);
+    const auto lanes = [&](int c, int d) { return _mm256_add_epi32(set1(c), _mm256_mullo_epi32(lane, set1(d))); };
+    const int dr = step(c0.r, c1.r), dg = step(c0.g, c1.g), db = step(c0.b, c1.b);
+    __m256i r = lanes(start(c0.r), dr), g = lanes(start(c0.g), dg), b = lanes(start(c0.b), db);
+    const __m256i drGroup = set1(dr * LANES), dgGroup = set1(dg * LANES), dbGroup = set1(db * LANES);
+    const __m256i flatR = set1(c0.r), flatG = set1(c0.g), flatB = set1(c0.b);
+
+    const __m256i setMask = set1(ctx->gp0_e6.setMaskWhileDrawing << 15);
+
+    for (int x = x0; x <= x1; x += LANES) {
+        alignas(32) int address[LANES], drawn[LANES], ditherOffset[LANES];
+        for (int i = 0; i < LANES; i++) {
+            const int px = steep ? y : x + i;
+            const int py = steep ? x + i : y;
+            // TODO: Remove insideDrawingArea calls
+            drawn[i] = (x + i <= x1 && ctx->insideDrawingArea(px, py) && ctx->drawsRow(py)) ? -1 : 0;
+            address[i] = drawn[i] ? py * gpu::VRAM_WIDTH + px : 0;
+            if constexpr (dithering) {
+                ditherOffset[i] = ditherLUT[py & 3u][px & 3u][128] - 128;
+            }
+
+            error += derror;
+            if (error > dx) {
+                y += (y1 > y0 ? 1 : -1);
+                error -= dx * 2;
+            }
+        }
+
+        __m256i cr = flatR, cg = flatG, cb = flatB;
+        if constexpr (isGouraudShaded) {
+            cr = _mm256_srai_epi32(r, 16);
+            cg = _mm256_srai_epi32(g, 16);
+            cb = _mm256_srai_epi32(b, 16);
+            r = _mm256_add_epi32(r, drGroup);
+            g = _mm256_add_epi32(g, dgGroup);
+            b = _mm256_add_epi32(b, dbGroup);
+        }
+
+        __m256i mask = _mm256_load_si256(reinterpret_cast<const __m256i*>(drawn));
+        if (_mm256_testz_si256(mask, mask)) continue;
+        const __m256i addresses = _mm256_load_si256(reinterpret_cast<const __m256i*>(address));
+
+        __m256i bg;
+        if constexpr (readsBackground) {
+            bg = gather16(ctx->vram, addresses, mask);
+        }
+        if constexpr (checkMaskBeforeDraw) {
+            mask = _mm256_andnot_si256(_mm256_cmpgt_epi32(bg, set1(0x7fff)), mask);
+        }
+
+        if constexpr (dithering) {
+            const __m256i offset = _mm256_load_si256(reinterpret_cast<const __m256i*>(ditherOffset));
+            cr = ditherChannel(cr, offset);
+            cg = ditherChannel(cg, offset);
+            cb = ditherChannel(cb, offset);
+        }
+
+        __m256i c = pack(_mm256_srli_epi32(cr, 3), _mm256_srli_epi32(cg, 3), _mm256_srli_epi32(cb, 3), _mm256_setzero_si256());
+
+        if constexpr (isSemiTransparent) {
+            c = blend(bg, c, transparency);
+        }
+
+        scatter16(ctx->vram, addresses, _mm256_or_si256(c, setMask), mask);
+    }
+}
+
+// Generate all permutations of rasterizeLineAvx2, same layout as rasterizeLineDispatchTable
+using rasterizeLine_t = void(const gpu::RenderContext* ctx, const primitive::Line& line);
+
+#define E(isSemiTransparent, isGouraudShaded, checkMaskBit, dithering) \
+    &rasterizeLineAvx2<isSemiTransparent, isGouraudShaded, checkMaskBit, dithering>
+
+static constexpr rasterizeLine_t* rasterizeLineAvx2DispatchTable[2][2][2][2] =  //
+    {{{{E(0, 0, 0, 0), E(0, 0, 0, 1)}, {E(0, 0, 1, 0), E(0, 0, 1, 1)}}, {{E(0, 1, 0, 0), E(0, 1, 0, 1)}, {E(0, 1, 1, 0), E(0, 1, 1, 1)}}},
+     {{{E(1, 0, 0, 0), E(1, 0, 0, 1)}, {E(1, 0, 1, 0), E(1, 0, 1, 1)}}, {{E(1, 1, 0, 0), E(1, 1, 0, 1)}, {E(1, 1, 1, 0), E(1, 1, 1, 1)}}}};
+#undef E
+
+void Render::drawLineAvx2(const gpu::RenderContext* ctx, const primitive::Line& line) {
+    auto isSemiTransparent = line.isSemiTransparent;
+    auto isGouraudShaded = line.gouraudShading;
+    auto checkMaskBit = ctx->gp0_e6.checkMaskBeforeDraw;
+    auto dithering = ctx->gp0_e1.dither24to15;
+
+    auto rasterize = rasterizeLineAvx2DispatchTable[isSemiTransparent][isGouraudShaded][checkMaskBit][dithering];
+
+    rasterize(ctx, line);
+}
+
+#if defined(__clang__)
+#pragma clang attribute pop
+#elif defined(__GNUC__)
+#pragma GCC pop_options
+#endif
+#endif
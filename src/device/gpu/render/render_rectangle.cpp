@@ -1,17 +1,18 @@
 #include "../primitive.h"
 #include "render.h"
+#include "span.h"
 #include "texture_utils.h"
 #include "utils/macros.h"
 
 #undef VRAM
-#define VRAM ((uint16_t(*)[gpu::VRAM_WIDTH])gpu->vram.data())
+#define VRAM ((uint16_t(*)[gpu::VRAM_WIDTH])ctx->vram)
 
 template <ColorDepth bits, bool isSemiTransparent, bool isBlended, bool checkMaskBeforeDraw>
-INLINE void rasterizeRectangle(gpu::GPU* gpu, const primitive::Rect& rect) {
+INLINE void rasterizeRectangle(const gpu::RenderContext* ctx, const primitive::Rect& rect) {
     // Extract common GPU state
-    const auto transparency = gpu->gp0_e1.semiTransparency;
-    const bool setMaskWhileDrawing = gpu->gp0_e6.setMaskWhileDrawing;
-    const auto textureWindow = gpu->gp0_e2;
+    const auto transparency = ctx->gp0_e1.semiTransparency;
+    const bool setMaskWhileDrawing = ctx->gp0_e6.setMaskWhileDrawing;
+    const auto textureWindow = ctx->gp0_e2;
     constexpr bool isTextured = bits != ColorDepth::NONE;
 
     if (rect.size.x >= 1024 || rect.size.y >= 512) return;
@@ -21,12 +22,12 @@ INLINE void rasterizeRectangle(gpu::GPU* gpu, const primitive::Rect& rect) {
         rect.pos.y    //
     );
     const ivec2 min(              //
-        gpu->minDrawingX(pos.x),  //
-        gpu->minDrawingY(pos.y)   //
+        ctx->minDrawingX(pos.x),  //
+        ctx->minDrawingY(pos.y)   //
     );
     const ivec2 max(                                //
-        gpu->maxDrawingX(pos.x + rect.size.x - 1),  //
-        gpu->maxDrawingY(pos.y + rect.size.y - 1)   //
+        ctx->maxDrawingX(pos.x + rect.size.x - 1),  //
+        ctx->maxDrawingY(pos.y + rect.size.y - 1)   //
     );
 
     ivec2 uv(                         //
@@ -36,18 +37,34 @@ INLINE void rasterizeRectangle(gpu::GPU* gpu, const primitive::Rect& rect) {
     int uStep = 1, vStep = 1;
 
     // Texture flipping
-    if (gpu->gp0_e1.texturedRectangleXFlip) {
+    if (ctx->gp0_e1.texturedRectangleXFlip) {
         uv.x += 1;
         uStep = -1;
     }
-    if (gpu->gp0_e1.texturedRectangleYFlip) {
+    if (ctx->gp0_e1.texturedRectangleYFlip) {
         vStep = -1;
     }
 
-    loadClutCacheIfRequired<bits>(gpu, rect.clut);
+    loadClutCacheIfRequired<bits>(ctx, rect.clut);
+    markDrawn(ctx, min, max);
+
+    // Opaque flat rectangle is a fill of row spans
+    if constexpr (bits == ColorDepth::NONE && !isSemiTransparent && !checkMaskBeforeDraw) {
+        PSXColor c(rect.color.r, rect.color.g, rect.color.b);
+        c.k |= setMaskWhileDrawing;
+
+        for (int y = min.y; y <= max.y; y++) {
+            if (!ctx->drawsRow(y)) continue;
+            fillSpan(&VRAM[y][min.x], max.x - min.x + 1, c.raw);
+        }
+        return;
+    }
+
+    const uint16_t* texels = decodedTexturePage<bits>(ctx, rect.texpage, min, max);
 
     int x, y, u, v;
     for (y = min.y, v = uv.y; y <= max.y; y++, v += vStep) {
+        if (!ctx->drawsRow(y)) continue;
         for (x = min.x, u = uv.x; x <= max.x; x++, u += uStep) {
             PSXColor bg = VRAM[y][x];
             if constexpr (checkMaskBeforeDraw) {
@@ -59,7 +76,7 @@ INLINE void rasterizeRectangle(gpu::GPU* gpu, const primitive::Rect& rect) {
                 c = PSXColor(rect.color.r, rect.color.g, rect.color.b);
             } else {
                 const ivec2 texel = maskTexel(ivec2(u, v), textureWindow);
-                c = fetchTex<bits>(gpu, texel, rect.texpage);
+                c = fetchTex<bits>(ctx, texels, texel, rect.texpage);
                 if (c.raw == 0x0000) continue;
 
                 if constexpr (isBlended) {
@@ -81,7 +98,7 @@ INLINE void rasterizeRectangle(gpu::GPU* gpu, const primitive::Rect& rect) {
 }
 
 // Generate all permutations of rasterizeRectangle
-using rasterizeRectangle_t = void(gpu::GPU* gpu, const primitive::Rect& rect);
+using rasterizeRectangle_t = void(const gpu::RenderContext* ctx, const primitive::Rect& rect);
 
 #define E(bits, isSemiTransparent, isBlended, checkMaskBit) \
     &rasterizeRectangle<bitsToDepth<bits>(), isSemiTransparent, isBlended, checkMaskBit>
@@ -110,13 +127,28 @@ static constexpr rasterizeRectangle_t* rasterizeRectangleDispatchTable[4][2][2][
       {{E(16, 1, 0, 0), E(16, 1, 0, 1)}, {E(16, 1, 1, 0), E(16, 1, 1, 1)}}}};
 #undef E
 
-void Render::drawRectangle(gpu::GPU* gpu, const primitive::Rect& rect) {
+void Render::drawRectangleReference(const gpu::RenderContext* ctx, const primitive::Rect& rect) {
     auto bits = (int)bitsToDepth(rect.bits);
     auto isSemiTransparent = rect.isSemiTransparent;
     auto isBlended = !rect.isRawTexture;
-    auto checkMaskBit = gpu->gp0_e6.checkMaskBeforeDraw;
+    auto checkMaskBit = ctx->gp0_e6.checkMaskBeforeDraw;
 
     auto rasterize = rasterizeRectangleDispatchTable[bits][isSemiTransparent][isBlended][checkMaskBit];
 
-    rasterize(gpu, rect);
-}
\ No newline at end of file
+    rasterize(ctx, rect);
+}
+
+void Render::drawRectangle(const gpu::RenderContext* ctx, const primitive::Rect& rect) {
+#ifdef CPU_FEATURES_X64
+    if (cpu_features::hasAvx2()) {
+        drawRectangleAvx2(ctx, rect);
+        return;
+    }
+#endif
+    drawRectangleReference(ctx, rect);
+}
+
+void Render::drawRectangle(gpu::GPU* gpu, const primitive::Rect& rect) {
+    auto ctx = gpu->renderContext();
+    drawRectangle(&ctx, rect);
+}
@@ -0,0 +1,168 @@
+#include "render.h"
+#ifdef CPU_FEATURES_X64
+#include <immintrin.h>
+#include <algorithm>
+#include "texture_utils.h"
+#include "utils/macros.h"
+
+// Functions below are compiled for AVX2 and only called after runtime check, shared headers above stay at baseline
+#if defined(__clang__)
+#pragma clang attribute push(__attribute__((target("avx2"))), apply_to = function)
+#elif defined(__GNUC__)
+#pragma GCC push_options
+#pragma GCC target("avx2")
+#endif
+#include "avx2_utils.h"
+
+/**
+ * AVX2 version of rasterizeRectangle, must produce exactly the same pixels.
+ *
+ * Lanes hold 8 consecutive pixels of a row. Whole groups are read and written back with single loads and stores
+ * (pixels which are not drawn keep the background), the group at the right edge is written pixel by pixel
+ * so no pixel outside of the rectangle is touched.
+ */
+namespace {
+const int LANES = 8;
+}  // namespace
+
+template <ColorDepth bits, bool isSemiTransparent, bool isBlended, bool checkMaskBeforeDraw>
+void rasterizeRectangleAvx2(const gpu::RenderContext* ctx, const primitive::Rect& rect) {
+    // Extract common GPU state
+    const auto transparency = ctx->gp0_e1.semiTransparency;
+    const auto textureWindow = ctx->gp0_e2;
+    constexpr bool isTextured = bits != ColorDepth::NONE;
+    constexpr bool readsBackground = isSemiTransparent || checkMaskBeforeDraw;
+
+    if (rect.size.x >= 1024 || rect.size.y >= 512) return;
+
+    const ivec2 min(ctx->minDrawingX(rect.pos.x), ctx->minDrawingY(rect.pos.y));
+    const ivec2 max(ctx->maxDrawingX(rect.pos.x + rect.size.x - 1), ctx->maxDrawingY(rect.pos.y + rect.size.y - 1));
+
+    ivec2 uv(                              //
+        rect.uv.x + (min.x - rect.pos.x),  // Add offset if part of rectange was cut off
+        rect.uv.y + (min.y - rect.pos.y)   //
+    );
+    int uStep = 1, vStep = 1;
+
+    // Texture flipping
+    if (ctx->gp0_e1.texturedRectangleXFlip) {
+        uv.x += 1;
+        uStep = -1;
+    }
+    if (ctx->gp0_e1.texturedRectangleYFlip) {
+        vStep = -1;
+    }
+
+    loadClutCacheIfRequired<bits>(ctx, rect.clut);
+    markDrawn(ctx, min, max);
+    const uint16_t* texels = decodedTexturePage<bits>(ctx, rect.texpage, min, max);
+
+    const __m256i flatColor = set1(PSXColor(rect.color.r, rect.color.g, rect.color.b).raw);
+    const __m256i colorR = set1(rect.color.r), colorG = set1(rect.color.g), colorB = set1(rect.color.b);
+    const __m256i setMask = set1(ctx->gp0_e6.setMaskWhileDrawing << 15);
+
+    // See maskTexel
+    const __m256i windowAndX = set1(0xff & ~(textureWindow.maskX * 8)), windowOrX = set1((textureWindow.offsetX & textureWindow.maskX) * 8);
+    const __m256i windowAndY = set1(0xff & ~(textureWindow.maskY * 8)), windowOrY = set1((textureWindow.offsetY & textureWindow.maskY) * 8);
+    const __m256i texPageX = set1(rect.texpage.x), texPageY = set1(rect.texpage.y);
+
+    const __m256i lane = _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7);
+    const __m256i laneU = _mm256_mullo_epi32(lane, set1(uStep));
+
+    int y, v;
+    for (y = min.y, v = uv.y; y <= max.y; y++, v += vStep) {
+        if (!ctx->drawsRow(y)) continue;
+        uint16_t* row = &ctx->vram[y * gpu::VRAM_WIDTH];
+        const __m256i tv = _mm256_or_si256(_mm256_and_si256(set1(v), windowAndY), windowOrY);
+
+        for (int x = min.x; x <= max.x; x += LANES) {
+            const bool isWholeGroup = x + LANES - 1 <= max.x;
+            const __m256i address = _mm256_add_epi32(set1(y * gpu::VRAM_WIDTH + x), lane);
+            __m256i mask = _mm256_cmpgt_epi32(set1(max.x - x + 1), lane);
+
+            __m256i bg = _mm256_setzero_si256();
+            if (isWholeGroup) {
+                bg = load8(row + x);
+            } else if constexpr (readsBackground) {
+                bg = gather16(ctx->vram, address, mask);
+            }
+            if constexpr (checkMaskBeforeDraw) {
+                mask = _mm256_andnot_si256(_mm256_cmpgt_epi32(bg, set1(0x7fff)), mask);
+            }
+
+            __m256i c;
+            if constexpr (bits == ColorDepth::NONE) {
+                c = flatColor;
+            } else {
+                const __m256i u = _mm256_add_epi32(set1(uv.x + (x - min.x) * uStep), laneU);
+                const __m256i tu = _mm256_or_si256(_mm256_and_si256(u, windowAndX), windowOrX);
+                c = fetchTexAvx2<bits>(ctx, texels, tu, tv, texPageX, texPageY, mask);
+                mask = _mm256_andnot_si256(_mm256_cmpeq_epi32(c, _mm256_setzero_si256()), mask);
+
+                if constexpr (isBlended) {
+                    c = modulate(c, colorR, colorG, colorB);
+                }
+            }
+
+            if constexpr (isSemiTransparent) {
+                __m256i blended = blend(bg, c, transparency);
+                if constexpr (isTextured) {
+                    // Only texels with mask bit set are semi-transparent
+                    c = _mm256_blendv_epi8(c, blended, _mm256_cmpgt_epi32(c, set1(0x7fff)));
+                } else {
+                    c = blended;
+                }
+            }
+
+            c = _mm256_or_si256(c, setMask);
+
+            if (isWholeGroup) {
+                store8(row + x, _mm256_blendv_epi8(bg, c, mask));
+            } else {
+                scatter16(ctx->vram, address, c, mask);
+            }
+        }
+    }
+}
+
+// Generate all permutations of rasterizeRectangleAvx2, same layout as rasterizeRectangleDispatchTable
+using rasterizeRectangle_t = void(const gpu::RenderContext* ctx, const primitive::Rect& rect);
+
+#define E(bits, isSemiTransparent, isBlended, checkMaskBit) \
+    &rasterizeRectangleAvx2<bitsToDepth<bits>(), isSemiTransparent, isBlended, checkMaskBit>
+
+static constexpr rasterizeRectangle_t* rasterizeRectangleAvx2DispatchTable[4][2][2][2] =  //
+    {{{{E(0, 0, 0, 0), E(0, 0, 0, 1)}, {E(0, 0, 1, 0), E(0, 0, 1, 1)}}, {{E(0, 1, 0, 0), E(0, 1, 0, 1)}, {E(0, 1, 1, 0), E(0, 1, 1, 1)}}},
+     {{{E(4, 0, 0, 0), E(4, 0, 0, 1)}, {E(4, 0, 1, 0), E(4, 0, 1, 1)}}, {{E(4, 1, 0, 0), E(4, 1, 0, 1)}, {E(4, 1, 1, 0), E(4, 1, 1, 1)}}},
+     {{{E(8, 0, 0, 0), E(8, 0, 0, 1)}, {E(8, 0, 1, 0), E(8, 0, 1, 1)}}, {{E(8, 1, 0, 0), E(8, 1, 0, 1)}, {E(8, 1, 1, 0), E(8, 1, 1, 1)}}},
+     {{{E(16, 0, 0, 0), E(16, 0, 0, 1)}, {E(16, 0, 1, 0), E(16, 0, 1, 1)}},
+      {{E(16, 1, 0, 0), E(16, 1, 0, 1)}, {E(16, 1, 1, 0), E(16, 1, 1, 1)}}}};
+#undef E
+
+void Render::drawRectangleAvx2(const gpu::RenderContext* ctx, const primitive::Rect& rect) {
+    auto bits = (int)bitsToDepth(rect.bits);
+    auto isSemiTransparent = rect.isSemiTransparent;
+    auto isBlended = !rect.isRawTexture;
+    auto checkMaskBit = ctx->gp0_e6.checkMaskBeforeDraw;
+
+    // Opaque flat rectangles are filled with spans
+    const bool isFill = bits == 0 && !isSemiTransparent && !checkMaskBit;
+
+    const ivec2 min(ctx->minDrawingX(rect.pos.x), ctx->minDrawingY(rect.pos.y));
+    const ivec2 max(ctx->maxDrawingX(rect.pos.x + rect.size.x - 1), ctx->maxDrawingY(rect.pos.y + rect.size.y - 1));
+    if (isFill || samplesOwnOutput(rect.bits, rect.texpage, min, max)) {
+        drawRectangleReference(ctx, rect);
+        return;
+    }
+
+    auto rasterize = rasterizeRectangleAvx2DispatchTable[bits][isSemiTransparent][isBlended][checkMaskBit];
+
+    rasterize(ctx, rect);
+}
+
+#if defined(__clang__)
+#pragma clang attribute pop
+#elif defined(__GNUC__)
+#pragma GCC pop_options
+#endif
+#endif
@@ -0,0 +1,289 @@
+#include "render.h"
+#ifdef CPU_FEATURES_X64
+#include <immintrin.h>
+#include <algorithm>
+#include "dither.h"
+#include "texture_utils.h"
+#include "triangle_setup.h"
+#include "utils/macros.h"
+
+// Functions below are compiled for AVX2 and only called after runtime check, shared headers above stay at baseline
+#if defined(__clang__)
+#pragma clang attribute push(__attribute__((target("avx2"))), apply_to = function)
+#elif defined(__GNUC__)
+#pragma GCC push_options
+#pragma GCC target("avx2")
+#endif
+#include "avx2_utils.h"
+
+/**
+ * AVX2 version of rasterizeTriangle, must produce exactly the same pixels.
+ *
+ * Triangle is walked in 8 lines high strips (rows of tiles), lanes hold 8 consecutive rows and step
+ * from left to right like the scalar rasterizer. Fixed point attributes are stepped modulo 2^32, so lane start values
+ * can be calculated with a multiplication.
+ */
+namespace {
+const int LANES = 8;
+static_assert(LANES == TILE_SIZE, "Strips have to match tile rows");
+
+// Same as attributeValue
+INLINE __m256i attributeValueAvx2(__m256i a) {
+    return _mm256_min_epi32(_mm256_max_epi32(_mm256_srai_epi32(a, ATTRIBUTE_PRECISION), _mm256_setzero_si256()), set1(255));
+}
+}  // namespace
+
+template <ColorDepth bits, bool isSemiTransparent, bool isGouraudShaded, bool isBlended, bool checkMaskBeforeDraw, bool dithering>
+void rasterizeTriangleAvx2(const gpu::RenderContext* ctx, const primitive::Triangle& triangle) {
+    // Extract common GPU state
+    const auto transparency = triangle.transparency;
+    const auto textureWindow = ctx->gp0_e2;
+    constexpr bool isTextured = bits != ColorDepth::NONE;
+    constexpr bool isDithered = dithering && isBlended && isGouraudShaded;  // Flat color is never dithered
+    constexpr bool readsBackground = isSemiTransparent || checkMaskBeforeDraw;
+
+    if (orient2d(triangle.v[0].pos, triangle.v[1].pos, triangle.v[2].pos) == 0) return;
+
+    loadClutCacheIfRequired<bits>(ctx, triangle.clut);
+
+    TriangleSetup s;
+    if (!setupTriangle<isGouraudShaded, isTextured>(ctx, triangle, s)) return;
+
+    markDrawn(ctx, s.min, s.max);
+    const uint16_t* texels = decodedTexturePage<bits>(ctx, triangle.texpage, s.min, s.max);
+    const RGB colorFlat = triangle.v[0].color;
+    const __m256i flatR = set1(colorFlat.r), flatG = set1(colorFlat.g), flatB = set1(colorFlat.b);
+    const __m256i flatColor = set1(PSXColor(colorFlat).raw);
+    const __m256i setMask = set1(ctx->gp0_e6.setMaskWhileDrawing << 15);
+
+    // See maskTexel
+    const __m256i windowAndX = set1(0xff & ~(textureWindow.maskX * 8)), windowOrX = set1((textureWindow.offsetX & textureWindow.maskX) * 8);
+    const __m256i windowAndY = set1(0xff & ~(textureWindow.maskY * 8)), windowOrY = set1((textureWindow.offsetY & textureWindow.maskY) * 8);
+    const __m256i texPageX = set1(triangle.texpage.x), texPageY = set1(triangle.texpage.y);
+
+    const __m256i lane = _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7);
+    const AttributeDeltas& deltas = s.deltas;
+
+    // Steps to next pixel and over whole tile (r, g, b, u, v)
+    const __m256i dx[3] = {set1(s.D12.y), set1(s.D20.y), set1(s.D01.y)};
+    const __m256i dxTile[3] = {set1(s.D12.y * TILE_SIZE), set1(s.D20.y * TILE_SIZE), set1(s.D01.y * TILE_SIZE)};
+    const __m256i dAttrib[5] = {set1(deltas.r.x), set1(deltas.g.x), set1(deltas.b.x), set1(deltas.u.x), set1(deltas.v.x)};
+    const __m256i dAttribTile[5] = {set1(deltas.r.x * TILE_SIZE), set1(deltas.g.x * TILE_SIZE), set1(deltas.b.x * TILE_SIZE),
+                                    set1(deltas.u.x * TILE_SIZE), set1(deltas.v.x * TILE_SIZE)};
+
+    // Start value of every lane
+    const auto rows = [&](int start, int delta) { return _mm256_add_epi32(set1(start), _mm256_mullo_epi32(lane, set1(delta))); };
+
+    int CY[3] = {s.CY[0], s.CY[1], s.CY[2]};
+    Attributes startAttributes = s.attributes;
+
+    for (int y0 = s.min.y; y0 <= s.max.y; y0 += LANES) {
+        alignas(32) int laneMask[LANES];
+        for (int i = 0; i < LANES; i++) {
+            laneMask[i] = (y0 + i <= s.max.y && ctx->drawsRow(y0 + i)) ? -1 : 0;
+        }
+        const __m256i drawnRows = _mm256_load_si256(reinterpret_cast<const __m256i*>(laneMask));
+
+        __m256i CX[3] = {rows(CY[0], s.D12.x), rows(CY[1], s.D20.x), rows(CY[2], s.D01.x)};
+        __m256i r = rows(startAttributes.r, deltas.r.y), g = rows(startAttributes.g, deltas.g.y), b = rows(startAttributes.b, deltas.b.y);
+        __m256i u = rows(startAttributes.u, deltas.u.y), v = rows(startAttributes.v, deltas.v.y);
+
+        CY[0] += s.D12.x * LANES;
+        CY[1] += s.D20.x * LANES;
+        CY[2] += s.D01.x * LANES;
+        addYDeltas<isGouraudShaded, isTextured>(startAttributes, deltas, LANES);
+
+        if (_mm256_testz_si256(drawnRows, drawnRows)) continue;
+
+        const __m256i rowAddress = _mm256_slli_epi32(_mm256_add_epi32(set1(y0), lane), 10);
+
+        // Dither offsets for x & 3
+        __m256i ditherOffset[4];
+        if constexpr (isDithered) {
+            for (int x = 0; x < 4; x++) {
+                alignas(32) int offset[LANES];
+                for (int i = 0; i < LANES; i++) offset[i] = ditherLUT[(y0 + i) & 3][x][128] - 128;
+                ditherOffset[x] = _mm256_load_si256(reinterpret_cast<const __m256i*>(offset));
+            }
+        }
+
+        const auto step = [&](const __m256i* dEdge, const __m256i* d) {
+            CX[0] = _mm256_add_epi32(CX[0], dEdge[0]);
+            CX[1] = _mm256_add_epi32(CX[1], dEdge[1]);
+            CX[2] = _mm256_add_epi32(CX[2], dEdge[2]);
+            if constexpr (isGouraudShaded) {
+                r = _mm256_add_epi32(r, d[0]);
+                g = _mm256_add_epi32(g, d[1]);
+                b = _mm256_add_epi32(b, d[2]);
+            }
+            if constexpr (isTextured) {
+                u = _mm256_add_epi32(u, d[3]);
+                v = _mm256_add_epi32(v, d[4]);
+            }
+        };
+
+        for (int x0 = s.min.x; x0 <= s.max.x; x0 += TILE_SIZE) {
+            const TileCoverage coverage = classifyTile(s, x0, y0);
+            if (coverage == TileCoverage::Outside) {
+                step(dxTile, dAttribTile);
+                continue;
+            }
+
+            // Inside tiles are drawn without edge tests
+            const int x1 = std::min(x0 + TILE_SIZE - 1, s.max.x);
+            for (int x = x0; x <= x1; x++) {
+                __m256i mask = drawnRows;
+                if (coverage == TileCoverage::Partial) {
+                    __m256i edges = _mm256_or_si256(_mm256_or_si256(CX[0], CX[1]), CX[2]);
+                    mask = _mm256_and_si256(_mm256_cmpgt_epi32(edges, _mm256_setzero_si256()), mask);
+                }
+
+                if (!_mm256_testz_si256(mask, mask)) {
+                    const __m256i address = _mm256_add_epi32(rowAddress, set1(x));
+
+                    __m256i bg;
+                    if constexpr (readsBackground) {
+                        bg = gather16(ctx->vram, address, mask);
+                    }
+                    if constexpr (checkMaskBeforeDraw) {
+                        mask = _mm256_andnot_si256(_mm256_cmpgt_epi32(bg, set1(0x7fff)), mask);
+                    }
+
+                    __m256i cr, cg, cb;
+                    if constexpr (isGouraudShaded) {
+                        cr = attributeValueAvx2(r);
+                        cg = attributeValueAvx2(g);
+                        cb = attributeValueAvx2(b);
+                        if constexpr (isDithered) {
+                            cr = ditherChannel(cr, ditherOffset[x & 3]);
+                            cg = ditherChannel(cg, ditherOffset[x & 3]);
+                            cb = ditherChannel(cb, ditherOffset[x & 3]);
+                        }
+                    } else {
+                        cr = flatR, cg = flatG, cb = flatB;
+                    }
+
+                    __m256i c;
+                    if constexpr (bits == ColorDepth::NONE) {
+                        if constexpr (!isGouraudShaded) {
+                            c = flatColor;
+                        } else {
+                            c = pack(_mm256_srli_epi32(cr, 3), _mm256_srli_epi32(cg, 3), _mm256_srli_epi32(cb, 3), _mm256_setzero_si256());
+                        }
+                    } else {
+                        __m256i tu = _mm256_or_si256(_mm256_and_si256(attributeValueAvx2(u), windowAndX), windowOrX);
+                        __m256i tv = _mm256_or_si256(_mm256_and_si256(attributeValueAvx2(v), windowAndY), windowOrY);
+                        c = fetchTexAvx2<bits>(ctx, texels, tu, tv, texPageX, texPageY, mask);
+                        mask = _mm256_andnot_si256(_mm256_cmpeq_epi32(c, _mm256_setzero_si256()), mask);
+
+                        if constexpr (isBlended) {
+                            c = modulate(c, cr, cg, cb);
+                        }
+                    }
+
+                    if constexpr (isSemiTransparent) {
+                        __m256i blended = blend(bg, c, transparency);
+                        if constexpr (isTextured) {
+                            // Only texels with mask bit set are semi-transparent
+                            c = _mm256_blendv_epi8(c, blended, _mm256_cmpgt_epi32(c, set1(0x7fff)));
+                        } else {
+                            c = blended;
+                        }
+                    }
+
+                    scatter16(ctx->vram, address, _mm256_or_si256(c, setMask), mask);
+                }
+
+                step(dx, dAttrib);
+            }
+        }
+    }
+}
+
+// Generate all permutations of rasterizeTriangleAvx2, same layout as rasterizeTriangleDispatchTable
+using rasterizeTriangle_t = void(const gpu::RenderContext* ctx, const primitive::Triangle& triangle);
+
+#define E(bits, isSemiTransparent, isGouraudShaded, isBlended, checkMaskBit, dithering) \
+    &rasterizeTriangleAvx2<bitsToDepth<bits>(), isSemiTransparent, isGouraudShaded, isBlended, checkMaskBit, dithering>
+
+/* Kotlin script for lookup array generation:
+
+    fun Iterable<Int>.wrap(f: (Int) -> String): String =
+        "{" + joinToString(",", transform = f) + "}"
+
+    fun generateTable(): String =
+        setOf(0, 4, 8, 16).wrap { bits ->
+        (0..1).wrap { isSemiTransparent ->
+        (0..1).wrap { isGouraudShaded ->
+        (0..1).wrap { isBlended ->
+        (0..1).wrap { checkMaskBit ->
+        (0..1).wrap { dithering ->
+            "E($bits, $isSemiTransparent, $isGouraudShaded, $isBlended, $checkMaskBit, $dithering)"
+        }}}}}}
+
+    generateTable()
+*/
+
+static constexpr rasterizeTriangle_t* rasterizeTriangleAvx2DispatchTable[4][2][2][2][2][2] =  //
+    {{{{{{E(0, 0, 0, 0, 0, 0), E(0, 0, 0, 0, 0, 1)}, {E(0, 0, 0, 0, 1, 0), E(0, 0, 0, 0, 1, 1)}},
+        {{E(0, 0, 0, 1, 0, 0), E(0, 0, 0, 1, 0, 1)}, {E(0, 0, 0, 1, 1, 0), E(0, 0, 0, 1, 1, 1)}}},
+       {{{E(0, 0, 1, 0, 0, 0), E(0, 0, 1, 0, 0, 1)}, {E(0, 0, 1, 0, 1, 0), E(0, 0, 1, 0, 1, 1)}},
+        {{E(0, 0, 1, 1, 0, 0), E(0, 0, 1, 1, 0, 1)}, {E(0, 0, 1, 1, 1, 0), E(0, 0, 1, 1, 1, 1)}}}},
+      {{{{E(0, 1, 0, 0, 0, 0), E(0, 1, 0, 0, 0, 1)}, {E(0, 1, 0, 0, 1, 0), E(0, 1, 0, 0, 1, 1)}},
+        {{E(0, 1, 0, 1, 0, 0), E(0, 1, 0, 1, 0, 1)}, {E(0, 1, 0, 1, 1, 0), E(0, 1, 0, 1, 1, 1)}}},
+       {{{E(0, 1, 1, 0, 0, 0), E(0, 1, 1, 0, 0, 1)}, {E(0, 1, 1, 0, 1, 0), E(0, 1, 1, 0, 1, 1)}},
+        {{E(0, 1, 1, 1, 0, 0), E(0, 1, 1, 1, 0, 1)}, {E(0, 1, 1, 1, 1, 0), E(0, 1, 1, 1, 1, 1)}}}}},
+     {{{{{E(4, 0, 0, 0, 0, 0), E(4, 0, 0, 0, 0, 1)}, {E(4, 0, 0, 0, 1, 0), E(4, 0, 0, 0, 1, 1)}},
+        {{E(4, 0, 0, 1, 0, 0), E(4, 0, 0, 1, 0, 1)}, {E(4, 0, 0, 1, 1, 0), E(4, 0, 0, 1, 1, 1)}}},
+       {{{E(4, 0, 1, 0, 0, 0), E(4, 0, 1, 0, 0, 1)}, {E(4, 0, 1, 0, 1, 0), E(4, 0, 1, 0, 1, 1)}},
+        {{E(4, 0, 1, 1, 0, 0), E(4, 0, 1, 1, 0, 1)}, {E(4, 0, 1, 1, 1, 0), E(4, 0, 1, 1, 1, 1)}}}},
+      {{{{E(4, 1, 0, 0, 0, 0), E(4, 1, 0, 0, 0, 1)}, {E(4, 1, 0, 0, 1, 0), E(4, 1, 0, 0, 1, 1)}},
+        {{E(4, 1, 0, 1, 0, 0), E(4, 1, 0, 1, 0, 1)}, {E(4, 1, 0, 1, 1, 0), E(4, 1, 0, 1, 1, 1)}}},
+       {{{E(4, 1, 1, 0, 0, 0), E(4, 1, 1, 0, 0, 1)}, {E(4, 1, 1, 0, 1, 0), E(4, 1, 1, 0, 1, 1)}},
+        {{E(4, 1, 1, 1, 0, 0), E(4, 1, 1, 1, 0, 1)}, {E(4, 1, 1, 1, 1, 0), E(4, 1, 1, 1, 1, 1)}}}}},
+     {{{{{E(8, 0, 0, 0, 0, 0), E(8, 0, 0, 0, 0, 1)}, {E(8, 0, 0, 0, 1, 0), E(8, 0, 0, 0, 1, 1)}},
+        {{E(8, 0, 0, 1, 0, 0), E(8, 0, 0, 1, 0, 1)}, {E(8, 0, 0, 1, 1, 0), E(8, 0, 0, 1, 1, 1)}}},
+       {{{E(8, 0, 1, 0, 0, 0), E(8, 0, 1, 0, 0, 1)}, {E(8, 0, 1, 0, 1, 0), E(8, 0, 1, 0, 1, 1)}},
+        {{E(8, 0, 1, 1, 0, 0), E(8, 0, 1, 1, 0, 1)}, {E(8, 0, 1, 1, 1, 0), E(8, 0, 1, 1, 1, 1)}}}},
+      {{{{E(8, 1, 0, 0, 0, 0), E(8, 1, 0, 0, 0, 1)}, {E(8, 1, 0, 0, 1, 0), E(8, 1, 0, 0, 1, 1)}},
+        {{E(8, 1, 0, 1, 0, 0), E(8, 1, 0, 1, 0, 1)}, {E(8, 1, 0, 1, 1, 0), E(8, 1, 0, 1, 1, 1)}}},
+       {{{E(8, 1, 1, 0, 0, 0), E(8, 1, 1, 0, 0, 1)}, {E(8, 1, 1, 0, 1, 0), E(8, 1, 1, 0, 1, 1)}},
+        {{E(8, 1, 1, 1, 0, 0), E(8, 1, 1, 1, 0, 1)}, {E(8, 1, 1, 1, 1, 0), E(8, 1, 1, 1, 1, 1)}}}}},
+     {{{{{E(16, 0, 0, 0, 0, 0), E(16, 0, 0, 0, 0, 1)}, {E(16, 0, 0, 0, 1, 0), E(16, 0, 0, 0, 1, 1)}},
+        {{E(16, 0, 0, 1, 0, 0), E(16, 0, 0, 1, 0, 1)}, {E(16, 0, 0, 1, 1, 0), E(16, 0, 0, 1, 1, 1)}}},
+       {{{E(16, 0, 1, 0, 0, 0), E(16, 0, 1, 0, 0, 1)}, {E(16, 0, 1, 0, 1, 0), E(16, 0, 1, 0, 1, 1)}},
+        {{E(16, 0, 1, 1, 0, 0), E(16, 0, 1, 1, 0, 1)}, {E(16, 0, 1, 1, 1, 0), E(16, 0, 1, 1, 1, 1)}}}},
+      {{{{E(16, 1, 0, 0, 0, 0), E(16, 1, 0, 0, 0, 1)}, {E(16, 1, 0, 0, 1, 0), E(16, 1, 0, 0, 1, 1)}},
+        {{E(16, 1, 0, 1, 0, 0), E(16, 1, 0, 1, 0, 1)}, {E(16, 1, 0, 1, 1, 0), E(16, 1, 0, 1, 1, 1)}}},
+       {{{E(16, 1, 1, 0, 0, 0), E(16, 1, 1, 0, 0, 1)}, {E(16, 1, 1, 0, 1, 0), E(16, 1, 1, 0, 1, 1)}},
+        {{E(16, 1, 1, 1, 0, 0), E(16, 1, 1, 1, 0, 1)}, {E(16, 1, 1, 1, 1, 0), E(16, 1, 1, 1, 1, 1)}}}}}};
+#undef E
+
+void Render::drawTriangleAvx2(const gpu::RenderContext* ctx, const primitive::Triangle& triangle) {
+    const ivec2 min(ctx->minDrawingX(std::min({triangle.v[0].pos.x, triangle.v[1].pos.x, triangle.v[2].pos.x})),
+                    ctx->minDrawingY(std::min({triangle.v[0].pos.y, triangle.v[1].pos.y, triangle.v[2].pos.y})));
+    const ivec2 max(ctx->maxDrawingX(std::max({triangle.v[0].pos.x, triangle.v[1].pos.x, triangle.v[2].pos.x})),
+                    ctx->maxDrawingY(std::max({triangle.v[0].pos.y, triangle.v[1].pos.y, triangle.v[2].pos.y})));
+    if (samplesOwnOutput(triangle.bits, triangle.texpage, min, max)) {
+        drawTriangleReference(ctx, triangle);
+        return;
+    }
+
+    auto bits = (int)bitsToDepth(triangle.bits);
+    auto isSemiTransparent = triangle.isSemiTransparent;
+    auto isGouraudShaded = triangle.gouraudShading;
+    auto isBlended = !triangle.isRawTexture;
+    auto checkMaskBit = ctx->gp0_e6.checkMaskBeforeDraw;
+    auto dithering = ctx->gp0_e1.dither24to15;
+
+    auto rasterize = rasterizeTriangleAvx2DispatchTable[bits][isSemiTransparent][isGouraudShaded][isBlended][checkMaskBit][dithering];
+
+    rasterize(ctx, triangle);
+}
+
+#if defined(__clang__)
+#pragma clang attribute pop
+#elif defined(__GNUC__)
+#pragma GCC pop_options
+#endif
+#endif
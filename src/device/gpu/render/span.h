@@ -0,0 +1,25 @@
+#pragma once
+#include <cstdint>
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+// Fills n pixels of VRAM row, compilers don't reliably vectorize this loop on their own
+inline void fillSpan(uint16_t* dst, int n, uint16_t color) {
+    int i = 0;
+#if defined(__SSE2__)
+    const __m128i c = _mm_set1_epi16(static_cast<int16_t>(color));
+    for (; i + 32 <= n; i += 32) {
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i), c);
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i + 8), c);
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i + 16), c);
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i + 24), c);
+    }
+    for (; i + 8 <= n; i += 8) {
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i), c);
+    }
+#endif
+    for (; i < n; i++) {
+        dst[i] = color;
+    }
+}
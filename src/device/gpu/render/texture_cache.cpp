@@ -0,0 +1,96 @@
+#include "texture_cache.h"
+#include <algorithm>
+
+namespace gpu {
+
+namespace {
+// Width of texture page in VRAM halfwords
+int pageWidth(ColorDepth bits) { return bits == ColorDepth::BIT_4 ? 64 : 128; }
+
+// Both ranges wrap around at size
+bool overlaps(int a, int aSize, int b, int bSize, int size) {
+    if (aSize <= 0 || bSize <= 0) return false;
+    if (aSize >= size || bSize >= size) return true;
+
+    int d = ((b - a) % size + size) % size;
+    return d < aSize || (size - d) % size < bSize;
+}
+}  // namespace
+
+void TextureCache::decode(const RenderContext* ctx, Entry& entry) {
+    auto vram = (const uint16_t(*)[VRAM_WIDTH])ctx->vram;
+    const auto& palette = ctx->clutCache->entries;
+
+    entry.texels.resize(PAGE_SIZE * PAGE_SIZE + 1);
+    for (int y = 0; y < PAGE_SIZE; y++) {
+        const uint16_t* row = vram[(entry.texpage.y + y) & (VRAM_HEIGHT - 1)];
+        uint16_t* out = &entry.texels[y * PAGE_SIZE];
+
+        if (entry.bits == ColorDepth::BIT_4) {
+            for (int x = 0; x < PAGE_SIZE / 4; x++) {
+                uint16_t index = row[(entry.texpage.x + x) & (VRAM_WIDTH - 1)];
+                for (int i = 0; i < 4; i++) {
+                    out[x * 4 + i] = palette[(index >> (i * 4)) & 0xf];
+                }
+            }
+        } else {
+            for (int x = 0; x < PAGE_SIZE / 2; x++) {
+                uint16_t index = row[(entry.texpage.x + x) & (VRAM_WIDTH - 1)];
+                out[x * 2 + 0] = palette[index & 0xff];
+                out[x * 2 + 1] = palette[index >> 8];
+            }
+        }
+    }
+    entry.decoded = true;
+}
+
+const uint16_t* TextureCache::get(const RenderContext* ctx, ColorDepth bits, ivec2 texpage, ivec2 min, ivec2 max) {
+    const int w = max.x - min.x + 1;
+    const int h = max.y - min.y + 1;
+    if (w <= 0 || h <= 0) return nullptr;
+
+    // Texels drawn earlier by the same primitive have to be visible
+    if (overlaps(texpage.x, pageWidth(bits), min.x, w, VRAM_WIDTH) && overlaps(texpage.y, PAGE_SIZE, min.y, h, VRAM_HEIGHT)) {
+        return nullptr;
+    }
+
+    const uint32_t clutGeneration = ctx->clutCache->generation;
+    auto entry = std::find_if(entries.begin(), entries.end(), [&](const Entry& e) {
+        return e.texpage == texpage && e.bits == bits && e.clutGeneration == clutGeneration;
+    });
+    if (entry == entries.end()) {
+        entry = std::min_element(entries.begin(), entries.end(), [](const Entry& a, const Entry& b) { return a.lastUse < b.lastUse; });
+        entry->texpage = texpage;
+        entry->bits = bits;
+        entry->clutGeneration = clutGeneration;
+        entry->pixels = 0;
+        entry->decoded = false;
+    }
+    entry->lastUse = ++useCounter;
+
+    if (!entry->decoded) {
+        entry->pixels += w * h;
+        if (entry->pixels < PAGE_SIZE * PAGE_SIZE) return nullptr;
+        decode(ctx, *entry);
+    }
+    return entry->texels.data();
+}
+
+void TextureCache::markDirty(int x, int y, int w, int h) {
+    for (auto& entry : entries) {
+        if (entry.bits == ColorDepth::NONE) continue;
+        if (overlaps(entry.texpage.x, pageWidth(entry.bits), x, w, VRAM_WIDTH) && overlaps(entry.texpage.y, PAGE_SIZE, y, h, VRAM_HEIGHT)) {
+            entry.pixels = 0;
+            entry.decoded = false;
+        }
+    }
+}
+
+void TextureCache::invalidate() {
+    for (auto& entry : entries) {
+        entry.pixels = 0;
+        entry.decoded = false;
+    }
+}
+
+}  // namespace gpu
@@ -0,0 +1,47 @@
+#pragma once
+#include <array>
+#include <cstdint>
+#include <vector>
+#include "context.h"
+
+namespace gpu {
+
+/**
+ * 4 and 8 bit texture pages decoded through the palette cache to 16 bit texels.
+ *
+ * Page is decoded only after primitives using it covered about as many pixels as decoding costs,
+ * until then texels are fetched from VRAM. Decoded page is keyed by palette cache generation (stale palette
+ * is emulated by ClutCache) and stays valid until VRAM under the page is written.
+ */
+class TextureCache {
+   public:
+    static const int PAGE_SIZE = 256;  // Texels in both directions
+
+   private:
+    static const int ENTRIES = 8;
+
+    struct Entry {
+        ivec2 texpage{-1, -1};
+        ColorDepth bits = ColorDepth::NONE;
+        uint32_t clutGeneration = 0;
+        int pixels = 0;  // Drawn with the page since it was last written
+        uint64_t lastUse = 0;
+        bool decoded = false;
+        std::vector<uint16_t> texels;  // One extra halfword as SIMD gathers read 32bit words
+    };
+
+    std::array<Entry, ENTRIES> entries;
+    uint64_t useCounter = 0;
+
+    void decode(const RenderContext* ctx, Entry& entry);
+
+   public:
+    // Returns PAGE_SIZE x PAGE_SIZE texels or nullptr, primitive drawing over its own texture page always reads VRAM
+    const uint16_t* get(const RenderContext* ctx, ColorDepth bits, ivec2 texpage, ivec2 min, ivec2 max);
+
+    // Region wraps around VRAM edges
+    void markDirty(int x, int y, int w, int h);
+    void invalidate();
+};
+
+}  // namespace gpu
@@ -1,62 +1,93 @@
 #pragma once
-#include "device/gpu/gpu.h"
+#include "context.h"
+#include "texture_cache.h"
 #include "utils/macros.h"
 #include "../color_depth.h"
 #include "../primitive.h"
+#include "../psx_color.h"
 
-#define gpuVRAM ((uint16_t(*)[gpu::VRAM_WIDTH])gpu->vram.data())
+#define gpuVRAM ((uint16_t(*)[gpu::VRAM_WIDTH])ctx->vram)
 
 template <ColorDepth bits>
-void loadClutCacheIfRequired(gpu::GPU* gpu, ivec2 clut) {
+void loadClutCacheIfRequired(const gpu::RenderContext* ctx, ivec2 clut) {
     // Only paletted textures should reload the color look-up table cache
     if constexpr (bits != ColorDepth::BIT_4 && bits != ColorDepth::BIT_8) {
         return;
     }
 
-    bool textureFormatRequireReload = bits > gpu->clutCacheColorDepth;
-    bool clutPositionChanged = gpu->clutCachePos != clut;
+    auto cache = ctx->clutCache;
+    bool textureFormatRequireReload = bits > cache->colorDepth;
+    bool clutPositionChanged = cache->pos != clut;
 
     if (!textureFormatRequireReload && !clutPositionChanged) {
         return;
     }
 
-    gpu->clutCacheColorDepth = bits;
-    gpu->clutCachePos = clut;
+    cache->colorDepth = bits;
+    cache->pos = clut;
+    cache->generation++;
 
     constexpr int entries = (bits == ColorDepth::BIT_8) ? 256 : 16;
     for (int i = 0; i < entries; i++) {
-        gpu->clutCache[i] = gpuVRAM[clut.y][clut.x + i];
+        cache->entries[i] = gpuVRAM[clut.y][(clut.x + i) & 1023];  // Palette wraps around VRAM width
     }
 }
 
+// Primitive draws within min-max, decoded texture pages under it are no longer valid
+inline void markDrawn(const gpu::RenderContext* ctx, ivec2 min, ivec2 max) {
+    if (ctx->textureCache == nullptr || min.x > max.x || min.y > max.y) return;
+    ctx->textureCache->markDirty(min.x, min.y, max.x - min.x + 1, max.y - min.y + 1);
+}
+
+// Decoded texture page for primitive drawn within min-max, nullptr if texels have to be fetched from VRAM
+template <ColorDepth bits>
+const uint16_t* decodedTexturePage(const gpu::RenderContext* ctx, ivec2 texPage, ivec2 min, ivec2 max) {
+    if constexpr (bits != ColorDepth::BIT_4 && bits != ColorDepth::BIT_8) {
+        return nullptr;
+    }
+    if (ctx->textureCache == nullptr) return nullptr;
+    return ctx->textureCache->get(ctx, bits, texPage, min, max);
+}
+
 namespace {
-INLINE uint16_t tex4bit(gpu::GPU* gpu, ivec2 tex, ivec2 texPage) {
+INLINE uint16_t tex4bit(const gpu::RenderContext* ctx, ivec2 tex, ivec2 texPage) {
     uint16_t index = gpuVRAM[(texPage.y + tex.y) & 511][(texPage.x + tex.x / 4) & 1023];
     uint8_t entry = (index >> ((tex.x & 3) * 4)) & 0xf;
-    return gpu->clutCache[entry];
+    return ctx->clutCache->entries[entry];
 }
 
-INLINE uint16_t tex8bit(gpu::GPU* gpu, ivec2 tex, ivec2 texPage) {
+INLINE uint16_t tex8bit(const gpu::RenderContext* ctx, ivec2 tex, ivec2 texPage) {
     uint16_t index = gpuVRAM[(texPage.y + tex.y) & 511][(texPage.x + tex.x / 2) & 1023];
     uint8_t entry = (index >> ((tex.x & 1) * 8)) & 0xff;
-    return gpu->clutCache[entry];
+    return ctx->clutCache->entries[entry];
 }
 
-INLINE uint16_t tex16bit(gpu::GPU* gpu, ivec2 tex, ivec2 texPage) { return gpuVRAM[(texPage.y + tex.y) & 511][(texPage.x + tex.x) & 1023]; }
+INLINE uint16_t tex16bit(const gpu::RenderContext* ctx, ivec2 tex, ivec2 texPage) {
+    return gpuVRAM[(texPage.y + tex.y) & 511][(texPage.x + tex.x) & 1023];
+}
 
 template <ColorDepth bits>
-INLINE PSXColor fetchTex(gpu::GPU* gpu, ivec2 texel, const ivec2 texPage) {
+INLINE PSXColor fetchTex(const gpu::RenderContext* ctx, ivec2 texel, const ivec2 texPage) {
     if constexpr (bits == ColorDepth::BIT_4) {
-        return tex4bit(gpu, texel, texPage);
+        return tex4bit(ctx, texel, texPage);
     } else if constexpr (bits == ColorDepth::BIT_8) {
-        return tex8bit(gpu, texel, texPage);
+        return tex8bit(ctx, texel, texPage);
     } else if constexpr (bits == ColorDepth::BIT_16) {
-        return tex16bit(gpu, texel, texPage);
+        return tex16bit(ctx, texel, texPage);
     } else {
         static_assert(true, "Invalid ColorDepth parameter");
     }
 }
 
+// Texels of decoded page are already looked up in the palette, see TextureCache
+template <ColorDepth bits>
+INLINE PSXColor fetchTex(const gpu::RenderContext* ctx, const uint16_t* texels, ivec2 texel, const ivec2 texPage) {
+    if constexpr (bits == ColorDepth::BIT_4 || bits == ColorDepth::BIT_8) {
+        if (texels) return texels[texel.y * gpu::TextureCache::PAGE_SIZE + texel.x];
+    }
+    return fetchTex<bits>(ctx, texel, texPage);
+}
+
 INLINE ivec2 maskTexel(ivec2 texel, const gpu::GP0_E2 textureWindow) {
     // Texture is repeated outside of 256x256 window
     texel.x %= 256u;
@@ -0,0 +1,269 @@
+#pragma once
+#include <algorithm>
+#include <cstdint>
+#include "context.h"
+#include "device/gpu/primitive.h"
+
+// Triangle setup shared by rasterizer implementations, all of them have to step attributes exactly the same way
+
+inline int orient2d(const ivec2& a, const ivec2& b, const ivec2& c) {  //
+    return (b.x - a.x) * (c.y - a.y) - (b.y - a.y) * (c.x - a.x);
+}
+
+inline bool isTopLeft(const ivec2 e) { return e.y < 0 || (e.y == 0 && e.x < 0); }
+
+inline void calculateFillRuleBias(int bias[3], const ivec2 pos[3]) {
+    // Delta constants
+    const ivec2 D01(pos[1].x - pos[0].x, pos[0].y - pos[1].y);
+    const ivec2 D12(pos[2].x - pos[1].x, pos[1].y - pos[2].y);
+    const ivec2 D20(pos[0].x - pos[2].x, pos[2].y - pos[0].y);
+
+    // Fill rule
+    bias[0] = isTopLeft(D12) ? -1 : 0;
+    bias[1] = isTopLeft(D20) ? -1 : 0;
+    bias[2] = isTopLeft(D01) ? -1 : 0;
+}
+
+/**
+ * Colors and texture coordinates are interpolated in fixed point with 20 fractional bits.
+ *
+ * Attributes are stepped with integer additions modulo 2^32. Deltas of thin triangles and values
+ * outside of the triangle may overflow, but interpolation is linear, so values of covered pixels are still exact.
+ */
+const int ATTRIBUTE_PRECISION = 20;
+const int64_t ATTRIBUTE_ONE = int64_t(1) << ATTRIBUTE_PRECISION;
+
+using attribute_t = uint32_t;
+
+struct Attributes {
+    attribute_t r, g, b;
+    attribute_t u, v;
+};
+
+struct AttributeDeltas {
+    struct Delta {
+        attribute_t x, y;
+    };
+
+    Delta r, g, b;
+    Delta u, v;
+};
+
+// Integer part of interpolated attribute, rounding errors at triangle edges are clamped to valid range
+inline int attributeValue(attribute_t a) { return std::clamp(static_cast<int32_t>(a) >> ATTRIBUTE_PRECISION, 0, 255); }
+
+inline int64_t divideRounded(int64_t n, int64_t d) {
+    if (d < 0) {
+        n = -n;
+        d = -d;
+    }
+    return n >= 0 ? (n + d / 2) / d : -((-n + d / 2) / d);
+}
+
+/**
+ * p - vertex position
+ * a - attribute values per vertex
+ */
+inline int calculateXDelta(const ivec2 p[3], const int a[3]) {
+    return (p[1].y - p[2].y) * a[0] + (p[2].y - p[0].y) * a[1] + (p[0].y - p[1].y) * a[2];
+}
+
+inline int calculateYDelta(const ivec2 p[3], const int a[3]) {
+    return (p[2].x - p[1].x) * a[0] + (p[0].x - p[2].x) * a[1] + (p[1].x - p[0].x) * a[2];
+}
+
+inline AttributeDeltas::Delta calculateDelta(const int area, const ivec2 p[3], const int a[3]) {
+    attribute_t x = static_cast<attribute_t>(divideRounded(calculateXDelta(p, a) * ATTRIBUTE_ONE, area));
+    attribute_t y = static_cast<attribute_t>(divideRounded(calculateYDelta(p, a) * ATTRIBUTE_ONE, area));
+
+    return {x, y};
+}
+
+// Value at given pixel is calculated exactly (relative to the first vertex), rounded to nearest integer
+inline attribute_t calculateStartAttribute(const int area, const ivec2 p[3], const int a[3], const ivec2 pixel) {
+    int64_t n = int64_t(calculateXDelta(p, a)) * (pixel.x - p[0].x) + int64_t(calculateYDelta(p, a)) * (pixel.y - p[0].y);
+    return static_cast<attribute_t>(a[0] * ATTRIBUTE_ONE + divideRounded(n * ATTRIBUTE_ONE, area) + ATTRIBUTE_ONE / 2);
+}
+
+template <bool isGouraudShaded, bool isTextured>
+Attributes calculateStartAttributes(const primitive::Triangle& triangle, const ivec2 pixel) {
+    ivec2 p[3] = {triangle.v[0].pos, triangle.v[1].pos, triangle.v[2].pos};
+
+    const int area = orient2d(p[0], p[1], p[2]);
+    if (area == 0) return {};
+
+    Attributes attrs = {};
+    if constexpr (isGouraudShaded) {
+        int r[3] = {triangle.v[0].color.r, triangle.v[1].color.r, triangle.v[2].color.r};
+        int g[3] = {triangle.v[0].color.g, triangle.v[1].color.g, triangle.v[2].color.g};
+        int b[3] = {triangle.v[0].color.b, triangle.v[1].color.b, triangle.v[2].color.b};
+
+        attrs.r = calculateStartAttribute(area, p, r, pixel);
+        attrs.g = calculateStartAttribute(area, p, g, pixel);
+        attrs.b = calculateStartAttribute(area, p, b, pixel);
+    }
+
+    if constexpr (isTextured) {
+        int u[3] = {triangle.v[0].uv.x, triangle.v[1].uv.x, triangle.v[2].uv.x};
+        int v[3] = {triangle.v[0].uv.y, triangle.v[1].uv.y, triangle.v[2].uv.y};
+
+        attrs.u = calculateStartAttribute(area, p, u, pixel);
+        attrs.v = calculateStartAttribute(area, p, v, pixel);
+    }
+
+    return attrs;
+}
+
+template <bool isGouraudShaded, bool isTextured>
+AttributeDeltas calculateDeltas(const primitive::Triangle& triangle) {
+    ivec2 p[3] = {triangle.v[0].pos, triangle.v[1].pos, triangle.v[2].pos};
+
+    const int area = orient2d(p[0], p[1], p[2]);
+    if (area == 0) return {};
+
+    AttributeDeltas deltas = {};
+    if constexpr (isGouraudShaded) {
+        int r[3] = {triangle.v[0].color.r, triangle.v[1].color.r, triangle.v[2].color.r};
+        int g[3] = {triangle.v[0].color.g, triangle.v[1].color.g, triangle.v[2].color.g};
+        int b[3] = {triangle.v[0].color.b, triangle.v[1].color.b, triangle.v[2].color.b};
+
+        deltas.r = calculateDelta(area, p, r);
+        deltas.g = calculateDelta(area, p, g);
+        deltas.b = calculateDelta(area, p, b);
+    }
+
+    if constexpr (isTextured) {
+        int u[3] = {triangle.v[0].uv.x, triangle.v[1].uv.x, triangle.v[2].uv.x};
+        int v[3] = {triangle.v[0].uv.y, triangle.v[1].uv.y, triangle.v[2].uv.y};
+
+        deltas.u = calculateDelta(area, p, u);
+        deltas.v = calculateDelta(area, p, v);
+    }
+
+    return deltas;
+}
+
+template <bool isGouraudShaded, bool isTextured>
+void addXDeltas(Attributes& attrib, const AttributeDeltas& deltas, attribute_t count = 1) {
+    if constexpr (isGouraudShaded) {
+        attrib.r += deltas.r.x * count;
+        attrib.g += deltas.g.x * count;
+        attrib.b += deltas.b.x * count;
+    }
+    if constexpr (isTextured) {
+        attrib.u += deltas.u.x * count;
+        attrib.v += deltas.v.x * count;
+    }
+}
+
+template <bool isGouraudShaded, bool isTextured>
+void addYDeltas(Attributes& attrib, const AttributeDeltas& deltas, attribute_t count = 1) {
+    if constexpr (isGouraudShaded) {
+        attrib.r += deltas.r.y * count;
+        attrib.g += deltas.g.y * count;
+        attrib.b += deltas.b.y * count;
+    }
+    if constexpr (isTextured) {
+        attrib.u += deltas.u.y * count;
+        attrib.v += deltas.v.y * count;
+    }
+}
+
+// Bounding box is split into 8x8 tiles, starting in its top left corner
+const int TILE_SIZE = 8;
+
+// Triangle state at the top left corner of its bounding box
+struct TriangleSetup {
+    ivec2 pos[3];
+    ivec2 min, max;  // Bounding box clipped to drawing area
+
+    // Edge function deltas
+    ivec2 D01, D12, D20;
+
+    // Half-space values for first pixel
+    int CY[3];
+
+    // Edge functions are linear, their extremes over a tile are in its corners - offsets from top left corner value
+    int tileMin[3], tileMax[3];
+
+    Attributes attributes;
+    AttributeDeltas deltas;
+};
+
+/**
+ * Returns false if triangle is not drawn.
+ * Degenerate triangles should be rejected before (by area), as they don't reload the CLUT cache.
+ */
+template <bool isGouraudShaded, bool isTextured>
+bool setupTriangle(const gpu::RenderContext* ctx, const primitive::Triangle& triangle, TriangleSetup& s) {
+    const ivec2* pos = s.pos;
+    for (int i = 0; i < 3; i++) s.pos[i] = triangle.v[i].pos;
+
+    ivec2 min(                                     //
+        std::min({pos[0].x, pos[1].x, pos[2].x}),  //
+        std::min({pos[0].y, pos[1].y, pos[2].y})   //
+    );
+    ivec2 max(                                     //
+        std::max({pos[0].x, pos[1].x, pos[2].x}),  //
+        std::max({pos[0].y, pos[1].y, pos[2].y})   //
+    );
+
+    // Skip rendering when distance between vertices is bigger than 1023x511
+    const ivec2 size = max - min;
+    if (size.x >= 1024 || size.y >= 512) return false;
+
+    s.min = ivec2(                //
+        ctx->minDrawingX(min.x),  //
+        ctx->minDrawingY(min.y)   //
+    );
+    s.max = ivec2(                //
+        ctx->maxDrawingX(max.x),  //
+        ctx->maxDrawingY(max.y)   //
+    );
+
+    // https://fgiesen.wordpress.com/2013/02/10/optimizing-the-basic-rasterizer/
+
+    // Delta constants
+    s.D01 = ivec2(pos[1].x - pos[0].x, pos[0].y - pos[1].y);
+    s.D12 = ivec2(pos[2].x - pos[1].x, pos[1].y - pos[2].y);
+    s.D20 = ivec2(pos[0].x - pos[2].x, pos[2].y - pos[0].y);
+
+    // Fill rule
+    int bias[3];
+    calculateFillRuleBias(bias, pos);
+
+    s.CY[0] = orient2d(pos[1], pos[2], s.min) + bias[0];
+    s.CY[1] = orient2d(pos[2], pos[0], s.min) + bias[1];
+    s.CY[2] = orient2d(pos[0], pos[1], s.min) + bias[2];
+
+    const ivec2 D[3] = {s.D12, s.D20, s.D01};
+    for (int e = 0; e < 3; e++) {
+        int dx = D[e].y * (TILE_SIZE - 1);
+        int dy = D[e].x * (TILE_SIZE - 1);
+        s.tileMin[e] = std::min(dx, 0) + std::min(dy, 0);
+        s.tileMax[e] = std::max(dx, 0) + std::max(dy, 0);
+    }
+
+    s.attributes = calculateStartAttributes<isGouraudShaded, isTextured>(triangle, s.min);
+    s.deltas = calculateDeltas<isGouraudShaded, isTextured>(triangle);
+    return true;
+}
+
+enum class TileCoverage { Outside, Partial, Inside };
+
+/**
+ * Classifies 8x8 tile with top left corner in (x, y).
+ * Pixel is drawn if no edge function is negative (and not all of them are zero).
+ * Tiles cut by bounding box are classified as full ones - result is conservative.
+ */
+inline TileCoverage classifyTile(const TriangleSetup& s, int x, int y) {
+    const ivec2 D[3] = {s.D12, s.D20, s.D01};
+
+    bool inside = true;
+    for (int e = 0; e < 3; e++) {
+        int c = s.CY[e] + (x - s.min.x) * D[e].y + (y - s.min.y) * D[e].x;
+        if (c + s.tileMax[e] < 0) return TileCoverage::Outside;
+        if (c + s.tileMin[e] <= 0) inside = false;
+    }
+    return inside ? TileCoverage::Inside : TileCoverage::Partial;
+}
@@ -3,4 +3,10 @@ enum RenderingMode {
     software = 1 << 0,
     hardware = 1 << 1,
     mixed = software | hardware,
+};
+
+// Presentation of 480i frames, weave shows both fields, bob only the last drawn one
+enum class Deinterlacing {
+    weave,
+    bob,
 };
\ No newline at end of file
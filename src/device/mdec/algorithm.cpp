@@ -4,10 +4,6 @@
 #include "utils/math.h"
 
 namespace mdec {
-std::array<int16_t, 64> crblk = {{0}};
-std::array<int16_t, 64> cbblk = {{0}};
-std::array<int16_t, 64> yblk[4] = {{0}};
-
 // Helpers for accessing 1d arrays with 2d addressing
 #define _CR ((int16_t(*)[8])crblk.data())
 #define _CB ((int16_t(*)[8])cbblk.data())
@@ -40,7 +36,7 @@ void MDEC::yuvToRgb(decodedBlock& output, int blockX, int blockY) {
     // Cr and Cb components are half resolution horizontally and vertically
 
     // Y, Cb, Cr
-    auto sample = [](int x, int y, int yBlock) -> std::tuple<int16_t, int16_t, int16_t> {
+    auto sample = [this](int x, int y, int yBlock) -> std::tuple<int16_t, int16_t, int16_t> {
         int16_t Y = _Y(yBlock)[y % 8][x % 8];
         int16_t Cb = _CB[y / 2][x / 2];
         int16_t Cr = _CR[y / 2][x / 2];
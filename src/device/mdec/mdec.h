@@ -4,6 +4,8 @@
 #include <optional>
 #include "device/device.h"
 
+struct System;
+
 namespace mdec {
 using decodedBlock = std::array<uint32_t, 16 * 16>;
 
@@ -54,6 +56,7 @@ class MDEC {
         Control() : _reg(0) {}
     };
 
+    System* sys;
     int verbose;
     Command command;
     Reg32 data;
@@ -72,6 +75,11 @@ class MDEC {
     std::vector<uint16_t> input;
     std::vector<uint32_t> output;
     size_t outputPtr;
+    int part = 0;  // Position in 3 word cycle of 24bit output
+
+    std::array<int16_t, 64> crblk = {{0}};
+    std::array<int16_t, 64> cbblk = {{0}};
+    std::array<int16_t, 64> yblk[4] = {{0}};
 
     // Algorithm
     void decodeMacroblocks();
@@ -81,7 +89,7 @@ class MDEC {
     void idct(std::array<int16_t, 64>& src);
 
    public:
-    MDEC();
+    MDEC(System* sys);
     void reset();
     void step();
     uint32_t read(uint32_t address);
@@ -1,9 +1,9 @@
 #include "memory_control.h"
 #include <fmt/core.h>
-#include <config.h>
+#include "system.h"
 
-MemoryControl::MemoryControl() {
-    verbose = config.debug.log.memoryControl > 0;
+MemoryControl::MemoryControl(System* sys) {
+    verbose = sys->config.debug.log.memoryControl > 0;
     reset();
 }
 
@@ -1,6 +1,8 @@
 #pragma once
 #include "device.h"
 
+struct System;
+
 class MemoryControl {
     bool verbose = false;
     Reg32 exp1Base;
@@ -13,7 +15,7 @@ class MemoryControl {
     Reg32 cdromConfig;
 
    public:
-    MemoryControl();
+    MemoryControl(System* sys);
     void reset();
     uint8_t read(uint32_t address);
     void write(uint32_t address, uint8_t data);
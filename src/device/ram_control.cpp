@@ -1,9 +1,9 @@
 #include "ram_control.h"
 #include <fmt/core.h>
-#include <config.h>
+#include "system.h"
 
-RamControl::RamControl() {
-    verbose = config.debug.log.memoryControl > 0;
+RamControl::RamControl(System* sys) {
+    verbose = sys->config.debug.log.memoryControl > 0;
     reset();
 }
 
@@ -1,12 +1,14 @@
 #pragma once
 #include "device.h"
 
+struct System;
+
 class RamControl {
     bool verbose = false;
     Reg32 ramSize;
 
    public:
-    RamControl();
+    RamControl(System* sys);
     void reset();
     uint8_t read(uint32_t address);
     void write(uint32_t address, uint8_t data);
@@ -11,12 +11,11 @@
 #include "system.h"
 #include "utils/file.h"
 #include "utils/math.h"
-#include "config.h"
 
 using namespace spu;
 
 SPU::SPU(System* sys) : sys(sys) {
-    verbose = config.debug.log.spu;
+    verbose = sys->config.debug.log.spu;
     ram.fill(0);
     audioBufferPos = 0;
     captureBufferIndex = 0;
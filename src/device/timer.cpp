@@ -1,10 +1,15 @@
 #include "timer.h"
 #include <fmt/core.h>
+#include <algorithm>
+#include <cmath>
 #include "system.h"
 
 namespace device::timer {
 
-Timer::Timer(System* sys, int which) : which(which), sys(sys) {}
+Timer::Timer(System* sys, int which) : which(which), sys(sys) {
+    lastSync = sys->scheduler.now();
+    scheduleEvent();
+}
 
 void Timer::step(int cycles) {
     if (paused) return;
@@ -65,6 +70,36 @@ void Timer::step(int cycles) {
     current._reg = (uint16_t)tval;
 }
 
+void Timer::sync() {
+    uint64_t now = sys->scheduler.now();
+    step(static_cast<int>(now - lastSync));
+    lastSync = now;
+}
+
+// Must match the way step() converts cycles to ticks
+float Timer::cyclesPerTick() const {
+    if (which == 0) {
+        return static_cast<CounterMode::ClockSource0>(mode.clockSource & 1) == CounterMode::ClockSource0::dotClock ? 6.f : 1.5f;
+    } else if (which == 1) {
+        return static_cast<CounterMode::ClockSource1>(mode.clockSource & 1) == CounterMode::ClockSource1::hblank ? 3413.f : 1.5f;
+    } else {
+        auto clock = static_cast<CounterMode::ClockSource2>((mode.clockSource >> 1) & 1);
+        return clock == CounterMode::ClockSource2::systemClock_8 ? 8 * 1.5f : 1 / 1.5f;
+    }
+}
+
+void Timer::scheduleEvent() {
+    if (paused) {
+        sys->scheduler.cancel(event());
+        return;
+    }
+
+    uint32_t tval = current._reg;
+    uint32_t ticks = tval < target._reg ? target._reg - tval : 0xffff - tval;
+    int64_t cycles = static_cast<int64_t>(std::ceil(ticks * cyclesPerTick())) - cnt;
+    sys->scheduler.schedule(event(), lastSync + std::max<int64_t>(cycles, MIN_EVENT_INTERVAL));
+}
+
 void Timer::checkIrq() {
     if (mode.irqPulseMode == CounterMode::IrqPulseMode::toggle) {
         mode.interruptRequest = !mode.interruptRequest;
@@ -82,6 +117,7 @@ void Timer::checkIrq() {
 }
 
 uint8_t Timer::read(uint32_t address) {
+    sync();
     if (address < 2) {
         return current.read(address);
     }
@@ -100,6 +136,7 @@ uint8_t Timer::read(uint32_t address) {
 }
 
 void Timer::write(uint32_t address, uint8_t data) {
+    sync();
     if (address < 2) {
         current.write(address, data);
     } else if (address >= 4 && address < 6) {
@@ -137,6 +174,7 @@ void Timer::write(uint32_t address, uint8_t data) {
     } else if (address >= 8 && address < 10) {
         target.write(address - 8, data);
     }
+    scheduleEvent();
 }
 
 };  // namespace device::timer
\ No newline at end of file
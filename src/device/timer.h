@@ -1,6 +1,7 @@
 #pragma once
 #include <cassert>
 #include "interrupt.h"
+#include "scheduler.h"
 
 namespace gui::debug {
 class Timers;
@@ -81,11 +82,17 @@ class Timer {
     uint32_t cnt = 0;
 
    private:
+    // Counters reaching their target constantly are stepped with the granularity of the former fixed time slices
+    static const int MIN_EVENT_INTERVAL = 300;
+
     bool oneShotIrqOccured = false;
+    uint64_t lastSync = 0;
 
     System* sys;
 
     void checkIrq();
+    float cyclesPerTick() const;
+    Scheduler::Event event() const { return static_cast<Scheduler::Event>(static_cast<int>(Scheduler::Event::timer0) + which); }
     interrupt::IrqNumber mapIrqNumber() const {
         if (which == 0) return interrupt::TIMER0;
         if (which == 1) return interrupt::TIMER1;
@@ -97,12 +104,16 @@ class Timer {
    public:
     Timer(System* sys, int which);
     void step(int cycles);
+    // Steps the counter up to current time
+    void sync();
+    // Schedules event when the counter reaches its target or 0xffff
+    void scheduleEvent();
     uint8_t read(uint32_t address);
     void write(uint32_t address, uint8_t data);
 
     template <class Archive>
     void serialize(Archive& ar) {
-        ar(current, mode._reg, target, cnt, oneShotIrqOccured);
+        ar(current, mode._reg, target, cnt, oneShotIrqOccured, lastSync);
     }
 };
 };  // namespace device::timer
\ No newline at end of file
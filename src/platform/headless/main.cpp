@@ -1,44 +1,358 @@
-#include <cassert>
-#include <cstdio>
+#include <fmt/core.h>
+#include <algorithm>
+#include <array>
+#include <cstdlib>
+#include <magic_enum.hpp>
 #include <memory>
 #include <string>
-#include "mips.h"
+#include <vector>
+#include "config.h"
+#include "system.h"
+#include "system_tools.h"
 #include "utils/file.h"
+#include "utils/gpu_draw_list.h"
+#include "utils/logic.h"
+#include "utils/timing.h"
 
-int main(int argc, char **argv) {
-    if (argc < 2) {
-        printf("usage: Avocado psx.exe\n");
+namespace {
+struct Options {
+    std::string bios;
+    std::string file;
+    int frames = 600;
+    CpuCore core = CpuCore::interpreter;
+    int renderingThreads = 0;
+    bool vramHash = false;
+    int replay = 0;  // Iterations of .gpudrawlist replay, 0 - emulate the system
+    std::vector<std::string> drawLists;
+};
+
+void usage() {
+    fmt::print(
+        "usage: avocado [options] bios.bin [disc.cue|psx.exe]\n"
+        "       avocado --replay N [options] capture.gpudrawlist...\n"
+        "  --frames N     number of frames to emulate after boot (default 600)\n"
+        "  --core NAME    interpreter, cachedInterpreter or recompiler\n"
+        "  --threads N    software rendering threads (default 0 - emulation thread, 1 - GPU thread)\n"
+        "  --vram-hash    print hash of the final VRAM contents\n"
+        "  --replay N     replay GPU draw list captures N times without CPU emulation\n");
+}
+
+bool parseArguments(int argc, char** argv, Options& options) {
+    std::vector<std::string> positional;
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        if (arg == "--frames" && i + 1 < argc) {
+            options.frames = std::stoi(argv[++i]);
+        } else if (arg == "--core" && i + 1 < argc) {
+            auto core = magic_enum::enum_cast<CpuCore>(argv[++i]);
+            if (!core) {
+                fmt::print("Unknown CPU core {}\n", argv[i]);
+                return false;
+            }
+            options.core = *core;
+        } else if (arg == "--threads" && i + 1 < argc) {
+            options.renderingThreads = std::stoi(argv[++i]);
+        } else if (arg == "--vram-hash") {
+            options.vramHash = true;
+        } else if (arg == "--replay" && i + 1 < argc) {
+            options.replay = std::stoi(argv[++i]);
+            if (options.replay <= 0) return false;
+        } else if (arg.rfind("--", 0) == 0) {
+            fmt::print("Unknown option {}\n", arg);
+            return false;
+        } else {
+            positional.push_back(arg);
+        }
+    }
+
+    if (options.replay > 0) {
+        if (positional.empty()) return false;
+        options.drawLists = positional;
+        return true;
+    }
+
+    if (positional.empty() || positional.size() > 2 || options.frames <= 0) return false;
+    options.bios = positional[0];
+    if (positional.size() > 1) options.file = positional[1];
+    return true;
+}
+
+// FNV-1a, stable across platforms so results can be compared between machines
+uint64_t hashVram(const gpu::GPU* gpu) {
+    uint64_t hash = 0xcbf2'9ce4'8422'2325;
+    for (uint16_t pixel : gpu->vram) {
+        for (int i = 0; i < 2; i++) {
+            hash ^= (pixel >> (i * 8)) & 0xff;
+            hash *= 0x100'0000'01b3;
+        }
+    }
+    return hash;
+}
+
+double percent(uint64_t part, uint64_t total) { return total == 0 ? 0.0 : 100.0 * part / total; }
+
+enum class Primitive { polygon, line, rectangle, fill, copy, upload, other };
+const size_t PRIMITIVE_TYPES = magic_enum::enum_count<Primitive>();
+
+struct PrimitiveStats {
+    uint64_t count = 0;
+    uint64_t pixels = 0;
+    uint64_t ns = 0;
+};
+
+Primitive classify(const gpu::LogEntry& entry) {
+    if (entry.type != 0) return Primitive::other;
+    uint8_t cmd = entry.cmd();
+    if (cmd == 0x02) return Primitive::fill;
+    if (cmd >= 0x20 && cmd < 0x40) return Primitive::polygon;
+    if (cmd >= 0x40 && cmd < 0x60) return Primitive::line;
+    if (cmd >= 0x60 && cmd < 0x80) return Primitive::rectangle;
+    if (cmd >= 0x80 && cmd < 0xa0) return Primitive::copy;
+    if (cmd >= 0xa0 && cmd < 0xc0) return Primitive::upload;
+    return Primitive::other;
+}
+
+int posX(uint32_t word) { return extend_sign<11>(word & 0xffff); }
+int posY(uint32_t word) { return extend_sign<11>(word >> 16); }
+int sizeW(uint32_t word) { return word & 0x3ff; }
+int sizeH(uint32_t word) { return (word >> 16) & 0x1ff; }
+
+// Pixels covered by the primitive, before clipping to the drawing area
+uint64_t pixelArea(Primitive type, const gpu::LogEntry& entry) {
+    const auto& args = entry.args;
+    auto argument = [&](size_t i) { return i < args.size() ? args[i] : 0; };
+
+    switch (type) {
+        case Primitive::polygon: {
+            gpu::PolygonArgs arg(entry.cmd());
+            int x[4] = {}, y[4] = {};
+            size_t ptr = 1;
+            for (int i = 0; i < arg.getVertexCount(); i++) {
+                if (i > 0 && arg.gouraudShading) ptr++;
+                x[i] = posX(argument(ptr));
+                y[i] = posY(argument(ptr++));
+                if (arg.isTextureMapped) ptr++;
+            }
+            auto triangle = [&](int a, int b, int c) {
+                int64_t cross = static_cast<int64_t>(x[b] - x[a]) * (y[c] - y[a]) - static_cast<int64_t>(x[c] - x[a]) * (y[b] - y[a]);
+                return static_cast<uint64_t>(std::abs(cross) / 2);
+            };
+            return triangle(0, 1, 2) + (arg.isQuad ? triangle(1, 2, 3) : 0);
+        }
+        case Primitive::line: {
+            gpu::LineArgs arg(entry.cmd());
+            uint32_t p0 = argument(1);
+            uint32_t p1 = argument(arg.gouraudShading ? 3 : 2);
+            return std::max(std::abs(posX(p1) - posX(p0)), std::abs(posY(p1) - posY(p0))) + 1;
+        }
+        case Primitive::rectangle: {
+            gpu::RectangleArgs arg(entry.cmd());
+            if (arg.size != 0) return arg.getSize() * arg.getSize();
+            uint32_t size = argument(arg.isTextureMapped ? 3 : 2);
+            return sizeW(size) * sizeH(size);
+        }
+        case Primitive::fill: return ((sizeW(argument(2)) + 0xf) & ~0xf) * sizeH(argument(2));
+        case Primitive::copy: return sizeW(argument(3)) * sizeH(argument(3));
+        case Primitive::upload: return sizeW(argument(2)) * sizeH(argument(2));
+        default: return 0;
+    }
+}
+
+// Same as GpuDrawList::replayCommands, runs of commands of the same type are timed together
+void replay(gpu::GPU* gpu, std::array<PrimitiveStats, PRIMITIVE_TYPES>& stats) {
+    gpu->flushRendering();
+    gpu->vram = gpu->prevVram;
+    gpu->invalidateTextureCache();
+
+    const auto& log = gpu->gpuLogList;
+    Primitive current = Primitive::other;
+    uint64_t start = timing::hostNanoseconds();
+    for (size_t i = 0; i < log.size(); i++) {
+        auto entry = log[i];
+        if (entry.args.size() == 0) continue;
+        if (entry.type == 0 && entry.cmd() == 0xc0) continue;  // Skip Vram -> CPU
+
+        Primitive type = classify(entry);
+        if (type != current) {
+            uint64_t now = timing::hostNanoseconds();
+            stats[static_cast<size_t>(current)].ns += now - start;
+            start = now;
+            current = type;
+        }
+        stats[static_cast<size_t>(type)].count++;
+        stats[static_cast<size_t>(type)].pixels += pixelArea(type, entry);
+
+        uint8_t addr = (entry.type == 0) ? 0 : 4;
+        for (uint32_t arg : entry.args) gpu->write(addr, arg);
+    }
+    uint64_t now = timing::hostNanoseconds();
+    stats[static_cast<size_t>(current)].ns += now - start;
+}
+
+int replayDrawLists(const Options& options) {
+    // Single threaded replay is the reference for banded rendering
+    config.options.graphics.renderingThreads = 0;
+    auto reference = options.renderingThreads != 0 ? std::make_unique<System>() : nullptr;
+    config.options.graphics.renderingThreads = options.renderingThreads;
+    auto sys = std::make_unique<System>();
+    auto gpu = sys->gpu.get();
+
+    bool failed = false;
+    for (const auto& path : options.drawLists) {
+        if (!GpuDrawList::load(sys.get(), path)) {
+            fmt::print("Cannot load draw list {}\n", path);
+            return 1;
+        }
+
+        std::array<PrimitiveStats, PRIMITIVE_TYPES> stats{};
+        uint64_t hash = 0;
+        uint64_t flushNs = 0;
+        uint64_t elapsed = 0;
+        bool mismatch = false;
+        for (int i = 0; i < options.replay; i++) {
+            uint64_t start = timing::hostNanoseconds();
+            replay(gpu, stats);
+
+            uint64_t flushStart = timing::hostNanoseconds();
+            gpu->flushRendering();
+            flushNs += timing::hostNanoseconds() - flushStart;
+            elapsed += timing::hostNanoseconds() - start;
+
+            // Not measured
+            uint64_t h = hashVram(gpu);
+            if (i == 0) hash = h;
+            if (h != hash) mismatch = true;
+        }
+        double seconds = elapsed / 1e9;
+
+        uint64_t primitives = 0;
+        uint64_t pixels = 0;
+        for (size_t i = 0; i < PRIMITIVE_TYPES; i++) {
+            if (static_cast<Primitive>(i) == Primitive::other) continue;
+            primitives += stats[i].count;
+            pixels += stats[i].pixels;
+        }
+
+        fmt::print("{}\n", path);
+        fmt::print("Commands:     {} x {} iterations in {:.3f} s\n", gpu->gpuLogList.size(), options.replay, seconds);
+        fmt::print("Primitives:   {:.2f} M/s\n", primitives / seconds / 1e6);
+        fmt::print("Pixels:       {:.1f} M/s (primitive area, before clipping)\n", pixels / seconds / 1e6);
+
+        fmt::print("\nHost time:\n");
+        for (size_t i = 0; i < PRIMITIVE_TYPES; i++) {
+            const auto& s = stats[i];
+            if (s.count == 0) continue;
+            auto name = magic_enum::enum_name(static_cast<Primitive>(i));
+            fmt::print("  {:<12} {:>10.2f} ms {:6.2f}% {:>10} cmds {:>8.1f} ns/cmd {:>12} px\n", name, s.ns / 1e6, percent(s.ns, elapsed),
+                       s.count / options.replay, static_cast<double>(s.ns) / s.count, s.pixels / options.replay);
+        }
+        fmt::print("  {:<12} {:>10.2f} ms {:6.2f}%\n", "flush", flushNs / 1e6, percent(flushNs, elapsed));
+        if (options.renderingThreads != 0) {
+            fmt::print("  (commands are queued to rendering threads, drawing time is attributed to whichever command waits)\n");
+        }
+
+        fmt::print("\nVRAM hash:    {:016x}\n", hash);
+        if (mismatch) {
+            fmt::print("[ERROR] VRAM differs between iterations\n");
+            failed = true;
+        }
+
+        if (reference) {
+            GpuDrawList::load(reference.get(), path);
+            GpuDrawList::replayCommands(reference->gpu.get());
+            uint64_t referenceHash = hashVram(reference->gpu.get());
+            if (referenceHash != hash) {
+                fmt::print("[ERROR] VRAM differs from single threaded replay ({:016x})\n", referenceHash);
+                failed = true;
+            }
+        }
+        fmt::print("\n");
+    }
+
+    return failed ? 1 : 0;
+}
+}  // namespace
+
+int main(int argc, char** argv) {
+    Options options;
+    if (!parseArguments(argc, argv, options)) {
+        usage();
         return 1;
     }
-    std::unique_ptr<mips::CPU> cpu = std::make_unique<mips::CPU>();
 
-    if (!cpu->loadBios("SCPH1001.BIN")) {
+    if (options.replay > 0) {
+        return replayDrawLists(options);
+    }
+
+    config.bios = options.bios;
+    config.iso = "";
+    config.extension = "";
+    config.memoryCard[0].path = "";
+    config.memoryCard[1].path = "";
+    config.options.system.cpuCore = options.core;
+    config.options.graphics.renderingThreads = options.renderingThreads;
+
+    std::unique_ptr<System> sys = system_tools::hardReset();
+    if (!sys->isSystemReady()) {
+        fmt::print("Cannot load bios {}\n", options.bios);
         return 1;
     }
+    sys->state = System::State::run;
 
-    // Breakpoint on BIOS Shell execution
-    cpu->addBreakpoint(0x80030000);
+    if (!options.file.empty()) {
+        if (!fileExists(options.file)) {
+            fmt::print("File {} not found\n", options.file);
+            return 1;
+        }
+        system_tools::loadFile(sys, options.file);
+    }
 
-    cpu->biosLog = false;
-    cpu->debugOutput = false;
+    // Boot is not measured, only the frames emulated after it
+    sys->hostTime = {};
+    sys->hostTime.enabled = true;
+    uint64_t startCycles = sys->cycles;
+    uint64_t startSkipped = sys->cpu->idleLoops.skippedCycles;
+    uint64_t start = timing::hostNanoseconds();
 
-    // Emulate BIOS to GUI breakpoint
-    while (cpu->state == mips::CPU::State::run) {
-        cpu->emulateFrame();
+    int frames = 0;
+    while (frames < options.frames && sys->state == System::State::run) {
+        sys->emulateFrame();
+        frames++;
     }
 
-    if (!cpu->loadExeFile(argv[1])) {
-        printf("Cannot load %s\n", argv[1]);
-        return 1;
+    uint64_t elapsed = timing::hostNanoseconds() - start;
+    uint64_t cycles = sys->cycles - startCycles;
+    uint64_t instructions = cycles - (sys->cpu->idleLoops.skippedCycles - startSkipped);
+    double seconds = elapsed / 1e9;
+    double realtime = sys->gpu->isNtsc() ? timing::NTSC_FRAMERATE : timing::PAL_FRAMERATE;
+
+    if (frames < options.frames) {
+        fmt::print("[WARNING] Emulation stopped after {} frames\n", frames);
     }
-    printf("File %s loaded\n", getFilenameExt(argv[1]).c_str());
 
-    cpu->state = System::State::run;
-    cpu->debugOutput = false;
-    cpu->setPC(cpu->readMemory32(0x1f000000));
+    fmt::print("Core:         {}\n", magic_enum::enum_name(options.core));
+    fmt::print("Frames:       {} in {:.3f} s, {:.1f} fps ({:.2f}x realtime)\n", frames, seconds, frames / seconds,
+               frames / seconds / realtime);
+    fmt::print("Instructions: {}, {:.1f} MIPS ({:.1f}% of cycles skipped in idle loops)\n", instructions, instructions / seconds / 1e6,
+               percent(cycles - instructions, cycles));
+
+    const auto& time = sys->hostTime;
+    uint64_t measured = time.cpu + time.gpu;
+    for (auto t : time.events) measured += t;
+
+    fmt::print("\nHost time:\n");
+    auto line = [&](const std::string& name, uint64_t ns) {
+        fmt::print("  {:<12} {:>10.2f} ms {:6.2f}%\n", name, ns / 1e6, percent(ns, elapsed));
+    };
+    line("cpu", time.cpu);
+    line("gpu commands", time.gpu);
+    for (size_t i = 0; i < time.events.size(); i++) {
+        line(std::string(magic_enum::enum_name(static_cast<Scheduler::Event>(i))), time.events[i]);
+    }
+    line("other", elapsed > measured ? elapsed - measured : 0);
 
-    while (cpu->state == System::State::run) {
-        cpu->emulateFrame();
+    if (options.vramHash) {
+        fmt::print("\nVRAM hash:    {:016x}\n", hashVram(sys->gpu.get()));
     }
 
     return 0;
@@ -2,6 +2,7 @@
 #include <nlohmann/json.hpp>
 #include <fmt/core.h>
 #include "config.h"
+#include "cpu/cpu_core.h"
 #include "device/controller/controller_type.h"
 #include "device/gpu/rendering_mode.h"
 #include "utils/file.h"
@@ -16,6 +17,8 @@ std::string configPath() { return avocado::PATH_USER + CONFIG_NAME; }
 
 JSON_ENUM(ControllerType);
 JSON_ENUM(RenderingMode);
+JSON_ENUM(Deinterlacing);
+JSON_ENUM(CpuCore);
 
 void saveConfigFile() {
     nlohmann::json json;
@@ -46,6 +49,8 @@ void saveConfigFile() {
         },
         {"vsync", g.vsync},
         {"forceNtsc", g.forceNtsc},
+        {"renderingThreads", g.renderingThreads},
+        {"deinterlacing", g.deinterlacing},
     };
 
     json["options"]["sound"] = {
@@ -59,6 +64,16 @@ void saveConfigFile() {
 
     json["options"]["system"] = {
         {"ram8mb", config.options.system.ram8mb},
+        {"cpuCore", config.options.system.cpuCore},
+        {"fastmem", config.options.system.fastmem},
+        {
+            "idleLoops",
+            {
+                {"enabled", config.options.system.idleLoops.enabled},
+                {"games", config.options.system.idleLoops.games},
+                {"ignored", config.options.system.idleLoops.ignored},
+            },
+        },
     };
 
     auto l = config.debug.log;
@@ -120,6 +135,8 @@ void loadConfigFile() {
             config.options.graphics.resolution.height = g["resolution"]["height"];
             config.options.graphics.vsync = g["vsync"];
             config.options.graphics.forceNtsc = g["forceNtsc"];
+            config.options.graphics.renderingThreads = g.value("renderingThreads", 0);
+            config.options.graphics.deinterlacing = g.value("deinterlacing", Deinterlacing::weave);
         }
 
         if (auto s = json["options"]["sound"]; !s.is_null()) {
@@ -133,6 +150,13 @@ void loadConfigFile() {
 
         if (auto s = json["options"]["system"]; !s.is_null()) {
             config.options.system.ram8mb = s["ram8mb"];
+            config.options.system.cpuCore = s.value("cpuCore", CpuCore::interpreter);
+            config.options.system.fastmem = s.value("fastmem", false);
+            if (auto i = s["idleLoops"]; !i.is_null()) {
+                config.options.system.idleLoops.enabled = i.value("enabled", true);
+                config.options.system.idleLoops.games = i.value("games", decltype(config.options.system.idleLoops.games){});
+                config.options.system.idleLoops.ignored = i.value("ignored", decltype(config.options.system.idleLoops.ignored){});
+            }
         }
 
         if (auto l = json["debug"]["log"]; !l.is_null()) {
@@ -3,9 +3,12 @@
 #include <imgui.h>
 #include <algorithm>
 #include <utils/string.h>
+#include "config.h"
 #include "debugger/debugger.h"
 #include "system.h"
 #include "utils/address.h"
+#include "utils/event.h"
+#include "utils/file.h"
 
 namespace gui::debug {
 
@@ -473,10 +476,47 @@ void CPU::ramWindow(System* sys) {
     ramWindowOpen = editor.Open;
 }
 
+void CPU::profilerWindow(System* sys) {
+    auto& profiler = sys->cpu->profiler;
+    const int TOP_COUNT = 20;
+
+    ImGui::SetNextWindowSize(ImVec2(450, 500), ImGuiCond_FirstUseEver);
+    ImGui::Begin("Profiler", &profilerWindowOpen);
+
+    ImGui::Checkbox("Enabled", &profiler.enabled);
+    ImGui::SameLine();
+    if (ImGui::Button("Reset")) profiler.reset();
+    ImGui::SameLine();
+    if (ImGui::Button("Save")) {
+        std::string report = avocado::PATH_USER + "profile.txt";
+        std::string stacks = avocado::PATH_USER + "profile.folded";
+        bool saved = putFileContents(report, profiler.report()) && putFileContents(stacks, profiler.collapsedStacks());
+        toast(saved ? fmt::format("Saved to {} and {}", report, stacks) : "Problem saving profile");
+    }
+    ImGui::Text("Profiled cycles: %llu", (unsigned long long)profiler.getTotalCycles());
+
+    auto table = [&](const char* name, const std::vector<mips::Profiler::Entry>& entries, bool addresses) {
+        if (!ImGui::CollapsingHeader(name, ImGuiTreeNodeFlags_DefaultOpen)) return;
+
+        uint64_t total = std::max<uint64_t>(profiler.getTotalCycles(), 1);
+        for (const auto& e : entries) {
+            std::string label = addresses ? fmt::format("0x{:08x}", e.address) : profiler.functionName(e.address);
+            ImGui::Text("%6.2f%%  %s", 100.0 * e.cycles / total, label.c_str());
+        }
+    };
+
+    table("Hottest addresses", profiler.hottestAddresses(TOP_COUNT), true);
+    table("Hottest functions (self)", profiler.hottestFunctions(TOP_COUNT), false);
+    table("BIOS calls (total)", profiler.hottestBiosFunctions(TOP_COUNT), false);
+
+    ImGui::End();
+}
+
 void CPU::displayWindows(System* sys) {
     if (debuggerWindowOpen) debuggerWindow(sys);
     if (breakpointsWindowOpen) breakpointsWindow(sys);
     if (watchWindowOpen) watchWindow(sys);
     if (ramWindowOpen) ramWindow(sys);
+    if (profilerWindowOpen) profilerWindow(sys);
 }
 }  // namespace gui::debug
\ No newline at end of file
@@ -31,12 +31,14 @@ class CPU {
     void breakpointsWindow(System* sys);
     void watchWindow(System* sys);
     void ramWindow(System* sys);
+    void profilerWindow(System* sys);
 
    public:
     bool debuggerWindowOpen = false;
     bool breakpointsWindowOpen = false;
     bool watchWindowOpen = false;
     bool ramWindowOpen = false;
+    bool profilerWindowOpen = false;
 
     CPU();
     void displayWindows(System* sys);
@@ -46,9 +46,9 @@ class GPU {
     int16_t last_offset_x;
     int16_t last_offset_y;
     void printCommandDetails(const gpu::LogEntry &entry);
-    void handlePolygonCommand(const gpu::PolygonArgs arg, const std::vector<uint32_t> &arguments);
-    void handleLineCommand(const gpu::LineArgs arg, const std::vector<uint32_t> &arguments);
-    void handleRectangleCommand(const gpu::RectangleArgs arg, const std::vector<uint32_t> &arguments);
+    void handlePolygonCommand(const gpu::PolygonArgs arg, const gpu::LogArgs &arguments);
+    void handleLineCommand(const gpu::LineArgs arg, const gpu::LogArgs &arguments);
+    void handleRectangleCommand(const gpu::RectangleArgs arg, const gpu::LogArgs &arguments);
 
     void registersWindow(System *sys);
     void logWindow(System *sys);
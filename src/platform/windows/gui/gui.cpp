@@ -192,6 +192,7 @@ void GUI::mainMenu(std::unique_ptr<System>& sys) {
         ImGui::MenuItem("Breakpoints", nullptr, &cpuDebug.breakpointsWindowOpen);
         ImGui::MenuItem("Watch", nullptr, &cpuDebug.watchWindowOpen);
         ImGui::MenuItem("RAM", nullptr, &cpuDebug.ramWindowOpen);
+        ImGui::MenuItem("Profiler", nullptr, &cpuDebug.profilerWindowOpen);
 
         ImGui::Separator();
 
@@ -265,6 +266,9 @@ void GUI::mainMenu(std::unique_ptr<System>& sys) {
     if (ImGui::IsItemHovered()) {
         ImGui::BeginTooltip();
         ImGui::TextUnformatted(fmt::format("Frame time: {:.2f} ms\nTab to disable frame limiting", (1000.0 / statusFps)).c_str());
+        if (sys->cpu->idleLoops.enabled) {
+            ImGui::TextUnformatted(fmt::format("Idle loop cycles skipped: {}", sys->cpu->idleLoops.skippedCycles).c_str());
+        }
         ImGui::EndTooltip();
     }
     ImGui::EndMainMenuBar();
@@ -3,6 +3,7 @@
 #include <imgui.h>
 #include <magic_enum.hpp>
 #include <platform/windows/gui/gui.h>
+#include <algorithm>
 #include "config.h"
 #include "device/controller/controller_type.h"
 #include "platform/windows/gui/filesystem.h"
@@ -169,6 +170,38 @@ void graphicsOptionsWindow() {
         "but some drivers might not support it or it might be slower then doing the conversion manually.\n"
         "Should be left checked.");
 
+    int renderingThreads = config.options.graphics.renderingThreads;
+    ImGui::Text("Rendering threads");
+    ImGui::SameLine();
+    ImGui::PushItemWidth(80);
+    if (ImGui::InputInt("##rendering_threads", &renderingThreads)) {
+        config.options.graphics.renderingThreads = std::clamp(renderingThreads, 0, 16);
+        bus.notify(Event::Config::Graphics{});
+    }
+    ImGui::PopItemWidth();
+    tooltip(
+        "Number of threads used by software renderer. Each thread draws its own set of VRAM lines.\n"
+        "0 - draw on emulation thread, 1 - draw on separate GPU thread, overlapping CPU and GPU emulation.");
+
+    auto deinterlacing = config.options.graphics.deinterlacing;
+    ImGui::Text("Deinterlacing");
+    ImGui::SameLine();
+    ImGui::PushItemWidth(80);
+    if (ImGui::BeginCombo("##deinterlacing", std::string(magic_enum::enum_name(deinterlacing)).c_str())) {
+        for (auto& mode : magic_enum::enum_entries<Deinterlacing>()) {
+            if (ImGui::Selectable(std::string(mode.second).c_str(), mode.first == deinterlacing)) {
+                config.options.graphics.deinterlacing = mode.first;
+                bus.notify(Event::Config::Graphics{});
+            }
+        }
+        ImGui::EndCombo();
+    }
+    ImGui::PopItemWidth();
+    tooltip(
+        "Presentation of interlaced (480i) video modes.\n"
+        "weave - show both fields, combing is visible in motion.\n"
+        "bob - show lines of the last drawn field only, doubled to full height.");
+
     ImGui::End();
 }
 
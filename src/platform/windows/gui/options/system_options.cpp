@@ -1,6 +1,7 @@
 #include "system_options.h"
 #include "config.h"
 #include <imgui.h>
+#include <magic_enum.hpp>
 
 namespace gui::options {
 void System::displayWindows() {
@@ -12,6 +13,28 @@ void System::displayWindows() {
         bus.notify(Event::System::HardReset{});
     }
 
+    ImGui::Text("CPU core");
+    ImGui::SameLine();
+    if (ImGui::BeginCombo("##cpu_core", std::string(magic_enum::enum_name(config.options.system.cpuCore)).c_str())) {
+        for (auto& core : magic_enum::enum_entries<CpuCore>()) {
+            if (ImGui::Selectable(std::string(core.second).c_str(), core.first == config.options.system.cpuCore)) {
+                config.options.system.cpuCore = core.first;
+                bus.notify(Event::System::HardReset{});
+            }
+        }
+        ImGui::EndCombo();
+    }
+
+    if (ImGui::Checkbox("Skip idle loops", &config.options.system.idleLoops.enabled)) {
+        bus.notify(Event::System::HardReset{});
+    }
+
+    if (config.options.system.cpuCore == CpuCore::recompiler) {
+        if (ImGui::Checkbox("Fastmem", &config.options.system.fastmem)) {
+            bus.notify(Event::System::HardReset{});
+        }
+    }
+
     ImGui::PushStyleColor(ImGuiCol_Text, ImVec4(0.8f, 0.8f, 0.8f, 1.f));
     ImGui::Text(
         "Warning: Changing any of these settings\n"
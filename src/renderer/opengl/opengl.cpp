@@ -184,14 +184,14 @@ void OpenGL::bindCopyAttributes() {
     copyShader->getAttrib("texcoord").pointer(2, GL_FLOAT, sizeof(BlitStruct), 2 * sizeof(float));
 }
 
-void OpenGL::update24bitTexture(gpu::GPU* gpu) {
+void OpenGL::update24bitTexture(gpu::GPU* gpu, int firstRow, int rows) {
     size_t dataSize = gpu::VRAM_HEIGHT * gpu::VRAM_WIDTH * 3;
     if (vram24Unpacked.size() != dataSize) {
         vram24Unpacked.resize(dataSize);
     }
 
     // Unpack VRAM to 8 bit RGB values (two pixels at the time)
-    for (int y = 0; y < gpu::VRAM_HEIGHT; y++) {
+    for (int y = firstRow; y < firstRow + rows; y++) {
         unsigned int gpuOffset = y * gpu::VRAM_WIDTH;
         unsigned int texOffset = y * gpu::VRAM_WIDTH * 3;
         for (int x = 0; x < gpu::VRAM_WIDTH; x += 3) {
@@ -217,12 +217,12 @@ void OpenGL::update24bitTexture(gpu::GPU* gpu) {
             texOffset += 6;
         }
     }
-    vram24Tex->update(vram24Unpacked.data());
+    vram24Tex->update(&vram24Unpacked[firstRow * gpu::VRAM_WIDTH * 3], firstRow, rows);
 }
 
-void OpenGL::updateVramTexture(gpu::GPU* gpu) {
+void OpenGL::updateVramTexture(gpu::GPU* gpu, int firstRow, int rows) {
     if (supportNativeTexture) {
-        vramTex->update(gpu->vram.data());
+        vramTex->update(&gpu->vram[firstRow * gpu::VRAM_WIDTH], firstRow, rows);
         return;
     }
 
@@ -232,14 +232,14 @@ void OpenGL::updateVramTexture(gpu::GPU* gpu) {
     }
 
     // Unpack VRAM to native GPU format
-    for (int y = 0; y < gpu::VRAM_HEIGHT; y++) {
+    for (int y = firstRow; y < firstRow + rows; y++) {
         for (int x = 0; x < gpu::VRAM_WIDTH; x++) {
             unsigned int pos = y * gpu::VRAM_WIDTH + x;
 
             vramUnpacked[pos] = PSXColor(gpu->vram[pos]).rev();
         }
     }
-    vramTex->update(vramUnpacked.data());
+    vramTex->update(&vramUnpacked[firstRow * gpu::VRAM_WIDTH], firstRow, rows);
 }
 
 void OpenGL::renderVertices(gpu::GPU* gpu) {
@@ -380,6 +380,12 @@ void OpenGL::renderBlit(gpu::GPU* gpu, bool software) {
 
     blitShader->getUniform("displayEnabled").i(!gpu->displayDisable);
 
+    // Bob - lines of the field that is about to be displayed are doubled, -1 shows both fields
+    bool bob = software && config.options.graphics.deinterlacing == Deinterlacing::bob && gpu->gp1_08.interlace &&
+               gpu->gp1_08.verticalResolution == gpu::GP1_08::VerticalResolution::r480;
+    blitShader->getUniform("field").i(bob ? gpu->displayedField() : -1);
+    blitShader->getUniform("displayStartY").i(gpu->displayAreaStartY);
+
     glViewport(x, y, w, h);
     blitBuffer->update(bb.size() * sizeof(BlitStruct), bb.data());
 
@@ -406,12 +412,26 @@ void OpenGL::render(gpu::GPU* gpu) {
     glClearColor(0.f, 0.f, 0.f, 1.f);
     glClear(GL_COLOR_BUFFER_BIT);
 
+    // Blit reads only the display area, whole VRAM is needed as a texture source for hardware rendering
+    // Display area wrapping past the bottom edge continues from the top of VRAM, wrapped rows are uploaded separately
+    int firstRow = 0;
+    int rows = gpu::VRAM_HEIGHT;
+    int wrappedRows = 0;
+    if (!hardwareRendering || gpu->gp1_08.colorDepth == gpu::GP1_08::ColorDepth::bit24) {
+        firstRow = gpu->displayAreaStartY % gpu::VRAM_HEIGHT;
+        rows = std::min<int>(gpu->gp1_08.getVerticalResoulution(), gpu::VRAM_HEIGHT);
+        wrappedRows = std::max(0, firstRow + rows - gpu::VRAM_HEIGHT);
+        rows -= wrappedRows;
+    }
+
     if (gpu->gp1_08.colorDepth == gpu::GP1_08::ColorDepth::bit24) {
         // HACK: Force software rendering for movies (24bit mode)
-        update24bitTexture(gpu);
+        update24bitTexture(gpu, firstRow, rows);
+        if (wrappedRows > 0) update24bitTexture(gpu, 0, wrappedRows);
         renderBlit(gpu, true);
     } else {
-        updateVramTexture(gpu);
+        updateVramTexture(gpu, firstRow, rows);
+        if (wrappedRows > 0) updateVramTexture(gpu, 0, wrappedRows);
 
         if (hardwareRendering) {
             // Render all GPU commands
@@ -69,8 +69,9 @@ class OpenGL {
 
     std::vector<uint8_t> vram24Unpacked;
     std::vector<uint16_t> vramUnpacked;
-    void update24bitTexture(gpu::GPU* gpu);
-    void updateVramTexture(gpu::GPU* gpu);
+    // Only rows [firstRow, firstRow + rows) of VRAM are uploaded
+    void update24bitTexture(gpu::GPU* gpu, int firstRow, int rows);
+    void updateVramTexture(gpu::GPU* gpu, int firstRow, int rows);
 
     void bindBlitAttributes();
     std::vector<BlitStruct> makeBlitBuf(int screenX = 0, int screenY = 0, int screenW = 640, int screenH = 480, bool invert = false);
@@ -30,6 +30,11 @@ void Texture::update(const void* data) {
     glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, width, height, dataFormat, type, data);
 }
 
+void Texture::update(const void* data, int y, int h) {
+    glBindTexture(GL_TEXTURE_2D, id);
+    glTexSubImage2D(GL_TEXTURE_2D, 0, 0, y, width, h, dataFormat, type, data);
+}
+
 void Texture::bind(int sampler) {
     glActiveTexture(GL_TEXTURE0 + sampler);
     glBindTexture(GL_TEXTURE_2D, id);
@@ -15,6 +15,8 @@ class Texture {
     ~Texture();
 
     void update(const void* data);
+    // Updates rows [y, y + h) only, data points to the first updated row
+    void update(const void* data, int y, int h);
     void bind(int sampler = 0);
     GLuint get();
     int getWidth();
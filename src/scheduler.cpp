@@ -0,0 +1,114 @@
+#include "scheduler.h"
+#include <algorithm>
+#include "system.h"
+
+Scheduler::Scheduler(System* sys) : sys(sys) {
+    timestamps.fill(NEVER);
+    position.fill(-1);
+}
+
+uint64_t Scheduler::now() const { return sys->cycles * CYCLES_PER_INSTRUCTION; }
+
+void Scheduler::schedule(Event event, uint64_t timestamp) {
+    int i = position[index(event)];
+    if (i == -1) {
+        i = size++;
+        heap[i] = event;
+        position[index(event)] = i;
+    }
+    uint64_t previous = timestamps[index(event)];
+    timestamps[index(event)] = timestamp;
+
+    if (previous == NEVER || timestamp < previous) {
+        siftUp(i);
+    } else {
+        siftDown(i);
+    }
+
+    if (timestamp < sliceEnd) yield = true;
+}
+
+void Scheduler::cancel(Event event) {
+    if (position[index(event)] == -1) return;
+    remove(event);
+}
+
+int Scheduler::beginSlice() {
+    uint64_t current = now();
+    uint64_t end = std::min(nextTimestamp(), current + MAX_SLICE);
+    int instructions = 1;
+    if (end > current) {
+        instructions = static_cast<int>((end - current + CYCLES_PER_INSTRUCTION - 1) / CYCLES_PER_INSTRUCTION);
+    }
+
+    sliceEnd = current + instructions * CYCLES_PER_INSTRUCTION;
+    yield = false;
+    return instructions;
+}
+
+void Scheduler::endSlice() {
+    sliceEnd = 0;
+    yield = false;
+}
+
+bool Scheduler::popDue(Event& event, uint64_t& timestamp) {
+    if (size == 0 || timestamps[index(heap[0])] > now()) return false;
+
+    event = heap[0];
+    timestamp = timestamps[index(event)];
+    remove(event);
+    return true;
+}
+
+void Scheduler::swap(int a, int b) {
+    std::swap(heap[a], heap[b]);
+    position[index(heap[a])] = a;
+    position[index(heap[b])] = b;
+}
+
+void Scheduler::siftUp(int i) {
+    while (i > 0) {
+        int parent = (i - 1) / 2;
+        if (!earlier(i, parent)) break;
+        swap(i, parent);
+        i = parent;
+    }
+}
+
+void Scheduler::siftDown(int i) {
+    for (;;) {
+        int smallest = i;
+        for (int child : {2 * i + 1, 2 * i + 2}) {
+            if (child < size && earlier(child, smallest)) smallest = child;
+        }
+        if (smallest == i) break;
+        swap(i, smallest);
+        i = smallest;
+    }
+}
+
+void Scheduler::remove(Event event) {
+    int i = position[index(event)];
+    int last = --size;
+    if (i != last) {
+        swap(i, last);
+    }
+    position[index(event)] = -1;
+    timestamps[index(event)] = NEVER;
+
+    if (i != last) {
+        siftUp(i);
+        siftDown(i);
+    }
+}
+
+void Scheduler::rebuild() {
+    size = 0;
+    position.fill(-1);
+    for (int e = 0; e < EVENT_COUNT; e++) {
+        if (timestamps[e] == NEVER) continue;
+        heap[size] = static_cast<Event>(e);
+        position[e] = size;
+        siftUp(size++);
+    }
+}
@@ -0,0 +1,67 @@
+#pragma once
+#include <array>
+#include <cstdint>
+
+struct System;
+
+/**
+ * Min-heap of device events ordered by their deadlines.
+ *
+ * Time is measured in system clock cycles, CPU executes one instruction every CYCLES_PER_INSTRUCTION.
+ * Devices schedule their next deadline (timer reaching target, sector read, end of line, ...) and are
+ * synchronized lazily when their registers are accessed, so the CPU can run uninterrupted until the nearest event.
+ * Each event type can be scheduled at most once, rescheduling replaces the previous deadline.
+ */
+class Scheduler {
+   public:
+    enum class Event { timer0, timer1, timer2, cdrom, gpu, spu, controller, dma };
+    static const int EVENT_COUNT = 8;
+    static const int CYCLES_PER_INSTRUCTION = 3;
+    static const uint64_t NEVER = UINT64_MAX;
+
+    // Set when an event is scheduled before the end of current CPU time slice, CPU returns as soon as possible
+    bool yield = false;
+
+    Scheduler(System* sys);
+
+    uint64_t now() const;
+    void schedule(Event event, uint64_t timestamp);
+    void cancel(Event event);
+    uint64_t nextTimestamp() const { return size == 0 ? NEVER : timestamps[index(heap[0])]; }
+
+    // Number of instructions CPU can execute before the nearest event
+    int beginSlice();
+    void endSlice();
+    // Removes the earliest event if its deadline has passed
+    bool popDue(Event& event, uint64_t& timestamp);
+
+    template <class Archive>
+    void save(Archive& ar) const {
+        ar(timestamps);
+    }
+
+    template <class Archive>
+    void load(Archive& ar) {
+        ar(timestamps);
+        rebuild();
+    }
+
+   private:
+    // Slices are limited so that the instruction count fits int
+    static const uint64_t MAX_SLICE = 1'000'000;
+
+    System* sys;
+    std::array<uint64_t, EVENT_COUNT> timestamps;  // NEVER if not scheduled
+    std::array<Event, EVENT_COUNT> heap;
+    std::array<int, EVENT_COUNT> position;  // Index in heap, -1 if not scheduled
+    int size = 0;
+    uint64_t sliceEnd = 0;  // 0 outside of CPU execution
+
+    static int index(Event event) { return static_cast<int>(event); }
+    bool earlier(int a, int b) const { return timestamps[index(heap[a])] < timestamps[index(heap[b])]; }
+    void swap(int a, int b);
+    void siftUp(int i);
+    void siftDown(int i);
+    void remove(Event event);
+    void rebuild();
+};
@@ -3,8 +3,8 @@
 #include "tables.h"
 
 namespace ADPCM {
-int filterTablePos[5] = {0, 60, 115, 98, 122};
-int filterTableNeg[5] = {0, 0, -52, -55, -60};
+const int filterTablePos[5] = {0, 60, 115, 98, 122};
+const int filterTableNeg[5] = {0, 0, -52, -55, -60};
 
 int16_t clamp_16bit(int32_t sample) {
     if (sample > 0x7fff) return 0x7fff;
@@ -57,17 +57,11 @@ std::vector<int16_t> decode(uint8_t buffer[16], int32_t prevSample[2]) {
     return decoded;
 }
 
-// Separate buffers and counters for left and right channels
-// TODO: Come up with better solution. Are two buffers really necessary?
-int16_t ringbuf[2][0x20] = {};
-int p[2] = {};
-int sixstep[2] = {6, 6};
-
 template <int ch>
-int16_t doZigzag(int p, int table) {
+int16_t doZigzag(const XADecoder& decoder, int p, int table) {
     int32_t sum = 0;
     for (int i = 1; i < 29; i++) {
-        sum += (ringbuf[ch][(p - i) & 0x1f] * zigzagTables[table][i]) / 0x8000;
+        sum += (decoder.ringbuf[ch][(p - i) & 0x1f] * zigzagTables[table][i]) / 0x8000;
     }
     return clamp_16bit(sum);
 }
@@ -75,13 +69,13 @@ int16_t doZigzag(int p, int table) {
 // sampleRate == false - 37800Hz
 // sampleRate == true  - 18900Hz - double output samples
 template <int ch>
-void interpolate(int16_t sample, std::vector<int16_t>& output, bool sampleRate = false) {
-    ringbuf[ch][p[ch]++ & 0x1f] = sample;
+void interpolate(XADecoder& decoder, int16_t sample, std::vector<int16_t>& output, bool sampleRate = false) {
+    decoder.ringbuf[ch][decoder.p[ch]++ & 0x1f] = sample;
 
-    if (--sixstep[ch] == 0) {
-        sixstep[ch] = 6;
+    if (--decoder.sixstep[ch] == 0) {
+        decoder.sixstep[ch] = 6;
         for (int table = 0; table < 7; table++) {
-            int16_t v = doZigzag<ch>(p[ch], table);
+            int16_t v = doZigzag<ch>(decoder, decoder.p[ch], table);
             output.push_back(v);
             if (sampleRate) output.push_back(v);
         }
@@ -91,7 +85,9 @@ void interpolate(int16_t sample, std::vector<int16_t>& output, bool sampleRate =
 enum class Channel { mono, left, right };
 
 template <Channel channel>
-std::vector<int16_t> decodePacket(uint8_t buffer[128], int32_t prevSample[2], bool sampleRate) {
+std::vector<int16_t> decodePacket(uint8_t buffer[128], XADecoder& decoder, bool sampleRate) {
+    constexpr int ch = channel == Channel::right ? 1 : 0;
+    int32_t* prevSample = decoder.prevSample[ch];
     std::vector<int16_t> decoded;
 
     std::vector<int> blocks;
@@ -132,11 +128,7 @@ std::vector<int16_t> decodePacket(uint8_t buffer[128], int32_t prevSample[2], bo
 
             // clamp to -0x8000 +0x7fff
             // Intepolate 37800Hz to 44100Hz
-            if (channel == Channel::mono || channel == Channel::left) {
-                interpolate<0>(clamp_16bit(sample), decoded, sampleRate);
-            } else {
-                interpolate<1>(clamp_16bit(sample), decoded, sampleRate);
-            }
+            interpolate<ch>(decoder, clamp_16bit(sample), decoded, sampleRate);
 
             // Move previous samples forward
             prevSample[1] = prevSample[0];
@@ -147,23 +139,20 @@ std::vector<int16_t> decodePacket(uint8_t buffer[128], int32_t prevSample[2], bo
     return decoded;
 }
 
-std::vector<std::pair<int16_t, int16_t>> decodeXA(uint8_t buffer[128 * 18], cd::Codinginfo codinginfo) {
-    static int32_t prevSampleLeft[2] = {};
-    static int32_t prevSampleRight[2] = {};
-
+std::vector<std::pair<int16_t, int16_t>> decodeXA(uint8_t buffer[128 * 18], cd::Codinginfo codinginfo, XADecoder& decoder) {
     std::vector<std::pair<int16_t, int16_t>> frame;
 
     // Each sector contains of 18 128-byte portions
     for (int packet = 0; packet < 18; packet++) {
         if (codinginfo.stereo) {
-            auto l = decodePacket<Channel::left>(buffer + packet * 128, prevSampleLeft, codinginfo.sampleRate);
-            auto r = decodePacket<Channel::right>(buffer + packet * 128, prevSampleRight, codinginfo.sampleRate);
+            auto l = decodePacket<Channel::left>(buffer + packet * 128, decoder, codinginfo.sampleRate);
+            auto r = decodePacket<Channel::right>(buffer + packet * 128, decoder, codinginfo.sampleRate);
 
             for (int i = 0; i < l.size(); i++) {
                 frame.emplace_back(l[i], r[i]);
             }
         } else {
-            auto mono = decodePacket<Channel::mono>(buffer + packet * 128, prevSampleLeft, codinginfo.sampleRate);
+            auto mono = decodePacket<Channel::mono>(buffer + packet * 128, decoder, codinginfo.sampleRate);
             for (auto sample : mono) {
                 frame.emplace_back(sample, sample);
             }
@@ -17,6 +17,15 @@ enum Flag {
                          // 1 - Load currentAddress to repeatAddress
                          // 0 - Nothing
 };
+
+// XA decoding state carried between sectors, separate for left and right channel (mono uses left)
+struct XADecoder {
+    int32_t prevSample[2][2] = {};
+    int16_t ringbuf[2][0x20] = {};  // Input of 37800Hz -> 44100Hz interpolation
+    int p[2] = {};
+    int sixstep[2] = {6, 6};
+};
+
 std::vector<int16_t> decode(uint8_t buffer[16], int32_t prevSample[2]);
-std::vector<std::pair<int16_t, int16_t>> decodeXA(uint8_t buffer[128 * 18], cd::Codinginfo codinginfo);
+std::vector<std::pair<int16_t, int16_t>> decodeXA(uint8_t buffer[128 * 18], cd::Codinginfo codinginfo, XADecoder& decoder);
 };  // namespace ADPCM
\ No newline at end of file
@@ -10,6 +10,7 @@
 #include <deque>
 #include <sstream>
 #include "config.h"
+#include "cpu/backend.h"
 #include "disc/load.h"
 #include "system.h"
 #include "utils/file.h"
@@ -20,7 +21,7 @@ namespace state {
 const char* lastSaveName = "last.state";
 
 struct StateMetadata {
-    inline static const uint32_t SAVESTATE_VERSION = 8;
+    inline static const uint32_t SAVESTATE_VERSION = 9;
 
     uint32_t version = SAVESTATE_VERSION;
     std::string biosPath;
@@ -60,6 +61,13 @@ struct StateMetadata {
 
         ar(*sys);
 
+        sys->mapMemory();
+
+        // RAM was replaced, previously compiled code is no longer valid
+        if (sys->cpu->backend) {
+            sys->cpu->backend->flush();
+        }
+
         if (!biosPath.empty() && biosPath != sys->biosPath) {
             sys->loadBios(biosPath);
         }
@@ -68,7 +76,7 @@ struct StateMetadata {
             std::unique_ptr<disc::Disc> disc = disc::load(discPath);
             if (!disc) {
                 sys->cdrom->setShell(true);
-                toast(fmt::format("Cannot load {}", discPath));
+                toast(sys->bus, fmt::format("Cannot load {}", discPath));
             } else {
                 sys->cdrom->disc = std::move(disc);
             }
@@ -95,7 +103,7 @@ bool load(System* sys, const SaveState& state) {
     try {
         archive(metadata);
     } catch (std::exception& e) {
-        toast("Incompatible save state version");
+        toast(sys->bus, "Incompatible save state version");
         sys->state = System::State::halted;
         return false;
     }
@@ -140,9 +148,9 @@ void quickSave(System* sys, int slot) {
     auto path = getStatePath(sys, slot);
     auto state = state::save(sys);
     if (putFileContents(path, state)) {
-        toast(fmt::format("State {} saved", slot));
+        toast(sys->bus, fmt::format("State {} saved", slot));
     } else {
-        toast(fmt::format("Cannot save state {}", slot));
+        toast(sys->bus, fmt::format("Cannot save state {}", slot));
     }
 }
 
@@ -150,11 +158,11 @@ void quickLoad(System* sys, int slot) {
     auto path = getStatePath(sys, slot);
     auto state = getFileContentsAsString(path);
     if (state.empty()) {
-        toast(fmt::format("Cannot load state {}", slot));
+        toast(sys->bus, fmt::format("Cannot load state {}", slot));
         return;
     }
     if (state::load(sys, state)) {
-        toast(fmt::format("State {} loaded", slot));
+        toast(sys->bus, fmt::format("State {} loaded", slot));
     }
 }
 
@@ -172,7 +180,7 @@ void manageTimeTravel(System* sys) {
     if (now - lastTime >= timeTravelInterval) {
         lastTime = now;
 
-        bool timeTravelEnabled = config.options.emulator.timeTravel;
+        bool timeTravelEnabled = sys->config.options.emulator.timeTravel;
         if (!timeTravelEnabled) {
             return;
         }
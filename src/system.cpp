@@ -4,14 +4,21 @@
 #include <cstring>
 #include "bios/functions.h"
 #include "config.h"
+#include "cpu/backend.h"
 #include "sound/sound.h"
 #include "utils/address.h"
 #include "utils/gpu_draw_list.h"
 #include "utils/file.h"
 #include "utils/psx_exe.h"
 
-System::System() {
+System::System(const avocado_config_t& config, Dexode::EventBus& bus) : config(config), bus(bus) {
+    if (config.options.system.fastmem && config.options.system.cpuCore == CpuCore::recompiler) {
+        hostMemory = HostMemory::create(PAGE_COUNT * PAGE_SIZE, RAM_SIZE_8MB + BIOS_SIZE);
+        if (!hostMemory) fmt::print("[SYS] Fastmem is not supported on this host\n");
+    }
+
     bios.fill(0);
+    ram = std::vector<uint8_t, HostAllocator<uint8_t>>(HostAllocator<uint8_t>(hostMemory.get()));
     ram.resize(!config.options.system.ram8mb ? RAM_SIZE_2MB : RAM_SIZE_8MB, 0);
     scratchpad.fill(0);
     expansion.fill(0);
@@ -19,15 +26,15 @@ System::System() {
     cpu = std::make_unique<mips::CPU>(this);
     gpu = std::make_unique<gpu::GPU>(this);
     spu = std::make_unique<spu::SPU>(this);
-    mdec = std::make_unique<mdec::MDEC>();
+    mdec = std::make_unique<mdec::MDEC>(this);
 
     cdrom = std::make_unique<device::cdrom::CDROM>(this);
     controller = std::make_unique<device::controller::Controller>(this);
     dma = std::make_unique<device::dma::DMA>(this);
-    expansion2 = std::make_unique<Expansion2>();
+    expansion2 = std::make_unique<Expansion2>(this);
     interrupt = std::make_unique<Interrupt>(this);
-    memoryControl = std::make_unique<MemoryControl>();
-    ramControl = std::make_unique<RamControl>();
+    memoryControl = std::make_unique<MemoryControl>(this);
+    ramControl = std::make_unique<RamControl>(this);
     cacheControl = std::make_unique<CacheControl>(this);
     serial = std::make_unique<Serial>();
     for (int t : {0, 1, 2}) {
@@ -37,7 +44,57 @@ System::System() {
     debugOutput = config.debug.log.system;
     biosLog = config.debug.log.bios;
 
-    cycles = 0;
+    scheduler.schedule(Scheduler::Event::gpu, scheduler.now() + gpu->cyclesUntilNextLine());
+    scheduleSpu(scheduler.now());
+
+    mapMemory();
+}
+
+void System::mapMemory() {
+    readPages.assign(PAGE_COUNT, nullptr);
+    writePages.assign(PAGE_COUNT, nullptr);
+    isolatedWritePages.assign(PAGE_COUNT, nullptr);
+
+    auto map = [&](std::vector<uint8_t*>& pages, uint32_t base, uint32_t size, uint8_t* memory, uint32_t memorySize) {
+        for (uint32_t offset = 0; offset < size; offset += PAGE_SIZE) {
+            pages[(base + offset) >> PAGE_BITS] = memory + (offset & (memorySize - 1));
+        }
+    };
+
+    // RAM is mirrored over the whole 8MB region
+    map(readPages, RAM_BASE, RAM_SIZE_8MB, ram.data(), ram.size());
+    map(writePages, RAM_BASE, RAM_SIZE_8MB, ram.data(), ram.size());
+    map(readPages, EXPANSION_BASE, EXPANSION_SIZE, expansion.data(), EXPANSION_SIZE);
+    map(writePages, EXPANSION_BASE, EXPANSION_SIZE, expansion.data(), EXPANSION_SIZE);
+    map(readPages, BIOS_BASE, BIOS_SIZE, bios.data(), BIOS_SIZE);
+    // Scratchpad is smaller than a page, it is handled in slow path
+
+    // RAM might end up on the heap if loaded state has different RAM size
+    fastmem = nullptr;
+    if (hostMemory && ram.data() == hostMemory->view(0)) {
+        hostMemory->reset();
+        for (uint32_t mirror = RAM_BASE; mirror < RAM_BASE + RAM_SIZE_8MB; mirror += ram.size()) {
+            hostMemory->map(mirror, 0, ram.size(), true);
+        }
+        memcpy(hostMemory->view(RAM_SIZE_8MB), bios.data(), BIOS_SIZE);
+        hostMemory->map(BIOS_BASE, RAM_SIZE_8MB, BIOS_SIZE, false);
+        fastmem = hostMemory->base();
+    }
+
+    updateCacheIsolation();
+}
+
+void System::setRamPageWritable(uint32_t ramPage, bool writable) {
+    uint32_t offset = ramPage * PAGE_SIZE;
+    if (offset >= ram.size()) return;
+    for (uint32_t mirror = RAM_BASE; mirror < RAM_BASE + RAM_SIZE_8MB; mirror += ram.size()) {
+        writePages[(mirror + offset) >> PAGE_BITS] = writable ? ram.data() + offset : nullptr;
+        if (fastmem) hostMemory->protect(mirror + offset, PAGE_SIZE, writable);
+    }
+}
+
+void System::updateCacheIsolation() {
+    activeWritePages = cpu->cop0.status.isolateCache ? isolatedWritePages.data() : writePages.data();
 }
 
 // Note: stupid static_casts and asserts are only to suppress MSVC warnings
@@ -147,18 +204,13 @@ INLINE T System::readMemory(uint32_t address) {
 
     uint32_t addr = align_mips<T>(address);
 
-    if (in_range<RAM_BASE, RAM_SIZE_8MB>(addr)) {
-        return read_fast<T>(ram.data(), (addr - RAM_BASE) & (ram.size() - 1));
-    }
-    if (in_range<EXPANSION_BASE, EXPANSION_SIZE>(addr)) {
-        return read_fast<T>(expansion.data(), addr - EXPANSION_BASE);
+    // RAM, expansion and BIOS
+    if (uint8_t* page = readPages[addr >> PAGE_BITS]; likely(page != nullptr)) {
+        return read_fast<T>(page, addr & (PAGE_SIZE - 1));
     }
     if (in_range<SCRATCHPAD_BASE, SCRATCHPAD_SIZE>(addr)) {
         return read_fast<T>(scratchpad.data(), addr - SCRATCHPAD_BASE);
     }
-    if (in_range<BIOS_BASE, BIOS_SIZE>(addr)) {
-        return read_fast<T>(bios.data(), addr - BIOS_BASE);
-    }
 
     READ_IO(0x1f801000, 0x1f801024, memoryControl);
     READ_IO(0x1f801040, 0x1f801050, controller);
@@ -190,6 +242,13 @@ template <typename T>
 INLINE void System::writeMemory(uint32_t address, T data) {
     static_assert(std::is_same<T, uint8_t>() || std::is_same<T, uint16_t>() || std::is_same<T, uint32_t>(), "Invalid type used");
 
+    uint32_t addr = align_mips<T>(address);
+
+    // RAM without cached code and expansion, all pages are unmapped when cache is isolated
+    if (uint8_t* page = activeWritePages[addr >> PAGE_BITS]; likely(page != nullptr)) {
+        return write_fast<T>(page, addr & (PAGE_SIZE - 1), data);
+    }
+
     if (unlikely(cpu->cop0.status.isolateCache)) {
         uint32_t tag = (address & 0xfffff000) >> 12;
         uint16_t index = (address & 0xffc) >> 2;
@@ -197,13 +256,10 @@ INLINE void System::writeMemory(uint32_t address, T data) {
         return;
     }
 
-    uint32_t addr = align_mips<T>(address);
-
     if (in_range<RAM_BASE, RAM_SIZE_8MB>(addr)) {
-        return write_fast<T>(ram.data(), (addr - RAM_BASE) & (ram.size() - 1), data);
-    }
-    if (in_range<EXPANSION_BASE, EXPANSION_SIZE>(addr)) {
-        return write_fast<T>(expansion.data(), addr - EXPANSION_BASE, data);
+        uint32_t ramAddr = (addr - RAM_BASE) & (ram.size() - 1);
+        if (cpu->backend) cpu->backend->invalidate(ramAddr);
+        return write_fast<T>(ram.data(), ramAddr, data);
     }
     if (in_range<SCRATCHPAD_BASE, SCRATCHPAD_SIZE>(addr)) {
         return write_fast<T>(scratchpad.data(), addr - SCRATCHPAD_BASE, data);
@@ -331,17 +387,7 @@ void System::singleStep() {
     cpu->executeInstructions(1);
     state = State::pause;
 
-    dma->step();
-    cdrom->step(3);
-    timer[0]->step(3);
-    timer[1]->step(3);
-    timer[2]->step(3);
-    controller->step();
-    spu->step(cdrom.get());
-
-    if (gpu->emulateGpuCycles(3)) {
-        interrupt->trigger(interrupt::VBLANK);
-    }
+    runEvents();
 }
 
 void System::emulateFrame() {
@@ -350,80 +396,132 @@ void System::emulateFrame() {
 #endif
     cpu->gte.log.clear();
 
-    if (GpuDrawList::currentFrame == 0) {
-        gpu->prevVram = gpu->vram;
-
-        // Save initial state
-        if (gpu->gpuLogEnabled) {
-            gpu->gpuLogList.clear();
-            GpuDrawList::dumpInitialState(gpu.get());
-        }
+    // Save initial state, VRAM snapshot is only needed to replay captured commands
+    if (gpu->currentCaptureFrame == 0 && gpu->gpuLogEnabled) {
+        gpu->gpuLogList.clear();
+        GpuDrawList::dumpInitialState(gpu.get());
     }
 
-    if (++GpuDrawList::currentFrame >= GpuDrawList::framesToCapture) {
-        GpuDrawList::currentFrame = 0;
-        if (GpuDrawList::framesToCapture != 0) {
-            toast(fmt::format("{} frames capture complete", GpuDrawList::framesToCapture));
-            GpuDrawList::framesToCapture = 0;
+    if (++gpu->currentCaptureFrame >= gpu->framesToCapture) {
+        gpu->currentCaptureFrame = 0;
+        if (gpu->framesToCapture != 0) {
+            toast(bus, fmt::format("{} frames capture complete", gpu->framesToCapture));
+            gpu->framesToCapture = 0;
             state = State::pause;
             return;
         }
     }
 
-    int systemCycles = 300;
     for (;;) {
-        if (!cpu->executeInstructions(systemCycles / 3)) {
-            return;
+        if (runEvents()) {
+            return;  // frame emulated
         }
 
-        dma->step();
-        cdrom->step(systemCycles / 1.5f);
-        timer[0]->step(systemCycles);
-        timer[1]->step(systemCycles);
-        timer[2]->step(systemCycles);
-
-        static float spuCounter = 0;
-
-        float magicNumber = 1.575f;
-        if (!gpu->isNtsc()) {
-            // Hack to prevent crackling audio on PAL games
-            // Note - this overclocks SPU clock, bugs might appear.
-            magicNumber *= 50.f / 60.f;
+        int instructions = scheduler.beginSlice();
+        bool ok;
+        if (unlikely(hostTime.enabled)) {
+            uint64_t start = timing::hostNanoseconds();
+            uint64_t gpuTime = hostTime.gpu;
+            ok = cpu->executeInstructions(instructions);
+            hostTime.cpu += timing::hostNanoseconds() - start - (hostTime.gpu - gpuTime);
+        } else {
+            ok = cpu->executeInstructions(instructions);
         }
-        spuCounter += (float)systemCycles / magicNumber / (float)0x300;
-        if (spuCounter >= 1.f) {
-            spu->step(cdrom.get());
-            spuCounter -= 1.0f;
+        scheduler.endSlice();
+        if (!ok) {
+            return;
         }
+    }
+}
 
-        if (spu->bufferReady) {
-            spu->bufferReady = false;
-            Sound::appendBuffer(spu->audioBuffer.begin(), spu->audioBuffer.end());
+bool System::runEvents() {
+    bool frameEnded = false;
+    Scheduler::Event event;
+    uint64_t timestamp;
+    while (scheduler.popDue(event, timestamp)) {
+        if (unlikely(hostTime.enabled)) {
+            uint64_t start = timing::hostNanoseconds();
+            uint64_t gpuTime = hostTime.gpu;
+            if (handleEvent(event, timestamp)) frameEnded = true;
+            hostTime.events[static_cast<int>(event)] += timing::hostNanoseconds() - start - (hostTime.gpu - gpuTime);
+        } else if (handleEvent(event, timestamp)) {
+            frameEnded = true;
         }
+    }
+    return frameEnded;
+}
 
-        controller->step();
-
-        if (gpu->emulateGpuCycles(systemCycles)) {
-            interrupt->trigger(interrupt::VBLANK);
-            return;  // frame emulated
+bool System::handleEvent(Scheduler::Event event, uint64_t timestamp) {
+    switch (event) {
+        case Scheduler::Event::timer0:
+        case Scheduler::Event::timer1:
+        case Scheduler::Event::timer2: {
+            auto& t = *timer[static_cast<int>(event) - static_cast<int>(Scheduler::Event::timer0)];
+            t.sync();
+            t.scheduleEvent();
+            break;
         }
 
-        // TODO: Move this code to Timer class
-        if (gpu->gpuLine > gpu->linesPerFrame() - 20) {
-            auto& t = *timer[1];
-            if (t.mode.syncEnabled) {
-                using modes = device::timer::CounterMode::SyncMode1;
-                auto mode1 = static_cast<modes>(timer[1]->mode.syncMode);
-                if (mode1 == modes::resetAtVblank || mode1 == modes::resetAtVblankAndPauseOutside) {
-                    timer[1]->current._reg = 0;
-                } else if (mode1 == modes::pauseUntilVblankAndFreerun) {
-                    timer[1]->paused = false;
-                    timer[1]->mode.syncEnabled = false;
+        case Scheduler::Event::cdrom:
+            cdrom->sync();
+            cdrom->scheduleEvent();
+            break;
+
+        case Scheduler::Event::gpu: {
+            bool frameEnded = gpu->emulateGpuCycles(gpu->cyclesUntilNextLine());
+            scheduler.schedule(Scheduler::Event::gpu, timestamp + gpu->cyclesUntilNextLine());
+            if (frameEnded) {
+                interrupt->trigger(interrupt::VBLANK);
+                return true;
+            }
+
+            // TODO: Move this code to Timer class
+            if (gpu->gpuLine > gpu->linesPerFrame() - 20) {
+                auto& t = *timer[1];
+                if (t.mode.syncEnabled) {
+                    t.sync();
+                    using modes = device::timer::CounterMode::SyncMode1;
+                    auto mode1 = static_cast<modes>(t.mode.syncMode);
+                    if (mode1 == modes::resetAtVblank || mode1 == modes::resetAtVblankAndPauseOutside) {
+                        t.current._reg = 0;
+                    } else if (mode1 == modes::pauseUntilVblankAndFreerun) {
+                        t.paused = false;
+                        t.mode.syncEnabled = false;
+                    }
+                    t.scheduleEvent();
                 }
             }
+            // Handle Timer1 - Reset on VBlank
+            break;
         }
-        // Handle Timer1 - Reset on VBlank
+
+        case Scheduler::Event::spu:
+            spu->step(cdrom.get());
+            if (spu->bufferReady) {
+                spu->bufferReady = false;
+                Sound::appendBuffer(spu->audioBuffer.begin(), spu->audioBuffer.end());
+            }
+            scheduleSpu(timestamp);
+            break;
+
+        case Scheduler::Event::controller: controller->step(); break;
+
+        case Scheduler::Event::dma: dma->step(); break;
     }
+    return false;
+}
+
+void System::scheduleSpu(uint64_t timestamp) {
+    // One sample every 0x300 cycles, slowed down by magic number 1.575
+    uint32_t period = 0x300 * 1575;
+    if (!gpu->isNtsc()) {
+        // Hack to prevent crackling audio on PAL games
+        // Note - this overclocks SPU clock, bugs might appear.
+        period = period * 50 / 60;
+    }
+    spuPhase += period;
+    scheduler.schedule(Scheduler::Event::spu, timestamp + spuPhase / 1000);
+    spuPhase %= 1000;
 }
 
 void System::softReset() {
@@ -512,6 +610,8 @@ bool System::loadBios(const std::string& path) {
         patch(0x6F14, 0xAF81A9C0);
     }
 
+    if (fastmem) memcpy(hostMemory->view(RAM_SIZE_8MB), bios.data(), BIOS_SIZE);
+
     return true;
 }
 
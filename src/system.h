@@ -1,5 +1,6 @@
 #pragma once
 #include <cstdint>
+#include "config.h"
 #include "cpu/cpu.h"
 #include "device/cache_control.h"
 #include "device/cdrom/cdrom.h"
@@ -14,6 +15,8 @@
 #include "device/serial.h"
 #include "device/spu/spu.h"
 #include "device/timer.h"
+#include "scheduler.h"
+#include "utils/host_memory.h"
 #include "utils/macros.h"
 #include "utils/timing.h"
 
@@ -65,17 +68,49 @@ struct System {
     static const int SCRATCHPAD_SIZE = 1024;
     static const int EXPANSION_SIZE = 1 * 1024 * 1024;
     static const int IO_SIZE = 0x2000;
+
+    // Memory map granularity, pages cover 512MB physical address space (KUSEG, KSEG0 and KSEG1 are mirrors of it)
+    static const int PAGE_BITS = 12;
+    static const uint32_t PAGE_SIZE = 1 << PAGE_BITS;
+    static const uint32_t PAGE_COUNT = 0x2000'0000 >> PAGE_BITS;
     State state = State::stop;
 
+    // Per instance context, devices never use the global config and bus directly so that systems can run on separate threads.
+    // Both have to outlive the System.
+    const avocado_config_t& config;
+    Dexode::EventBus& bus;
+
+    // Shared memory backing RAM when fastmem is enabled, has to outlive ram
+    std::unique_ptr<HostMemory> hostMemory;
+
     std::array<uint8_t, BIOS_SIZE> bios;
-    std::vector<uint8_t> ram;
+    std::vector<uint8_t, HostAllocator<uint8_t>> ram;
     std::array<uint8_t, SCRATCHPAD_SIZE> scratchpad;
     std::array<uint8_t, EXPANSION_SIZE> expansion;
 
+    // Host pointers for directly accessible pages, nullptr falls back to I/O handling
+    std::vector<uint8_t*> readPages;
+    std::vector<uint8_t*> writePages;
+    std::vector<uint8_t*> isolatedWritePages;  // Empty table used when cache is isolated
+    uint8_t** activeWritePages = nullptr;
+
+    // Host address of physical address 0 with RAM and BIOS mirrored at their guest addresses, nullptr if fastmem is disabled
+    uint8_t* fastmem = nullptr;
+
     bool debugOutput = true;  // Print BIOS logs
     bool biosLoaded = false;
 
-    uint64_t cycles;
+    uint64_t cycles = 0;  // Executed instructions
+    Scheduler scheduler{this};
+    uint32_t spuPhase = 0;  // Fraction of SPU sample period carried to the next one, in 1/1000 cycle
+
+    // Host time spent in parts of the emulation in nanoseconds, collected only when enabled (headless benchmark)
+    struct HostTime {
+        bool enabled = false;
+        uint64_t cpu = 0;  // Including memory and I/O accesses, excluding GPU commands
+        uint64_t gpu = 0;  // GP0 commands, whether written by CPU or DMA
+        std::array<uint64_t, Scheduler::EVENT_COUNT> events = {};  // Excluding GPU commands
+    } hostTime;
 
     // Devices
     std::unique_ptr<mips::CPU> cpu;
@@ -102,7 +137,7 @@ struct System {
     void handleBiosFunction();
     void handleSyscallFunction();
 
-    System();
+    System(const avocado_config_t& config = ::config, Dexode::EventBus& bus = ::bus);
     uint8_t readMemory8(uint32_t address);
     uint16_t readMemory16(uint32_t address);
     uint32_t readMemory32(uint32_t address);
@@ -110,7 +145,15 @@ struct System {
     void writeMemory16(uint32_t address, uint16_t data);
     void writeMemory32(uint32_t address, uint32_t data);
     void printFunctionInfo(const char* functionNum, const bios::Function& f);
+    void mapMemory();
+    // RAM pages containing cached code are not writable directly, so writes invalidate the code
+    void setRamPageWritable(uint32_t ramPage, bool writable);
+    void updateCacheIsolation();
     void emulateFrame();
+    // Handles all events which are due, returns true if the frame ended
+    bool runEvents();
+    bool handleEvent(Scheduler::Event event, uint64_t timestamp);
+    void scheduleSpu(uint64_t timestamp);
     void softReset();
     bool isSystemReady();
 
@@ -153,5 +196,9 @@ struct System {
 
         ar(ram);
         ar(scratchpad);
+
+        ar(cycles);
+        ar(scheduler);
+        ar(spuPhase);
     }
 };
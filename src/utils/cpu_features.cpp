@@ -0,0 +1,37 @@
+#include "cpu_features.h"
+#ifdef _MSC_VER
+#include <immintrin.h>
+#include <intrin.h>
+#endif
+
+namespace cpu_features {
+namespace {
+bool detectAvx2() {
+#if !defined(CPU_FEATURES_X64)
+    return false;
+#elif defined(_MSC_VER)
+    int info[4];
+    __cpuid(info, 0);
+    if (info[0] < 7) return false;
+
+    __cpuid(info, 1);
+    const bool osxsave = info[2] & (1 << 27);
+    const bool avx = info[2] & (1 << 28);
+    if (!osxsave || !avx) return false;
+    if ((_xgetbv(0) & 6) != 6) return false;  // XMM and YMM state
+
+    __cpuidex(info, 7, 0);
+    return info[1] & (1 << 5);
+#else
+    // Also checks that the OS saves YMM registers
+    __builtin_cpu_init();
+    return __builtin_cpu_supports("avx2");
+#endif
+}
+}  // namespace
+
+bool hasAvx2() {
+    static const bool supported = detectAvx2();
+    return supported;
+}
+}  // namespace cpu_features
@@ -0,0 +1,12 @@
+#pragma once
+
+// x86-64 builds only assume SSE2, code for newer extensions is compiled per function and selected at runtime
+// TODO: Rasterizers have SSE2 (baseline) and AVX2 variants only, SSE4.1 and AVX-512 tiers are not implemented
+#if defined(__x86_64__) || defined(_M_X64)
+#define CPU_FEATURES_X64
+#endif
+
+namespace cpu_features {
+// CPU and OS support AVX2 (YMM state saved on context switch)
+bool hasAvx2();
+}  // namespace cpu_features
@@ -2,4 +2,6 @@
 
 Dexode::EventBus bus;
 
-void toast(const std::string& message) { bus.notify(Event::Gui::Toast{message}); }
\ No newline at end of file
+void toast(const std::string& message) { toast(bus, message); }
+
+void toast(Dexode::EventBus& bus, const std::string& message) { bus.notify(Event::Gui::Toast{message}); }
\ No newline at end of file
@@ -63,4 +63,5 @@ struct MemoryCardSwapped {
 }  // namespace Controller
 };  // namespace Event
 
-void toast(const std::string& message);
\ No newline at end of file
+void toast(const std::string& message);
+void toast(Dexode::EventBus& bus, const std::string& message);
\ No newline at end of file
@@ -2,9 +2,6 @@
 #include <cstdio>
 
 namespace GpuDrawList {
-int framesToCapture = 0;
-int currentFrame = 0;
-
 bool load(System *sys, const std::string &path) {
     FILE *f = fopen(path.c_str(), "rb");
     if (!f) {
@@ -26,18 +23,16 @@ bool load(System *sys, const std::string &path) {
     for (int i = 0; i < initialSetupCount; i++) r32();
 
     const uint32_t commandCount = r32();
+    std::vector<uint32_t> args;
     for (int i = 0; i < commandCount; i++) {
-        gpu::LogEntry entry;
         uint32_t header = r32();
         uint8_t type = (header >> 24) & 0xff;
-        uint8_t count = header & 0xffffff;
+        uint32_t count = header & 0xffffff;
 
-        entry.type = type;
-        for (int j = 0; j < count; j++) {
-            entry.args.push_back(r32());
-        }
+        args.resize(count);
+        for (auto &arg : args) arg = r32();
 
-        log.push_back(entry);
+        log.push(type, args.data(), args.size());
     }
 
     fclose(f);
@@ -58,7 +53,8 @@ bool save(System *sys, const std::string &path) {
 
     auto &log = sys->gpu->gpuLogList;
     w32(log.size());
-    for (auto &entry : log) {
+    for (size_t i = 0; i < log.size(); i++) {
+        auto entry = log[i];
         w32((entry.type << 24) | entry.args.size());
 
         for (auto arg : entry.args) w32(arg);
@@ -69,8 +65,11 @@ bool save(System *sys, const std::string &path) {
 }
 
 void replayCommands(gpu::GPU *gpu, int to) {
+    gpu->flushRendering();
     gpu->vram = gpu->prevVram;
+    gpu->invalidateTextureCache();
 
+    const bool logEnabled = gpu->gpuLogEnabled;
     gpu->gpuLogEnabled = false;
     if (to == -1) to = gpu->gpuLogList.size() - 1;
     for (int i = 0; i <= to; i++) {
@@ -86,14 +85,16 @@ void replayCommands(gpu::GPU *gpu, int to) {
             gpu->write(addr, arg);
         }
     }
-    gpu->gpuLogEnabled = true;
+    gpu->flushRendering();
+    gpu->gpuLogEnabled = logEnabled;
 }
 
 void dumpInitialState(gpu::GPU *gpu) {
+    gpu->flushRendering();
     gpu->prevVram = gpu->vram;
 
-    auto gp0 = [&](uint8_t cmd, uint32_t data) { gpu->gpuLogList.push_back(gpu::LogEntry::GP0(cmd, data)); };
-    auto gp1 = [&](uint8_t cmd, uint32_t data) { gpu->gpuLogList.push_back(gpu::LogEntry::GP1(cmd, data)); };
+    auto gp0 = [&](uint8_t cmd, uint32_t data) { gpu->gpuLogList.gp0(cmd, data); };
+    auto gp1 = [&](uint8_t cmd, uint32_t data) { gpu->gpuLogList.gp1(cmd, data); };
     gp0(0xe1, gpu->gp0_e1._reg);
     gp0(0xe2, gpu->gp0_e2._reg);
     gp0(0xe3, ((gpu->drawingArea.top << 10) & 0xffc00) | (gpu->drawingArea.left & 0x3ff));
@@ -0,0 +1,100 @@
+#include "host_memory.h"
+#include <fmt/core.h>
+#include "macros.h"
+
+#ifdef __linux__
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
+bool HostMemory::isSupported() {
+#ifdef __linux__
+    return true;
+#else
+    return false;
+#endif
+}
+
+#ifdef __linux__
+std::unique_ptr<HostMemory> HostMemory::create(size_t addressSpaceSize, size_t backingSize) {
+    std::unique_ptr<HostMemory> memory(new HostMemory());
+
+    memory->fd = memfd_create("avocado", 0);
+    if (memory->fd == -1 || ftruncate(memory->fd, backingSize) != 0) {
+        fmt::print("[HOST] Unable to create shared memory\n");
+        return nullptr;
+    }
+
+    void* range = mmap(nullptr, addressSpaceSize, PROT_NONE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+    if (range == MAP_FAILED) {
+        fmt::print("[HOST] Unable to reserve {} MB of address space\n", addressSpaceSize / 1024 / 1024);
+        return nullptr;
+    }
+    memory->addressSpace = static_cast<uint8_t*>(range);
+    memory->addressSpaceLength = addressSpaceSize;
+
+    void* view = mmap(nullptr, backingSize, PROT_READ | PROT_WRITE, MAP_SHARED, memory->fd, 0);
+    if (view == MAP_FAILED) {
+        fmt::print("[HOST] Unable to map shared memory\n");
+        return nullptr;
+    }
+    memory->backing = static_cast<uint8_t*>(view);
+    memory->backingLength = backingSize;
+
+    return memory;
+}
+
+HostMemory::~HostMemory() {
+    if (backing != nullptr) munmap(backing, backingLength);
+    if (addressSpace != nullptr) munmap(addressSpace, addressSpaceLength);
+    if (fd != -1) close(fd);
+}
+
+void HostMemory::reset() {
+    mmap(addressSpace, addressSpaceLength, PROT_NONE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE | MAP_FIXED, -1, 0);
+}
+
+bool HostMemory::map(size_t address, size_t offset, size_t size, bool writable) {
+    int prot = PROT_READ | (writable ? PROT_WRITE : 0);
+    return mmap(addressSpace + address, size, prot, MAP_SHARED | MAP_FIXED, fd, offset) != MAP_FAILED;
+}
+
+void HostMemory::protect(size_t address, size_t size, bool writable) {
+    mprotect(addressSpace + address, size, PROT_READ | (writable ? PROT_WRITE : 0));
+}
+#else
+std::unique_ptr<HostMemory> HostMemory::create(size_t addressSpaceSize, size_t backingSize) {
+    UNUSED(addressSpaceSize);
+    UNUSED(backingSize);
+    return nullptr;
+}
+
+HostMemory::~HostMemory() {}
+
+void HostMemory::reset() {}
+
+bool HostMemory::map(size_t address, size_t offset, size_t size, bool writable) {
+    UNUSED(address);
+    UNUSED(offset);
+    UNUSED(size);
+    UNUSED(writable);
+    return false;
+}
+
+void HostMemory::protect(size_t address, size_t size, bool writable) {
+    UNUSED(address);
+    UNUSED(size);
+    UNUSED(writable);
+}
+#endif
+
+bool HostMemory::contains(const void* ptr) const {
+    auto p = static_cast<const uint8_t*>(ptr);
+    return p >= addressSpace && p < addressSpace + addressSpaceLength;
+}
+
+bool HostMemory::claim() {
+    if (claimed) return false;
+    claimed = true;
+    return true;
+}
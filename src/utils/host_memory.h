@@ -0,0 +1,85 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <type_traits>
+
+/**
+ * Reserved host address range with shared memory mapped into it, possibly at multiple places.
+ * Used to mirror guest memory, so generated code can access it with a single host instruction.
+ * Access to the parts of the range which aren't mapped (or are protected) raises SIGSEGV.
+ *
+ * Only Linux (memfd) is supported for now.
+ */
+class HostMemory {
+   public:
+    static bool isSupported();
+    // Returns nullptr if the address range or backing memory can't be allocated
+    static std::unique_ptr<HostMemory> create(size_t addressSpaceSize, size_t backingSize);
+    ~HostMemory();
+
+    uint8_t* base() const { return addressSpace; }
+    size_t backingSize() const { return backingLength; }
+    // Backing memory outside of the reserved range, always readable and writable
+    uint8_t* view(size_t offset) const { return backing + offset; }
+    bool contains(const void* ptr) const;
+
+    // Unmaps everything from the reserved range
+    void reset();
+    // Maps backing memory [offset, offset + size) at base() + address, all values must be page aligned
+    bool map(size_t address, size_t offset, size_t size, bool writable);
+    void protect(size_t address, size_t size, bool writable);
+
+    // Backing memory can be claimed by a single container through HostAllocator
+    bool claim();
+    void release() { claimed = false; }
+
+   private:
+    int fd = -1;
+    uint8_t* addressSpace = nullptr;
+    size_t addressSpaceLength = 0;
+    uint8_t* backing = nullptr;
+    size_t backingLength = 0;
+    bool claimed = false;
+
+    HostMemory() = default;
+};
+
+// Allocator placing container storage at the start of HostMemory backing memory, falls back to the heap
+template <typename T>
+struct HostAllocator {
+    using value_type = T;
+    using propagate_on_container_move_assignment = std::true_type;
+
+    HostMemory* memory = nullptr;
+
+    HostAllocator() = default;
+    explicit HostAllocator(HostMemory* memory) : memory(memory) {}
+    template <typename U>
+    HostAllocator(const HostAllocator<U>& other) : memory(other.memory) {}
+
+    T* allocate(size_t n) {
+        if (memory != nullptr && n * sizeof(T) <= memory->backingSize() && memory->claim()) {
+            return reinterpret_cast<T*>(memory->view(0));
+        }
+        return std::allocator<T>().allocate(n);
+    }
+
+    void deallocate(T* ptr, size_t n) {
+        if (memory != nullptr && reinterpret_cast<uint8_t*>(ptr) == memory->view(0)) {
+            memory->release();
+            return;
+        }
+        std::allocator<T>().deallocate(ptr, n);
+    }
+};
+
+template <typename T, typename U>
+bool operator==(const HostAllocator<T>& a, const HostAllocator<U>& b) {
+    return a.memory == b.memory;
+}
+
+template <typename T, typename U>
+bool operator!=(const HostAllocator<T>& a, const HostAllocator<U>& b) {
+    return a.memory != b.memory;
+}
@@ -1,3 +1,4 @@
+#include "config.h"
 #include "cpu/gte/gte.h"
 #include "log_file.h"
 #include "utils/file.h"
@@ -68,7 +69,7 @@ int main(int argc, char** argv) {
     auto testCases = parseTestCases(logfile);
     printf("Test cases found: %zd\n", testCases.size());
 
-    GTE gte;
+    GTE gte(bus, config);
 
     int testsFailed = 0;
     int testsSuccessful = 0;
@@ -0,0 +1,86 @@
+#include "bench.h"
+#include <fmt/core.h>
+#include <algorithm>
+#include "utils/timing.h"
+
+namespace bench {
+
+namespace {
+volatile uint64_t sink;
+
+// 12345678 -> "12.35M"
+std::string si(double value) {
+    const char* suffixes[] = {"", "k", "M", "G", "T"};
+    int i = 0;
+    while (value >= 1000.0 && i < 4) {
+        value /= 1000.0;
+        i++;
+    }
+    return fmt::format("{:.2f}{}", value, suffixes[i]);
+}
+}  // namespace
+
+void keep(uint64_t value) { sink = sink + value; }
+
+void Suite::add(const std::string& name, const std::string& unit, Function function) { benchmarks.push_back({name, unit, function}); }
+
+std::vector<std::string> Suite::names() const {
+    std::vector<std::string> names;
+    for (const auto& b : benchmarks) names.push_back(b.name);
+    return names;
+}
+
+std::vector<Result> Suite::run(const std::string& filter, double minTime, int repetitions) const {
+    const uint64_t minNs = static_cast<uint64_t>(minTime * 1e9);
+
+    struct Sample {
+        uint64_t ns;
+        uint64_t items;
+    };
+    auto measure = [](const Benchmark& b, uint64_t iterations) {
+        uint64_t start = timing::hostNanoseconds();
+        uint64_t items = b.function(iterations);
+        return Sample{std::max<uint64_t>(timing::hostNanoseconds() - start, 1), items};
+    };
+
+    std::vector<Result> results;
+    for (const auto& b : benchmarks) {
+        if (b.name.find(filter) == std::string::npos) continue;
+
+        // Grow iteration count until the run is long enough to extrapolate from, warms up caches as well
+        uint64_t iterations = 1;
+        Sample sample = measure(b, iterations);
+        while (sample.ns < minNs / 10 && iterations < (1ull << 40)) {
+            iterations *= 10;
+            sample = measure(b, iterations);
+        }
+        iterations = std::max<uint64_t>(1, iterations * minNs / sample.ns);
+
+        std::vector<Sample> samples;
+        for (int i = 0; i < repetitions; i++) {
+            samples.push_back(measure(b, iterations));
+        }
+        std::sort(samples.begin(), samples.end(), [](const Sample& a, const Sample& b) { return a.ns < b.ns; });
+        const Sample& median = samples[samples.size() / 2];
+
+        Result result{b.name, b.unit, iterations, (double)median.ns / iterations, median.items * 1e9 / median.ns};
+        fmt::print("{:<52} {:>12} {:>12.1f} ns/op {:>10} {}/s\n", result.name, result.iterations, result.nsPerOp,
+                   si(result.itemsPerSecond), result.unit);
+        results.push_back(result);
+    }
+    return results;
+}
+
+std::string toJson(const std::vector<Result>& results) {
+    std::string json = "[\n";
+    for (size_t i = 0; i < results.size(); i++) {
+        const auto& r = results[i];
+        json += fmt::format(R"(  {{"name": "{}", "unit": "{}", "iterations": {}, "ns_per_op": {:.3f}, "items_per_second": {:.1f}}})", r.name,
+                            r.unit, r.iterations, r.nsPerOp, r.itemsPerSecond);
+        json += i + 1 < results.size() ? ",\n" : "\n";
+    }
+    json += "]\n";
+    return json;
+}
+
+}  // namespace bench
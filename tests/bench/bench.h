@@ -0,0 +1,53 @@
+#pragma once
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <vector>
+
+namespace bench {
+
+// Runs given number of iterations, returns number of items (pixels, samples, ...) processed by them
+using Function = std::function<uint64_t(uint64_t iterations)>;
+
+struct Result {
+    std::string name;
+    std::string unit;
+    uint64_t iterations;  // Per repetition
+    double nsPerOp;       // Median of repetitions
+    double itemsPerSecond;
+};
+
+/**
+ * Minimal micro-benchmark runner.
+ *
+ * Iteration count is calibrated so that a single repetition takes at least minTime seconds,
+ * reported values are medians of all repetitions. Inputs are generated from fixed seeds
+ * so that the results are comparable between runs and commits.
+ */
+class Suite {
+   public:
+    void add(const std::string& name, const std::string& unit, Function function);
+    std::vector<std::string> names() const;
+    std::vector<Result> run(const std::string& filter, double minTime, int repetitions) const;
+
+   private:
+    struct Benchmark {
+        std::string name;
+        std::string unit;
+        Function function;
+    };
+
+    std::vector<Benchmark> benchmarks;
+};
+
+// Keeps value alive so that the compiler cannot remove the code computing it
+void keep(uint64_t value);
+
+std::string toJson(const std::vector<Result>& results);
+
+void registerGpu(Suite& suite);
+void registerMdec(Suite& suite);
+void registerMemory(Suite& suite);
+void registerSound(Suite& suite);
+
+}  // namespace bench
@@ -0,0 +1,258 @@
+#include <fmt/core.h>
+#include <algorithm>
+#include <memory>
+#include <random>
+#include <vector>
+#include "bench.h"
+#include "device/gpu/render/render.h"
+#include "system.h"
+
+namespace bench {
+
+namespace {
+const int PRIMITIVES = 256;  // Drawn in a loop, different sizes and positions average out
+
+std::shared_ptr<System> createSystem() {
+    auto sys = std::make_shared<System>();
+    auto gpu = sys->gpu.get();
+    gpu->drawingArea = {0, 0, gpu::VRAM_WIDTH - 1, gpu::VRAM_HEIGHT - 1};
+
+    // Random contents serve as textures and palettes, with no transparent (0x0000) texels
+    std::mt19937 random(1);
+    for (auto& pixel : gpu->vram) pixel = (random() & 0x7fff) | 1;
+    return sys;
+}
+
+ivec2 randomPosition(std::mt19937& random, int margin) {
+    return ivec2(random() % (gpu::VRAM_WIDTH - margin), random() % (gpu::VRAM_HEIGHT - margin));
+}
+
+RGB randomColor(std::mt19937& random) { return RGB(random() & 0xff, random() & 0xff, random() & 0xff); }
+
+struct TriangleVariant {
+    const char* name;
+    int bits;
+    bool gouraudShading;
+    bool isSemiTransparent;
+    bool isRawTexture;
+    bool dithering;
+    bool checkMask;
+    bool sliver;  // Long and thin, mostly empty bounding box
+};
+
+// Covers every dimension of rasterizeTriangle dispatch table
+const TriangleVariant triangleVariants[] = {
+    {"flat", 0, false, false, false, false, false, false},
+    {"gouraud", 0, true, false, false, false, false, false},
+    {"gouraud dithered", 0, true, false, false, true, false, false},
+    {"flat semi-transparent", 0, false, true, false, false, false, false},
+    {"flat mask check", 0, false, false, false, false, true, false},
+    {"textured 4bit", 4, false, false, false, false, false, false},
+    {"textured 4bit raw", 4, false, false, true, false, false, false},
+    {"textured 8bit", 8, false, false, false, false, false, false},
+    {"textured 15bit", 16, false, false, false, false, false, false},
+    {"textured 4bit gouraud semi-transparent", 4, true, true, false, false, false, false},
+    {"gouraud sliver", 0, true, false, false, false, false, true},
+};
+
+// Reference variants measure the scalar rasterizer kept next to the SIMD one
+void addTriangles(Suite& suite, std::shared_ptr<System> sys, const TriangleVariant& variant, bool reference) {
+    std::mt19937 random(2);
+    std::vector<primitive::Triangle> triangles(PRIMITIVES);
+    std::vector<uint64_t> pixels(PRIMITIVES);
+    for (int i = 0; i < PRIMITIVES; i++) {
+        auto& t = triangles[i];
+        ivec2 origin = randomPosition(random, variant.sliver ? 256 : 64);
+        for (auto& v : t.v) {
+            v.pos = origin + ivec2(random() % 64, random() % 64);
+            v.color = randomColor(random);
+            v.uv = ivec2(random() % 256, random() % 256);
+        }
+        if (variant.sliver) {
+            t.v[1].pos = t.v[0].pos + ivec2(192, 192);
+            t.v[2].pos = t.v[0].pos + ivec2(200 + random() % 16, 184 + random() % 16);
+        }
+        t.bits = variant.bits;
+        t.gouraudShading = variant.gouraudShading;
+        t.isSemiTransparent = variant.isSemiTransparent;
+        t.transparency = gpu::SemiTransparency::Bby2plusFby2;
+        t.isRawTexture = variant.isRawTexture;
+        t.texpage = ivec2(512, 0);
+        t.clut = ivec2(0, 480);
+        t.assureCcw();
+
+        ivec2 ab = t.v[1].pos - t.v[0].pos;
+        ivec2 ac = t.v[2].pos - t.v[0].pos;
+        pixels[i] = std::abs(ab.x * ac.y - ab.y * ac.x) / 2;
+    }
+
+    const char* group = reference ? "triangle-reference" : "triangle";
+    suite.add(fmt::format("gpu/{}/{}", group, variant.name), "px", [=](uint64_t iterations) {
+        auto gpu = sys->gpu.get();
+        gpu->gp0_e1.dither24to15 = variant.dithering;
+        gpu->gp0_e6.checkMaskBeforeDraw = variant.checkMask;
+
+        auto ctx = gpu->renderContext();
+        uint64_t items = 0;
+        for (uint64_t i = 0; i < iterations; i++) {
+            if (reference) {
+                Render::drawTriangleReference(&ctx, triangles[i % PRIMITIVES]);
+            } else {
+                Render::drawTriangle(&ctx, triangles[i % PRIMITIVES]);
+            }
+            items += pixels[i % PRIMITIVES];
+        }
+        gpu->gp0_e1.dither24to15 = false;
+        gpu->gp0_e6.checkMaskBeforeDraw = false;
+        return items;
+    });
+}
+
+void addRectangles(Suite& suite, std::shared_ptr<System> sys, const char* name, int size, int bits, bool isSemiTransparent) {
+    std::mt19937 random(3);
+    std::vector<primitive::Rect> rects(PRIMITIVES);
+    for (auto& r : rects) {
+        r.pos = randomPosition(random, size);
+        r.size = ivec2(size, size);
+        r.color = randomColor(random);
+        r.bits = bits;
+        r.isSemiTransparent = isSemiTransparent;
+        r.isRawTexture = false;
+        r.uv = ivec2(random() % (256 - size), random() % (256 - size));
+        r.texpage = ivec2(512, 0);
+        r.clut = ivec2(0, 480);
+    }
+
+    suite.add(fmt::format("gpu/rectangle/{}", name), "px", [=](uint64_t iterations) {
+        for (uint64_t i = 0; i < iterations; i++) {
+            Render::drawRectangle(sys->gpu.get(), rects[i % PRIMITIVES]);
+        }
+        return iterations * size * size;
+    });
+}
+
+void addLines(Suite& suite, std::shared_ptr<System> sys, const char* name, bool gouraudShading, bool isSemiTransparent) {
+    std::mt19937 random(4);
+    std::vector<primitive::Line> lines(PRIMITIVES);
+    std::vector<uint64_t> pixels(PRIMITIVES);
+    for (int i = 0; i < PRIMITIVES; i++) {
+        auto& l = lines[i];
+        l.pos[0] = randomPosition(random, 128);
+        l.pos[1] = l.pos[0] + ivec2(random() % 128, random() % 128);
+        l.color[0] = randomColor(random);
+        l.color[1] = randomColor(random);
+        l.gouraudShading = gouraudShading;
+        l.isSemiTransparent = isSemiTransparent;
+
+        ivec2 d = l.pos[1] - l.pos[0];
+        pixels[i] = std::max(d.x, d.y) + 1;
+    }
+
+    suite.add(fmt::format("gpu/line/{}", name), "px", [=](uint64_t iterations) {
+        uint64_t items = 0;
+        for (uint64_t i = 0; i < iterations; i++) {
+            Render::drawLine(sys->gpu.get(), lines[i % PRIMITIVES]);
+            items += pixels[i % PRIMITIVES];
+        }
+        return items;
+    });
+}
+
+// Full screen clear and framebuffer blit sized commands sent through GP0
+void addFill(Suite& suite, std::shared_ptr<System> sys, int w, int h) {
+    suite.add(fmt::format("gpu/fill {}x{}", w, h), "px", [=](uint64_t iterations) {
+        auto gpu = sys->gpu.get();
+        for (uint64_t i = 0; i < iterations; i++) {
+            gpu->write(0, 0x02000000 | (i & 0xffffff));  // Fill rectangle
+            gpu->write(0, static_cast<uint32_t>(i % 2 * 512));
+            gpu->write(0, w | h << 16);
+        }
+        return iterations * w * h;
+    });
+}
+
+void addVramCopy(Suite& suite, std::shared_ptr<System> sys, int w, int h) {
+    suite.add(fmt::format("gpu/vram copy {}x{}", w, h), "px", [=](uint64_t iterations) {
+        auto gpu = sys->gpu.get();
+        for (uint64_t i = 0; i < iterations; i++) {
+            gpu->write(0, 0x80000000);  // Copy rectangle (VRAM to VRAM)
+            gpu->write(0, static_cast<uint32_t>(i % 2 * 512));
+            gpu->write(0, static_cast<uint32_t>((i + 1) % 2 * 512));
+            gpu->write(0, w | h << 16);
+        }
+        return iterations * w * h;
+    });
+}
+
+// Same data sent either word by word or in one block, like DMA does
+void addCpuToVram(Suite& suite, std::shared_ptr<System> sys, int w, int h, bool block) {
+    std::vector<uint32_t> words = {0xa0000000, 0, static_cast<uint32_t>(w | h << 16)};  // Copy rectangle (CPU to VRAM)
+    std::mt19937 random(1);
+    for (int i = 0; i < w * h / 2; i++) words.push_back(random() & 0x7fff7fff);
+
+    suite.add(fmt::format("gpu/cpu to vram {}x{} {}", w, h, block ? "block" : "words"), "px", [=](uint64_t iterations) {
+        auto gpu = sys->gpu.get();
+        for (uint64_t i = 0; i < iterations; i++) {
+            if (block) {
+                gpu->writeGP0Block(words.data(), words.size());
+            } else {
+                for (auto word : words) gpu->write(0, word);
+            }
+        }
+        return iterations * w * h;
+    });
+}
+
+// Ordering table of dot packets walked by GPU DMA, nodes are scattered like ones allocated by games
+void addLinkedList(Suite& suite, std::shared_ptr<System> sys, int nodes) {
+    std::mt19937 random(3);
+    std::vector<uint32_t> addresses(nodes);
+    for (int i = 0; i < nodes; i++) addresses[i] = 0x10000 + i * 16;
+    std::shuffle(addresses.begin(), addresses.end(), random);
+
+    for (int i = 0; i < nodes; i++) {
+        uint32_t next = i + 1 < nodes ? addresses[i + 1] : 0xffffff;
+        sys->writeMemory32(addresses[i], 2u << 24 | next);
+        sys->writeMemory32(addresses[i] + 4, 0x68000000 | (random() & 0xffffff));  // Monochrome 1x1 rectangle
+        sys->writeMemory32(addresses[i] + 8, static_cast<uint32_t>(randomPosition(random, 1).x | randomPosition(random, 1).y << 16));
+    }
+
+    suite.add(fmt::format("gpu/dma linked list {} nodes", nodes), "packets", [=](uint64_t iterations) {
+        sys->writeMemory32(0x1f80'10f0, 0x800);  // Enable DMA2
+        for (uint64_t i = 0; i < iterations; i++) {
+            sys->writeMemory32(0x1f80'10a0, addresses[0]);
+            sys->writeMemory32(0x1f80'10a8, 0x0100'0401);  // From RAM, linked list, start
+        }
+        return iterations * nodes;
+    });
+}
+}  // namespace
+
+void registerGpu(Suite& suite) {
+    auto sys = createSystem();
+
+    for (const auto& variant : triangleVariants) {
+        addTriangles(suite, sys, variant, false);
+    }
+    for (const auto& variant : triangleVariants) {
+        addTriangles(suite, sys, variant, true);
+    }
+
+    addRectangles(suite, sys, "flat 16x16", 16, 0, false);
+    addRectangles(suite, sys, "flat 64x64", 64, 0, false);
+    addRectangles(suite, sys, "flat 64x64 semi-transparent", 64, 0, true);
+    addRectangles(suite, sys, "textured 4bit 16x16", 16, 4, false);
+    addRectangles(suite, sys, "textured 15bit 64x64", 64, 16, false);
+
+    addLines(suite, sys, "flat", false, false);
+    addLines(suite, sys, "gouraud", true, false);
+    addLines(suite, sys, "flat semi-transparent", false, true);
+
+    addFill(suite, sys, 320, 240);
+    addVramCopy(suite, sys, 320, 240);
+    addCpuToVram(suite, sys, 320, 240, false);
+    addCpuToVram(suite, sys, 320, 240, true);
+    addLinkedList(suite, sys, 4096);
+}
+
+}  // namespace bench
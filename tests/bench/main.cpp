@@ -0,0 +1,65 @@
+#include <fmt/core.h>
+#include <algorithm>
+#include <string>
+#include "bench.h"
+#include "utils/file.h"
+
+void printHelp() {
+    fmt::print(R"(
+usage: avocado_bench [options]
+  --filter TEXT       run only benchmarks with TEXT in name
+  --min-time SECONDS  minimum duration of single repetition (default 0.5)
+  --repetitions N     number of repetitions, median is reported (default 5)
+  --json FILE         save results as JSON
+  --list              list benchmarks
+  --help              print help
+)");
+}
+
+int main(int argc, char** argv) {
+    std::string filter;
+    std::string jsonPath;
+    double minTime = 0.5;
+    int repetitions = 5;
+    bool list = false;
+
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        bool hasValue = i + 1 < argc;
+        if (arg == "--filter" && hasValue) {
+            filter = argv[++i];
+        } else if (arg == "--min-time" && hasValue) {
+            minTime = std::stod(argv[++i]);
+        } else if (arg == "--repetitions" && hasValue) {
+            repetitions = std::max(1, std::stoi(argv[++i]));
+        } else if (arg == "--json" && hasValue) {
+            jsonPath = argv[++i];
+        } else if (arg == "--list") {
+            list = true;
+        } else {
+            printHelp();
+            return arg == "--help" ? 0 : 1;
+        }
+    }
+
+    bench::Suite suite;
+    bench::registerGpu(suite);
+    bench::registerMdec(suite);
+    bench::registerMemory(suite);
+    bench::registerSound(suite);
+
+    if (list) {
+        for (const auto& name : suite.names()) fmt::print("{}\n", name);
+        return 0;
+    }
+
+    auto results = suite.run(filter, minTime, repetitions);
+
+    if (!jsonPath.empty()) {
+        if (!putFileContents(jsonPath, bench::toJson(results))) {
+            fmt::print("Cannot save results to {}\n", jsonPath);
+            return 1;
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,84 @@
+#include <fmt/core.h>
+#include <cmath>
+#include <memory>
+#include <random>
+#include "bench.h"
+#include "system.h"
+
+namespace bench {
+
+namespace {
+const int MACROBLOCKS = 16;
+const int PIXELS_PER_MACROBLOCK = 16 * 16;
+
+// Uploads quantization and IDCT tables through the data port, same as games do
+std::shared_ptr<System> createSystem() {
+    auto sys = std::make_shared<System>();
+    auto mdec = sys->mdec.get();
+
+    mdec->write(0, 2u << 29 | 1);  // Set quant table (luminance and color)
+    for (int i = 0; i < 128 / 4; i++) {
+        mdec->write(0, 0x10101010);
+    }
+
+    mdec->write(0, 3u << 29);  // Set IDCT table
+    const double pi = std::acos(-1.0);
+    int16_t table[64];
+    for (int y = 0; y < 8; y++) {
+        for (int x = 0; x < 8; x++) {
+            double scale = y == 0 ? std::sqrt(1.0 / 8.0) : std::sqrt(2.0 / 8.0);
+            table[y * 8 + x] = static_cast<int16_t>(std::round(scale * std::cos((2 * x + 1) * y * pi / 16.0) * 0x4000));
+        }
+    }
+    for (int i = 0; i < 64; i += 2) {
+        mdec->write(0, static_cast<uint16_t>(table[i]) | static_cast<uint16_t>(table[i + 1]) << 16);
+    }
+    return sys;
+}
+
+// Run length encoded macroblocks, 6 blocks each (Cr, Cb, Y1-Y4) with given number of AC coefficients
+std::vector<uint32_t> encodeMacroblocks(std::mt19937& random, int coefficients) {
+    std::vector<uint16_t> data;
+    for (int mb = 0; mb < MACROBLOCKS; mb++) {
+        for (int block = 0; block < 6; block++) {
+            data.push_back(8 << 10 | (random() & 0x3ff));  // qFactor, DC
+            for (int i = 0; i < coefficients; i++) {
+                data.push_back(random() & 0x3ff);  // No zeroes skipped
+            }
+            data.push_back(0xfe00);  // End of block
+        }
+    }
+    if (data.size() % 2) data.push_back(0xfe00);
+
+    std::vector<uint32_t> words;
+    for (size_t i = 0; i < data.size(); i += 2) {
+        words.push_back(data[i] | data[i + 1] << 16);
+    }
+    return words;
+}
+
+void addDecode(Suite& suite, std::shared_ptr<System> sys, const char* name, int coefficients) {
+    std::mt19937 random(7);
+    auto words = encodeMacroblocks(random, coefficients);
+
+    suite.add(fmt::format("mdec/decode macroblocks {}", name), "px", [=](uint64_t iterations) {
+        auto mdec = sys->mdec.get();
+        for (uint64_t i = 0; i < iterations; i++) {
+            mdec->write(0, 1u << 29 | 2u << 27 | static_cast<uint32_t>(words.size()));  // Decode macroblock, 24bit
+            for (uint32_t word : words) mdec->write(0, word);
+            keep(mdec->read(0));
+        }
+        return iterations * MACROBLOCKS * PIXELS_PER_MACROBLOCK;
+    });
+}
+}  // namespace
+
+void registerMdec(Suite& suite) {
+    auto sys = createSystem();
+
+    // IDCT dominates sparse blocks, run length decoding the dense ones
+    addDecode(suite, sys, "sparse", 2);
+    addDecode(suite, sys, "dense", 62);
+}
+
+}  // namespace bench
@@ -0,0 +1,42 @@
+#include <fmt/core.h>
+#include <memory>
+#include <random>
+#include "bench.h"
+#include "system.h"
+
+namespace bench {
+
+namespace {
+const int ADDRESSES = 4096;
+
+void addRead(Suite& suite, std::shared_ptr<System> sys, const std::string& name, std::vector<uint32_t> addresses) {
+    suite.add(fmt::format("memory/readMemory32 {}", name), "reads", [=](uint64_t iterations) {
+        uint32_t sum = 0;
+        for (uint64_t i = 0; i < iterations; i++) {
+            sum += sys->readMemory32(addresses[i % addresses.size()]);
+        }
+        keep(sum);
+        return iterations;
+    });
+}
+}  // namespace
+
+void registerMemory(Suite& suite) {
+    auto sys = std::make_shared<System>();
+    std::mt19937 random(8);
+
+    std::vector<uint32_t> ram(ADDRESSES);
+    for (auto& address : ram) address = 0x8000'0000 + (random() % System::RAM_SIZE_2MB & ~3);
+    addRead(suite, sys, "ram", ram);
+
+    std::vector<uint32_t> scratchpad(ADDRESSES);
+    for (auto& address : scratchpad) address = 0x1f80'0000 + (random() % System::SCRATCHPAD_SIZE & ~3);
+    addRead(suite, sys, "scratchpad", scratchpad);
+
+    // Registers polled by games in busy loops
+    addRead(suite, sys, "io interrupt", {0x1f80'1070, 0x1f80'1074});
+    addRead(suite, sys, "io timer", {0x1f80'1100, 0x1f80'1110, 0x1f80'1120});
+    addRead(suite, sys, "io gpustat", {0x1f80'1814});
+}
+
+}  // namespace bench
@@ -0,0 +1,123 @@
+#include <fmt/core.h>
+#include <memory>
+#include <random>
+#include "bench.h"
+#include "device/spu/reverb.h"
+#include "sound/adpcm.h"
+#include "system.h"
+
+namespace bench {
+
+namespace {
+const int BLOCKS = 1024;
+const uint32_t SAMPLES_ADDRESS = 0x1000;
+const int SAMPLES_PER_BLOCK = 28;
+
+// Random ADPCM data with valid shift and filter values
+void fillAdpcm(std::mt19937& random, uint8_t* data, int blocks) {
+    for (int b = 0; b < blocks; b++) {
+        uint8_t* block = data + b * 16;
+        block[0] = (random() % 5) << 4 | (random() % 13);
+        block[1] = 0;
+        for (int i = 2; i < 16; i++) block[i] = random();
+    }
+}
+
+// Reverb "Room" preset
+const uint16_t reverbRoom[32] = {
+    0x007D, 0x005B, 0x6D80, 0x54B8, 0xBED0, 0x0000, 0x0000, 0xBA80,  //
+    0x5800, 0x5300, 0x04D6, 0x0333, 0x03F0, 0x0227, 0x0374, 0x01EF,  //
+    0x0334, 0x01B5, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000,  //
+    0x0000, 0x0000, 0x01B4, 0x0136, 0x00B8, 0x005C, 0x8000, 0x8000,  //
+};
+
+// All 24 voices looping over random samples at different pitches, with reverb enabled
+std::shared_ptr<System> createSystem() {
+    auto sys = std::make_shared<System>();
+    auto spu = sys->spu.get();
+
+    std::mt19937 random(5);
+    fillAdpcm(random, spu->ram.data() + SAMPLES_ADDRESS, BLOCKS);
+    spu->ram[SAMPLES_ADDRESS + 1] = ADPCM::Flag::LoopStart;
+    spu->ram[SAMPLES_ADDRESS + (BLOCKS - 1) * 16 + 1] = ADPCM::Flag::LoopEnd | ADPCM::Flag::Repeat;
+
+    auto write = [&](uint32_t address, uint16_t data) { sys->writeMemory16(spu::SPU::BASE_ADDRESS + address, data); };
+    for (int v = 0; v < spu::SPU::VOICE_COUNT; v++) {
+        uint32_t base = v * 0x10;
+        write(base + 0x0, 0x1000);                         // Volume left
+        write(base + 0x2, 0x1000);                         // Volume right
+        write(base + 0x4, 0x0800 + v * 0x80);              // Pitch
+        write(base + 0x6, SAMPLES_ADDRESS / 8 + v * 2);    // Start address
+        write(base + 0x8, 0x80ff);                         // ADSR
+        write(base + 0xa, 0x1fc0);                         //
+    }
+    write(0x180, 0x3fff);  // Main volume
+    write(0x182, 0x3fff);
+    write(0x184, 0x2000);  // Reverb volume
+    write(0x186, 0x2000);
+    write(0x198, 0xffff);  // Reverb enabled for all voices
+    write(0x19a, 0x00ff);
+    write(0x1a2, 0xe000);  // Reverb work area
+    for (int i = 0; i < 32; i++) write(0x1c0 + i * 2, reverbRoom[i]);
+    write(0x1aa, 0xc080);  // Enabled, unmuted, reverb enabled
+    write(0x188, 0xffff);  // Key on
+    write(0x18a, 0x00ff);
+    return sys;
+}
+}  // namespace
+
+void registerSound(Suite& suite) {
+    auto sys = createSystem();
+
+    auto blocks = std::make_shared<std::vector<uint8_t>>(BLOCKS * 16);
+    std::mt19937 random(6);
+    fillAdpcm(random, blocks->data(), BLOCKS);
+
+    suite.add("sound/adpcm decode", "samples", [=](uint64_t iterations) {
+        int32_t prevSample[2] = {};
+        for (uint64_t i = 0; i < iterations; i++) {
+            auto samples = ADPCM::decode(blocks->data() + (i % BLOCKS) * 16, prevSample);
+            keep(samples[0]);
+        }
+        return iterations * SAMPLES_PER_BLOCK;
+    });
+
+    // Single XA sector, 18 sound groups of 128 bytes
+    auto sector = std::make_shared<std::vector<uint8_t>>(128 * 18);
+    for (int group = 0; group < 18; group++) {
+        uint8_t* g = sector->data() + group * 128;
+        for (int i = 0; i < 16; i++) g[i] = (random() % 4) << 4 | (random() % 13);  // Headers
+        for (int i = 16; i < 128; i++) g[i] = random();
+    }
+    for (auto [name, codinginfo] : {std::make_pair("mono", 0x00), std::make_pair("stereo", 0x01)}) {
+        suite.add(fmt::format("sound/xa decode {} 37800Hz", name), "samples", [=](uint64_t iterations) {
+            ADPCM::XADecoder decoder;
+            uint64_t items = 0;
+            for (uint64_t i = 0; i < iterations; i++) {
+                auto samples = ADPCM::decodeXA(sector->data(), cd::Codinginfo(codinginfo), decoder);
+                items += samples.size();
+            }
+            return items;
+        });
+    }
+
+    suite.add("sound/spu step 24 voices", "samples", [=](uint64_t iterations) {
+        auto spu = sys->spu.get();
+        for (uint64_t i = 0; i < iterations; i++) {
+            spu->step(sys->cdrom.get());
+            spu->bufferReady = false;
+        }
+        return iterations;
+    });
+
+    suite.add("sound/reverb", "samples", [=](uint64_t iterations) {
+        auto spu = sys->spu.get();
+        for (uint64_t i = 0; i < iterations; i++) {
+            auto [left, right] = spu::doReverb(spu, std::make_tuple<int16_t, int16_t>(i * 37, i * 91));
+            keep(left ^ right);
+        }
+        return iterations;
+    });
+}
+
+}  // namespace bench
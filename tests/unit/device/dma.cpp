@@ -0,0 +1,143 @@
+#include <catch2/catch.hpp>
+#include <memory>
+#include <vector>
+#include "system.h"
+
+namespace {
+const uint32_t DMA_BASE = 0x1f801080;
+const uint32_t DPCR = 0x1f8010f0;
+const uint32_t MDEC_DATA = 0x1f801820;
+const uint32_t MDEC_CONTROL = 0x1f801824;
+
+uint32_t channelRegister(int channel, int reg) { return DMA_BASE + channel * 0x10 + reg * 4; }
+
+const uint32_t LIST_END = 0xffffff;
+
+// Linked list node header followed by GP0 words
+void writeNode(System* sys, uint32_t addr, uint32_t next, const std::vector<uint32_t>& words = {}) {
+    sys->writeMemory32(addr, ((uint32_t)words.size() << 24) | next);
+    for (uint32_t word : words) sys->writeMemory32(addr += 4, word);
+}
+
+// White 16x1 fill at given position
+std::vector<uint32_t> fillAt(int x, int y) { return {0x02ffffff, (uint32_t)(y << 16 | x), (1 << 16) | 16}; }
+
+bool filled(System* sys, int x, int y) {
+    sys->gpu->flushRendering();
+    return sys->gpu->vram[y * gpu::VRAM_WIDTH + x] == 0x7fff;
+}
+
+void startLinkedList(System* sys, uint32_t addr) {
+    sys->writeMemory32(DPCR, 0b1000 << 8);
+    sys->writeMemory32(channelRegister(2, 0), addr);
+    sys->writeMemory32(channelRegister(2, 2), 0x01000401);  // From RAM, linked list, start
+}
+
+bool completed(System* sys, int channel) { return (sys->readMemory32(channelRegister(channel, 2)) & (1 << 24)) == 0; }
+
+std::unique_ptr<System> createSystem(avocado_config_t& config, Dexode::EventBus& bus) {
+    auto sys = std::make_unique<System>(config, bus);
+
+    // j 0x80010000; nop - CPU spins while DMA is in progress
+    const uint32_t base = 0x80010000;
+    sys->writeMemory32(base, (2u << 26) | ((base & 0x0fffffff) >> 2));
+    sys->writeMemory32(base + 4, 0);
+    sys->cpu->setPC(base);
+    sys->state = System::State::run;
+    return sys;
+}
+}  // namespace
+
+TEST_CASE("Chopped MDEC-out transfer runs to completion", "[dma]") {
+    avocado_config_t config;
+    Dexode::EventBus bus;
+    auto sys = createSystem(config, bus);
+
+    // Quant tables (luminance and color)
+    sys->writeMemory32(MDEC_DATA, (2u << 29) | 1);
+    for (int i = 0; i < 128 / 4; i++) sys->writeMemory32(MDEC_DATA, 0x01010101);
+
+    // Single 15bit macroblock, every block has only DC coefficient followed by end of block
+    const int BLOCKS = 6;
+    sys->writeMemory32(MDEC_DATA, (1u << 29) | (2u << 27) | BLOCKS);
+    for (int i = 0; i < BLOCKS; i++) sys->writeMemory32(MDEC_DATA, 0xfe00'0400 | (i * 16));
+
+    sys->writeMemory32(MDEC_CONTROL, 1u << 29);  // Enable data out request
+
+    // 16x16 pixels, 2 per word, in 4 blocks of 32 words
+    const uint32_t dst = 0x00100000;
+    const int BLOCK_SIZE = 32;
+    const int BLOCK_COUNT = 4;
+    sys->writeMemory32(DPCR, 0b1000 << 4);
+    sys->writeMemory32(channelRegister(1, 0), dst);
+    sys->writeMemory32(channelRegister(1, 1), (BLOCK_COUNT << 16) | BLOCK_SIZE);
+    sys->writeMemory32(channelRegister(1, 2), 0x01000200);  // To RAM, sync mode 1, start
+
+    sys->emulateFrame();
+
+    REQUIRE((sys->readMemory32(channelRegister(1, 2)) & (1 << 24)) == 0);
+    REQUIRE((sys->readMemory32(channelRegister(1, 0)) & 0xffffff) == dst + BLOCK_SIZE * BLOCK_COUNT * 4);
+    REQUIRE(sys->readMemory32(dst + (BLOCK_SIZE * BLOCK_COUNT - 1) * 4) != 0);
+}
+
+TEST_CASE("Linked list transfer sends every node to GPU", "[dma]") {
+    avocado_config_t config;
+    Dexode::EventBus bus;
+    auto sys = createSystem(config, bus);
+
+    writeNode(sys.get(), 0x1000, 0x1100);
+    writeNode(sys.get(), 0x1100, 0x2000, fillAt(0, 0));
+    writeNode(sys.get(), 0x2000, 0x1200);  // Empty node
+    writeNode(sys.get(), 0x1200, LIST_END, fillAt(16, 0));
+    startLinkedList(sys.get(), 0x1000);
+
+    REQUIRE(completed(sys.get(), 2));
+    REQUIRE((sys->readMemory32(channelRegister(2, 0)) & 0xffffff) == LIST_END);
+    REQUIRE(filled(sys.get(), 0, 0));
+    REQUIRE(filled(sys.get(), 16, 0));
+}
+
+TEST_CASE("Linked list transfer reads nodes crossing the RAM mirror", "[dma]") {
+    avocado_config_t config;
+    Dexode::EventBus bus;
+    auto sys = createSystem(config, bus);
+
+    // Arguments of the last node in RAM are read from 0x200000 (mirror of RAM start), next node is addressed through the mirror
+    writeNode(sys.get(), 0x1ffffc, 0x601000, fillAt(0, 1));
+    writeNode(sys.get(), 0x001000, LIST_END, fillAt(16, 1));
+    REQUIRE(sys->readMemory32(0x000000) == fillAt(0, 1)[0]);
+    startLinkedList(sys.get(), 0x1ffffc);
+
+    REQUIRE(completed(sys.get(), 2));
+    REQUIRE(filled(sys.get(), 0, 1));
+    REQUIRE(filled(sys.get(), 16, 1));
+}
+
+TEST_CASE("Linked list transfer with a cycle terminates", "[dma]") {
+    avocado_config_t config;
+    Dexode::EventBus bus;
+    auto sys = createSystem(config, bus);
+
+    // 0x1000 -> 0x1100 -> 0x1200 -> 0x1300 -> 0x1100 ...
+    writeNode(sys.get(), 0x1000, 0x1100, fillAt(0, 2));
+    writeNode(sys.get(), 0x1100, 0x1200, fillAt(16, 2));
+    writeNode(sys.get(), 0x1200, 0x1300, fillAt(32, 2));
+    writeNode(sys.get(), 0x1300, 0x1100, fillAt(48, 2));
+    startLinkedList(sys.get(), 0x1000);
+
+    REQUIRE(completed(sys.get(), 2));
+    for (int x = 0; x < 64; x += 16) REQUIRE(filled(sys.get(), x, 2));
+
+    // Nodes of the previous transfer are no longer marked as visited, list through all of them in different order reaches its end
+    writeNode(sys.get(), 0x1300, 0x1200, fillAt(0, 3));
+    writeNode(sys.get(), 0x1200, 0x1100, fillAt(16, 3));
+    writeNode(sys.get(), 0x1100, 0x1000, fillAt(32, 3));
+    writeNode(sys.get(), 0x1000, 0x1400, fillAt(48, 3));
+    writeNode(sys.get(), 0x1400, LIST_END, fillAt(64, 3));
+    writeNode(sys.get(), 0x0f00, 0x1300);
+    startLinkedList(sys.get(), 0x0f00);
+
+    REQUIRE(completed(sys.get(), 2));
+    REQUIRE((sys->readMemory32(channelRegister(2, 0)) & 0xffffff) == LIST_END);
+    for (int x = 0; x < 80; x += 16) REQUIRE(filled(sys.get(), x, 3));
+}
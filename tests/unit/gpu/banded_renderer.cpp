@@ -0,0 +1,204 @@
+#include "device/gpu/render/banded_renderer.h"
+#include <catch2/catch.hpp>
+#include <random>
+#include <vector>
+#include "device/gpu/render/render.h"
+#include "device/gpu/render/span.h"
+
+namespace {
+using gpu::VRAM_HEIGHT;
+using gpu::VRAM_WIDTH;
+
+// Single threaded drawing, same as GPU without the banded renderer
+struct Reference {
+    std::vector<uint16_t> vram;
+    gpu::ClutCache clutCache;
+    gpu::TextureCache textureCache;
+    gpu::RenderContext ctx{};
+
+    explicit Reference(const std::vector<uint16_t>& initial) : vram(initial) {
+        ctx.vram = vram.data();
+        ctx.clutCache = &clutCache;
+        ctx.textureCache = &textureCache;
+    }
+
+    void apply(const gpu::RenderContext& state) {
+        ctx.gp0_e1 = state.gp0_e1;
+        ctx.gp0_e2 = state.gp0_e2;
+        ctx.drawingArea = state.drawingArea;
+        ctx.gp0_e6 = state.gp0_e6;
+        ctx.skipField = state.skipField;
+    }
+
+    void fill(int x, int y, int w, int h, uint16_t color) {
+        for (int row = y; row < y + h; row++) {
+            if (ctx.drawsRow(row)) fillSpan(&vram[row * VRAM_WIDTH + x], w, color);
+        }
+        textureCache.markDirty(x, y, w, h);
+    }
+
+    void upload(int x, int y, int w, int h, int offset, const std::vector<uint16_t>& data) {
+        for (size_t i = 0; i < data.size(); i++) {
+            int n = offset + (int)i;
+            uint16_t& pixel = vram[((y + n / w) % VRAM_HEIGHT) * VRAM_WIDTH + (x + n % w) % VRAM_WIDTH];
+            if (ctx.gp0_e6.checkMaskBeforeDraw && (pixel & 0x8000)) continue;
+            pixel = data[i] | (ctx.gp0_e6.setMaskWhileDrawing << 15);
+        }
+        textureCache.markDirty(x, y, w, h);
+    }
+};
+
+/**
+ * Random commands crowded into the top left 512x512 of VRAM, so primitives often sample
+ * texture pages and palettes written by other queued commands (or by themselves).
+ */
+struct Commands {
+    std::mt19937 random;
+
+    explicit Commands(int seed) : random(seed) {}
+
+    int rnd(int min, int max) { return std::uniform_int_distribution<int>(min, max)(random); }
+    ivec2 position() { return ivec2(rnd(-32, 512), rnd(-32, 511)); }
+    RGB color() { return RGB(rnd(0, 255), rnd(0, 255), rnd(0, 255)); }
+    ivec2 texpage() { return ivec2(rnd(0, 7) * 64, rnd(0, 1) * 256); }
+    ivec2 clut() { return ivec2(rnd(0, 3) * 16, rnd(0, 3) * 128); }
+    int bits() {
+        const int bits[] = {0, 4, 8, 16};
+        return bits[rnd(0, 3)];
+    }
+
+    gpu::RenderContext state() {
+        gpu::RenderContext state{};
+        state.gp0_e1._reg = random();
+        state.gp0_e2._reg = rnd(0, 3) == 0 ? random() : 0;
+        state.gp0_e6._reg = rnd(0, 3) == 0 ? random() : 0;
+        state.drawingArea.left = rnd(0, 64);
+        state.drawingArea.top = rnd(0, 64);
+        state.drawingArea.right = rnd(448, 1023);
+        state.drawingArea.bottom = rnd(448, 511);
+        state.skipField = rnd(0, 3) == 0 ? rnd(0, 1) : -1;
+        return state;
+    }
+
+    primitive::Triangle triangle() {
+        primitive::Triangle triangle;
+        const ivec2 center = position();
+        const int size = rnd(0, 3) == 0 ? 200 : 40;
+        for (auto& v : triangle.v) {
+            v.pos = center + ivec2(rnd(-size, size), rnd(-size, size));
+            v.color = color();
+            v.uv = ivec2(rnd(0, 255), rnd(0, 255));
+        }
+        triangle.bits = bits();
+        triangle.transparency = static_cast<gpu::SemiTransparency>(rnd(0, 3));
+        triangle.isSemiTransparent = rnd(0, 1);
+        triangle.isRawTexture = triangle.bits != 0 && rnd(0, 1);
+        triangle.gouraudShading = rnd(0, 1);
+        triangle.texpage = texpage();
+        triangle.clut = clut();
+        triangle.assureCcw();
+        return triangle;
+    }
+
+    primitive::Rect rectangle() {
+        primitive::Rect rect;
+        rect.pos = position();
+        rect.size = ivec2(rnd(0, 100), rnd(0, 100));
+        rect.color = color();
+        rect.bits = bits();
+        rect.isSemiTransparent = rnd(0, 1);
+        rect.isRawTexture = rect.bits != 0 && rnd(0, 1);
+        rect.uv = ivec2(rnd(0, 255), rnd(0, 255));
+        rect.texpage = texpage();
+        rect.clut = clut();
+        return rect;
+    }
+
+    primitive::Line line() {
+        primitive::Line line;
+        for (int i = 0; i < 2; i++) {
+            line.pos[i] = position();
+            line.color[i] = color();
+        }
+        line.isSemiTransparent = rnd(0, 1);
+        line.gouraudShading = rnd(0, 1);
+        return line;
+    }
+};
+
+// Replays the same commands through the banded renderer and the single threaded reference
+void checkBanded(int threads, int seed) {
+    std::mt19937 init(seed);
+    std::vector<uint16_t> initial(VRAM_WIDTH * VRAM_HEIGHT + 1);  // One extra halfword as SIMD gathers read 32bit words
+    for (auto& pixel : initial) pixel = init();
+
+    Reference reference(initial);
+    std::vector<uint16_t> vram = initial;
+    gpu::BandedRenderer banded(vram.data(), threads, reference.clutCache);
+
+    Commands commands(seed);
+    for (int i = 1; i <= 3000; i++) {
+        gpu::RenderContext ctx = commands.state();
+        reference.apply(ctx);
+
+        const int kind = commands.rnd(0, 9);
+        if (kind < 3) {
+            const auto triangle = commands.triangle();
+            banded.drawTriangle(ctx, triangle);
+            Render::drawTriangle(&reference.ctx, triangle);
+        } else if (kind < 5) {
+            const auto rect = commands.rectangle();
+            banded.drawRectangle(ctx, rect);
+            Render::drawRectangle(&reference.ctx, rect);
+        } else if (kind < 6) {
+            const auto line = commands.line();
+            banded.drawLine(ctx, line);
+            Render::drawLine(&reference.ctx, line);
+        } else if (kind < 7) {
+            // Fill is aligned and clipped by the GPU before it gets to the renderer
+            int x = commands.rnd(0, 31) * 16, y = commands.rnd(0, 511);
+            int w = std::min(commands.rnd(1, 8) * 16, VRAM_WIDTH - x), h = std::min(commands.rnd(1, 64), VRAM_HEIGHT - y);
+            uint16_t color = commands.random() & 0x7fff;
+            banded.fill(ctx, x, y, w, h, color);
+            reference.fill(x, y, w, h, color);
+        } else if (kind < 9) {
+            // Often a new palette, transfer wrapping around VRAM edges is sometimes split in two parts
+            const bool isClut = commands.rnd(0, 1);
+            const ivec2 clut = commands.clut();
+            int x = isClut ? clut.x : commands.rnd(0, VRAM_WIDTH - 1), y = isClut ? clut.y : commands.rnd(0, VRAM_HEIGHT - 1);
+            int w = isClut ? 256 : commands.rnd(1, 64), h = isClut ? 1 : commands.rnd(1, 64);
+            std::vector<uint16_t> data(w * h);
+            for (auto& pixel : data) pixel = commands.random();
+
+            int split = commands.rnd(0, 1) ? commands.rnd(0, w * h) : w * h;
+            std::vector<uint16_t> first(data.begin(), data.begin() + split), second(data.begin() + split, data.end());
+            if (!first.empty()) {
+                banded.upload(ctx, x, y, w, h, 0, first);
+                reference.upload(x, y, w, h, 0, first);
+            }
+            if (!second.empty()) {
+                banded.upload(ctx, x, y, w, h, split, second);
+                reference.upload(x, y, w, h, split, second);
+            }
+        } else {
+            // Palette cache is flushed only by GP0(0x01), otherwise stale palette stays in use
+            banded.invalidateClut();
+            reference.clutCache.invalidate();
+        }
+
+        if (i % 500 == 0) {
+            banded.flush();
+            INFO("threads " << threads << ", seed " << seed << ", command " << i);
+            REQUIRE(vram == reference.vram);
+        }
+    }
+}
+}  // namespace
+
+TEST_CASE("Banded renderer draws the same pixels as single threaded renderer", "[gpu]") {
+    for (int threads = 1; threads <= 4; threads++) {
+        for (int seed = 1; seed <= 3; seed++) {
+            checkBanded(threads, seed);
+        }
+    }
+}
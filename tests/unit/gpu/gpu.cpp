@@ -0,0 +1,243 @@
+#include "device/gpu/gpu.h"
+#include <algorithm>
+#include <catch2/catch.hpp>
+#include <memory>
+#include <random>
+#include <vector>
+#include "device/gpu/render/span.h"
+#include "system.h"
+
+namespace {
+using gpu::VRAM_HEIGHT;
+using gpu::VRAM_WIDTH;
+
+struct Gpu {
+    avocado_config_t config;
+    Dexode::EventBus bus;
+    std::unique_ptr<System> sys;
+    gpu::GPU* gpu;
+
+    explicit Gpu(int renderingThreads = 0) {
+        config.options.graphics.renderingThreads = renderingThreads;
+        sys = std::make_unique<System>(config, bus);
+        gpu = sys->gpu.get();
+    }
+
+    void gp0(uint32_t word) { gpu->write(0, word); }
+    void gp0(std::initializer_list<uint32_t> words) {
+        for (uint32_t word : words) gp0(word);
+    }
+
+    void randomizeVram(std::mt19937& random) {
+        for (auto& pixel : gpu->vram) pixel = random();
+    }
+
+    const std::array<uint16_t, VRAM_WIDTH * VRAM_HEIGHT>& vram() {
+        gpu->flushRendering();
+        return gpu->vram;
+    }
+
+    bool vramEquals(const std::vector<uint16_t>& reference) {
+        return std::equal(vram().begin(), vram().end(), reference.begin(), reference.end());
+    }
+};
+
+uint32_t xy(int x, int y) { return (y << 16) | (x & 0xffff); }
+
+// VRAM row sampled by blit.shader with bob deinterlacing for given line of display area
+int bobRow(int displayStartY, int line, int field) { return (displayStartY + line / 2 * 2 + field) % VRAM_HEIGHT; }
+
+// Pixel by pixel VRAM to VRAM copy, rows top to bottom, columns right to left if source is on the left of destination
+void referenceCopy(std::vector<uint16_t>& vram, int srcX, int srcY, int dstX, int dstY, int w, int h, bool setMask, bool checkMask) {
+    for (int y = 0; y < h; y++) {
+        for (int i = 0; i < w; i++) {
+            int x = srcX < dstX ? w - 1 - i : i;
+            uint16_t src = vram[((srcY + y) % VRAM_HEIGHT) * VRAM_WIDTH + (srcX + x) % VRAM_WIDTH];
+            uint16_t& dst = vram[((dstY + y) % VRAM_HEIGHT) * VRAM_WIDTH + (dstX + x) % VRAM_WIDTH];
+            if (checkMask && (dst & 0x8000)) continue;
+            dst = src | (setMask ? 0x8000 : 0);
+        }
+    }
+}
+}  // namespace
+
+TEST_CASE("Filled spans match per pixel fill", "[gpu]") {
+    const uint16_t color = 0x1234;
+    for (int offset = 0; offset < 8; offset++) {
+        for (int n = 0; n <= 80; n++) {
+            std::vector<uint16_t> span(offset + n + 8, 0xffff);
+            fillSpan(span.data() + offset, n, color);
+
+            INFO("offset " << offset << ", width " << n);
+            for (int i = 0; i < (int)span.size(); i++) {
+                bool inside = i >= offset && i < offset + n;
+                REQUIRE(span[i] == (inside ? color : 0xffff));
+            }
+        }
+    }
+}
+
+TEST_CASE("VRAM to VRAM copies match per pixel copy", "[gpu]") {
+    std::mt19937 random(5);
+    const auto rnd = [&](int min, int max) { return std::uniform_int_distribution<int>(min, max)(random); };
+
+    Gpu g;
+    g.randomizeVram(random);
+    std::vector<uint16_t> reference(g.gpu->vram.begin(), g.gpu->vram.end());
+
+    for (int i = 0; i < 2000; i++) {
+        int w = rnd(1, 80);
+        int h = rnd(1, 40);
+        int srcX = rnd(0, VRAM_WIDTH - 1);
+        int srcY = rnd(0, VRAM_HEIGHT - 1);
+        int dstX, dstY;
+        switch (rnd(0, 3)) {
+            case 0:  // Overlapping, destination on the right
+                dstX = (srcX + rnd(0, w)) % VRAM_WIDTH;
+                dstY = (srcY + rnd(-h, h) + VRAM_HEIGHT) % VRAM_HEIGHT;
+                break;
+            case 1:  // Overlapping, destination on the left
+                dstX = (srcX - rnd(0, w) + VRAM_WIDTH) % VRAM_WIDTH;
+                dstY = (srcY + rnd(-h, h) + VRAM_HEIGHT) % VRAM_HEIGHT;
+                break;
+            case 2:  // Wrapping at the VRAM edge
+                dstX = rnd(VRAM_WIDTH - w, VRAM_WIDTH - 1);
+                dstY = rnd(VRAM_HEIGHT - h, VRAM_HEIGHT - 1);
+                break;
+            default:
+                dstX = rnd(0, VRAM_WIDTH - 1);
+                dstY = rnd(0, VRAM_HEIGHT - 1);
+                break;
+        }
+        bool setMask = rnd(0, 3) == 0;
+        bool checkMask = rnd(0, 3) == 0;
+
+        g.gp0(0xe6000000 | (checkMask << 1) | setMask);
+        g.gp0({0x80000000, xy(srcX, srcY), xy(dstX, dstY), xy(w, h)});
+        referenceCopy(reference, srcX, srcY, dstX, dstY, w, h, setMask, checkMask);
+
+        INFO("copy " << srcX << "," << srcY << " -> " << dstX << "," << dstY << " " << w << "x" << h << " set " << setMask << " check "
+                     << checkMask);
+        REQUIRE(g.vramEquals(reference));
+    }
+}
+
+TEST_CASE("Rectangle fills match per pixel fill", "[gpu]") {
+    for (int threads : {0, 2}) {
+        std::mt19937 random(6);
+        const auto rnd = [&](int min, int max) { return std::uniform_int_distribution<int>(min, max)(random); };
+
+        Gpu g(threads);
+        g.randomizeVram(random);
+        std::vector<uint16_t> reference(g.gpu->vram.begin(), g.gpu->vram.end());
+
+        for (int i = 0; i < 500; i++) {
+            int x = rnd(0, VRAM_WIDTH - 1);
+            int y = rnd(0, VRAM_HEIGHT - 1);
+            int w = rnd(0, 100);
+            int h = rnd(0, 40);
+            uint32_t color = random() & 0xffffff;
+
+            // Masking is ignored by fills
+            g.gp0(0xe6000000 | rnd(0, 3));
+            g.gp0({0x02000000 | color, xy(x, y), xy(w, h)});
+
+            // Position is aligned down and width up to 16 pixels, fill is clipped (doesn't wrap)
+            int startX = x & 0x3f0;
+            int endX = std::min(VRAM_WIDTH, startX + (((w & 0x3ff) + 0xf) & ~0xf));
+            int endY = std::min(VRAM_HEIGHT, y + h);
+            uint16_t c = ((color >> 3) & 0x1f) | (((color >> 11) & 0x1f) << 5) | (((color >> 19) & 0x1f) << 10);
+            for (int py = y; py < endY; py++) {
+                for (int px = startX; px < endX; px++) reference[py * VRAM_WIDTH + px] = c;
+            }
+
+            INFO("fill " << x << "," << y << " " << w << "x" << h << ", threads " << threads);
+            REQUIRE(g.vramEquals(reference));
+        }
+    }
+}
+
+TEST_CASE("GP0 block writes match per word writes", "[gpu]") {
+    std::mt19937 random(7);
+    const auto rnd = [&](int min, int max) { return std::uniform_int_distribution<int>(min, max)(random); };
+
+    const auto upload = [&](std::vector<uint32_t>& stream, int x, int y, int w, int h) {
+        stream.insert(stream.end(), {0xa0000000, xy(x, y), xy(w, h)});
+        for (int i = 0; i < (w * h + 1) / 2; i++) stream.push_back(random());
+    };
+
+    std::vector<uint32_t> stream = {0xe1000000 | 0x600, 0xe3000000, 0xe4000000 | (511 << 10) | 1023, 0xe5000000};
+    upload(stream, 1020, 10, 7, 3);  // Odd pixel count, wraps at the right VRAM edge
+    stream.push_back(0xe6000001);
+    upload(stream, 100, 100, 5, 2);
+    stream.push_back(0xe6000002);
+    upload(stream, 1018, 100, 9, 1);
+    stream.push_back(0xe6000000);
+    stream.insert(stream.end(), {0x48ff0000, xy(10, 10), xy(200, 50), xy(30, 150), 0x55555555});
+    stream.insert(stream.end(), {0x5800ff00, xy(300, 10), 0x000000ff, xy(400, 80), 0x00ffffff, xy(320, 200), 0x50005000});
+    stream.insert(stream.end(), {0x200000ff, xy(500, 10), xy(600, 100), xy(520, 180)});
+    stream.insert(stream.end(), {0x60808080, xy(700, 300), xy(50, 40)});
+    upload(stream, 0, 400, 33, 5);
+    stream.insert(stream.end(), {0x02123456, xy(32, 200), xy(48, 20)});
+    // Transfer ends in the middle of a packet, rest of it is sent by the CPU
+    stream.insert(stream.end(), {0x3000ff00, xy(100, 300), 0x00ff0000, xy(200, 300)});
+    const std::vector<uint32_t> rest = {0x000000ff, xy(150, 400), 0x60ffffff, xy(0, 0), xy(4, 4)};
+
+    for (int threads : {0, 2}) {
+        for (int maxChunk : {1, 2, 3, 5, 16, 1024}) {
+            Gpu perWord(threads);
+            Gpu block(threads);
+
+            for (uint32_t word : stream) perWord.gp0(word);
+            for (size_t i = 0; i < stream.size();) {
+                size_t n = std::min<size_t>(rnd(1, maxChunk), stream.size() - i);
+                block.gpu->writeGP0Block(&stream[i], n);
+                i += n;
+            }
+            for (uint32_t word : rest) {
+                perWord.gp0(word);
+                block.gp0(word);
+            }
+
+            INFO("threads " << threads << ", max chunk " << maxChunk);
+            std::vector<uint16_t> reference(perWord.vram().begin(), perWord.vram().end());
+            REQUIRE(block.vramEquals(reference));
+            REQUIRE(block.gpu->read(4) == perWord.gpu->read(4));
+            REQUIRE(block.gpu->read(0) == perWord.gpu->read(0));
+            REQUIRE(block.gpu->gp0_e1._reg == perWord.gpu->gp0_e1._reg);
+            REQUIRE(block.gpu->gp0_e6._reg == perWord.gpu->gp0_e6._reg);
+        }
+    }
+}
+
+TEST_CASE("Bob deinterlacing shows rows drawn during the last frame", "[gpu]") {
+    const uint32_t colors[] = {0x0000ff, 0x00ff00, 0xff0000, 0xffffff};
+    const uint16_t colors15[] = {0x001f, 0x03e0, 0x7c00, 0x7fff};
+
+    for (int threads : {0, 2}) {
+        for (int start : {0, 1, 6, 11}) {
+            Gpu g(threads);
+            g.gpu->write(4, 0x08000000 | (1 << 5) | (1 << 2) | 1);  // 320x480, interlaced
+            g.gpu->write(4, 0x05000000 | (start << 10));
+            g.gp0({0xe3000000, 0xe4000000 | (511 << 10) | 1023});
+
+            for (int frame = 0; frame < 4; frame++) {
+                g.gp0({0x60000000 | colors[frame], xy(0, 0), xy(320, 511)});
+                while (!g.gpu->emulateGpuCycles(1000)) {
+                }
+                const int field = g.gpu->displayedField();
+
+                INFO("threads " << threads << ", display start " << start << ", frame " << frame);
+                const auto& vram = g.vram();
+                int mismatches = 0;
+                for (int line = 0; line < 480; line++) {
+                    int shown = bobRow(start, line, field);
+                    int other = bobRow(start, line, field ^ 1);
+                    if (vram[shown * VRAM_WIDTH + 100] != colors15[frame]) mismatches++;
+                    if (vram[other * VRAM_WIDTH + 100] == colors15[frame]) mismatches++;
+                }
+                REQUIRE(mismatches == 0);
+            }
+        }
+    }
+}
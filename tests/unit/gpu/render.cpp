@@ -0,0 +1,580 @@
+#include "device/gpu/render/render.h"
+#include <algorithm>
+#include <catch2/catch.hpp>
+#include <random>
+#include <vector>
+#include "device/gpu/render/triangle_setup.h"
+
+namespace {
+// VRAM with its own palette cache, one extra halfword as SIMD gathers read 32bit words
+struct Target {
+    std::vector<uint16_t> vram;
+    gpu::ClutCache clutCache;
+    gpu::RenderContext ctx;
+
+    explicit Target(const std::vector<uint16_t>& initial) : vram(initial) {
+        vram.push_back(0);
+        ctx = gpu::RenderContext{};
+        ctx.vram = vram.data();
+        ctx.clutCache = &clutCache;
+    }
+};
+
+primitive::Triangle randomTriangle(std::mt19937& random) {
+    const auto rnd = [&](int min, int max) { return std::uniform_int_distribution<int>(min, max)(random); };
+    const int bits[] = {0, 4, 8, 16};
+
+    primitive::Triangle triangle;
+    const ivec2 center(rnd(-64, 1024 + 64), rnd(-64, 512 + 64));
+    const int size = rnd(0, 3) == 0 ? 256 : 48;
+    for (auto& v : triangle.v) {
+        v.pos = center + ivec2(rnd(-size, size), rnd(-size, size));
+        v.color = RGB(rnd(0, 255), rnd(0, 255), rnd(0, 255));
+        v.uv = ivec2(rnd(0, 255), rnd(0, 255));
+    }
+    triangle.bits = bits[rnd(0, 3)];
+    triangle.transparency = static_cast<gpu::SemiTransparency>(rnd(0, 3));
+    triangle.isSemiTransparent = rnd(0, 1);
+    triangle.isRawTexture = triangle.bits != 0 && rnd(0, 1);
+    triangle.gouraudShading = rnd(0, 1);
+    triangle.texpage = ivec2(rnd(0, 15) * 64, rnd(0, 1) * 256);
+    triangle.clut = ivec2(rnd(0, 63) * 16, rnd(0, 511));
+    triangle.assureCcw();
+    return triangle;
+}
+
+primitive::Rect randomRectangle(std::mt19937& random) {
+    const auto rnd = [&](int min, int max) { return std::uniform_int_distribution<int>(min, max)(random); };
+    const int bits[] = {0, 4, 8, 16};
+
+    primitive::Rect rect;
+    rect.pos = ivec2(rnd(-64, 1024 + 64), rnd(-64, 512 + 64));
+    rect.size = rnd(0, 3) == 0 ? ivec2(rnd(0, 1023), rnd(0, 511)) : ivec2(rnd(0, 40), rnd(0, 40));
+    rect.color = RGB(rnd(0, 255), rnd(0, 255), rnd(0, 255));
+    rect.bits = bits[rnd(0, 3)];
+    rect.isSemiTransparent = rnd(0, 1);
+    rect.isRawTexture = rect.bits != 0 && rnd(0, 1);
+    rect.uv = ivec2(rnd(0, 255), rnd(0, 255));
+    rect.texpage = ivec2(rnd(0, 15) * 64, rnd(0, 1) * 256);
+    rect.clut = ivec2(rnd(0, 63) * 16, rnd(0, 511));
+    return rect;
+}
+
+primitive::Line randomLine(std::mt19937& random) {
+    const auto rnd = [&](int min, int max) { return std::uniform_int_distribution<int>(min, max)(random); };
+
+    primitive::Line line;
+    const ivec2 center(rnd(-64, 1024 + 64), rnd(-64, 512 + 64));
+    const int size = rnd(0, 3) == 0 ? 600 : 30;
+    for (int i = 0; i < 2; i++) {
+        line.pos[i] = center + ivec2(rnd(-size, size), rnd(-size, size));
+        line.color[i] = RGB(rnd(0, 255), rnd(0, 255), rnd(0, 255));
+    }
+    line.isSemiTransparent = rnd(0, 1);
+    line.gouraudShading = rnd(0, 1);
+    return line;
+}
+
+gpu::RenderContext randomState(std::mt19937& random) {
+    const auto rnd = [&](int min, int max) { return std::uniform_int_distribution<int>(min, max)(random); };
+
+    gpu::RenderContext state;
+    state.gp0_e1._reg = random();
+    state.gp0_e2._reg = rnd(0, 3) == 0 ? random() : 0;
+    state.gp0_e6._reg = random();
+    state.drawingArea.left = rnd(0, 256);
+    state.drawingArea.top = rnd(0, 128);
+    state.drawingArea.right = rnd(768, 1024);
+    state.drawingArea.bottom = rnd(384, 512);
+    return state;
+}
+
+void applyState(Target& target, const gpu::RenderContext& state) {
+    target.ctx.gp0_e1 = state.gp0_e1;
+    target.ctx.gp0_e2 = state.gp0_e2;
+    target.ctx.gp0_e6 = state.gp0_e6;
+    target.ctx.drawingArea = state.drawingArea;
+}
+
+/**
+ * Exact reference of triangle coverage and interpolation, independent of triangle setup.
+ *
+ * Pixel is covered if it lies inside the triangle, pixels on an edge are covered only if the triangle
+ * continues to the right of them (or below, for horizontal edges) - top-left rule.
+ * Colors are barycentric interpolation rounded half up, kept as fraction num / den of value + 0.5.
+ */
+struct ReferenceTriangle {
+    ivec2 p[3];
+    int area;
+
+    explicit ReferenceTriangle(const primitive::Triangle& triangle) {
+        for (int i = 0; i < 3; i++) p[i] = triangle.v[i].pos;
+        area = (p[1].x - p[0].x) * (p[2].y - p[0].y) - (p[1].y - p[0].y) * (p[2].x - p[0].x);
+    }
+
+    // Edge function of edge opposite to vertex e, positive inside of counter clockwise triangle
+    int64_t edge(int e, int x, int y) const {
+        const ivec2& a = p[(e + 1) % 3];
+        const ivec2& b = p[(e + 2) % 3];
+        return int64_t(b.x - a.x) * (y - a.y) - int64_t(b.y - a.y) * (x - a.x);
+    }
+
+    bool drawable() const {
+        int w = std::max({p[0].x, p[1].x, p[2].x}) - std::min({p[0].x, p[1].x, p[2].x});
+        int h = std::max({p[0].y, p[1].y, p[2].y}) - std::min({p[0].y, p[1].y, p[2].y});
+        return area != 0 && w < 1024 && h < 512;
+    }
+
+    bool covers(int x, int y) const {
+        if (!drawable()) return false;
+        for (int e = 0; e < 3; e++) {
+            const ivec2& a = p[(e + 1) % 3];
+            const ivec2& b = p[(e + 2) % 3];
+            int64_t w = edge(e, x, y);
+            // Edge function at (x + eps, y + eps^2)
+            int dx = a.y - b.y;
+            int dy = b.x - a.x;
+            if (w < 0 || (w == 0 && (dx < 0 || (dx == 0 && dy <= 0)))) return false;
+        }
+        return true;
+    }
+
+    // Interpolated attribute + 0.5 = num / den
+    void value(const int a[3], int x, int y, int64_t& num, int64_t& den) const {
+        num = 2 * (edge(0, x, y) * a[0] + edge(1, x, y) * a[1] + edge(2, x, y) * a[2]) + area;
+        den = 2 * int64_t(area);
+    }
+};
+
+int64_t floorDiv(int64_t n, int64_t d) { return n >= 0 ? n / d : -((-n + d - 1) / d); }
+
+primitive::Triangle gouraudTriangle(ivec2 a, ivec2 b, ivec2 c, std::mt19937& random) {
+    primitive::Triangle triangle;
+    triangle.v[0].pos = a;
+    triangle.v[1].pos = b;
+    triangle.v[2].pos = c;
+    for (auto& v : triangle.v) v.color = RGB(random() & 0xff, random() & 0xff, random() & 0xff);
+    triangle.gouraudShading = true;
+    triangle.assureCcw();
+    return triangle;
+}
+
+/**
+ * Draws gouraud shaded triangle over VRAM filled with 0xffff and compares it with the reference.
+ * Drawn pixels have mask bit cleared. Pixels whose exact color is too close to rounding boundary
+ * for 20 bit fixed point to decide are only checked for coverage.
+ */
+void checkTriangle(void (*draw)(const gpu::RenderContext*, const primitive::Triangle&), const primitive::Triangle& triangle) {
+    Target target(std::vector<uint16_t>(gpu::VRAM_WIDTH * gpu::VRAM_HEIGHT, 0xffff));
+    target.ctx.drawingArea = {0, 0, gpu::VRAM_WIDTH - 1, gpu::VRAM_HEIGHT - 1};
+    draw(&target.ctx, triangle);
+
+    const ReferenceTriangle ref(triangle);
+    const int r[3] = {triangle.v[0].color.r, triangle.v[1].color.r, triangle.v[2].color.r};
+    const int g[3] = {triangle.v[0].color.g, triangle.v[1].color.g, triangle.v[2].color.g};
+    const int b[3] = {triangle.v[0].color.b, triangle.v[1].color.b, triangle.v[2].color.b};
+
+    int mismatches = 0;
+    ivec2 first(0, 0);
+    for (int y = 0; y < gpu::VRAM_HEIGHT; y++) {
+        for (int x = 0; x < gpu::VRAM_WIDTH; x++) {
+            const PSXColor c = target.vram[y * gpu::VRAM_WIDTH + x];
+            const bool covered = ref.covers(x, y);
+            bool match = (c.k == 0) == covered;
+
+            const int* attributes[3] = {r, g, b};
+            const int drawn[3] = {c.r, c.g, c.b};
+            for (int i = 0; covered && i < 3; i++) {
+                int64_t num, den;
+                ref.value(attributes[i], x, y, num, den);
+                int64_t fraction = num - floorDiv(num, den) * den;
+                if (fraction * 512 < den || (den - fraction) * 512 < den) continue;
+                int value = std::clamp<int64_t>(floorDiv(num, den), 0, 255);
+                match &= drawn[i] == value >> 3;
+            }
+
+            if (!match && mismatches++ == 0) first = ivec2(x, y);
+        }
+    }
+    INFO("first mismatch at " << first.x << "," << first.y);
+    REQUIRE(mismatches == 0);
+}
+
+/**
+ * Exact reference of line rasterization, every pixel is calculated on its own.
+ *
+ * Line steps one pixel along the major axis, minor coordinate is Bresenham's (error starts at 1 for x-major lines,
+ * so ties round the same way the rasterizer does). Gouraud color of pixel k of n is exact interpolation rounded half up,
+ * fixed point stepping may round the other way only within 1/64 of the rounding boundary.
+ */
+struct ReferenceLine {
+    struct Pixel {
+        ivec2 pos;
+        int candidates[3][2];  // Acceptable 8 bit values of r, g, b
+    };
+    std::vector<Pixel> pixels;  // From pos[0] to pos[1]
+
+    explicit ReferenceLine(const primitive::Line& line) {
+        ivec2 p0 = line.pos[0], p1 = line.pos[1];
+        const bool steep = std::abs(p0.x - p1.x) < std::abs(p0.y - p1.y);
+        if (steep) {
+            std::swap(p0.x, p0.y);
+            std::swap(p1.x, p1.y);
+        }
+        const bool reversed = p0.x > p1.x;
+        if (reversed) std::swap(p0, p1);
+
+        const int dx = p1.x - p0.x, dy = p1.y - p0.y;
+        const int steps = std::max(dx, 1);
+        for (int k = 0; k <= dx; k++) {
+            int n = dx == 0 ? 0 : std::max<int64_t>(0, -floorDiv(-(!steep + 2 * std::abs(dy) * k - dx), 2 * dx));
+            int minor = p0.y + (dy < 0 ? -n : n);
+
+            Pixel pixel;
+            pixel.pos = steep ? ivec2(minor, p0.x + k) : ivec2(p0.x + k, minor);
+
+            // Exact value + 0.5 = num / den, counted from pos[0]
+            const int i = reversed ? dx - k : k;
+            const int from[3] = {line.color[0].r, line.color[0].g, line.color[0].b};
+            const int to[3] = {line.color[1].r, line.color[1].g, line.color[1].b};
+            for (int c = 0; c < 3; c++) {
+                if (!line.gouraudShading) {
+                    // Flat line is drawn with color of its left (top for steep lines) end
+                    pixel.candidates[c][0] = pixel.candidates[c][1] = reversed ? to[c] : from[c];
+                    continue;
+                }
+                int64_t num = 2 * int64_t(steps) * from[c] + 2 * int64_t(to[c] - from[c]) * i + steps;
+                int64_t den = 2 * int64_t(steps);
+                int64_t value = floorDiv(num, den);
+                int64_t fraction = num - value * den;
+                pixel.candidates[c][0] = pixel.candidates[c][1] = (int)value;
+                if (fraction * 64 < den) pixel.candidates[c][1] = (int)value - 1;
+                if ((den - fraction) * 64 < den) pixel.candidates[c][1] = (int)value + 1;
+            }
+            pixels.push_back(pixel);
+        }
+        if (reversed) std::reverse(pixels.begin(), pixels.end());
+    }
+};
+
+// 5 bit channel of pixel drawn with 8 bit color over background channel, see GP0_E1 dither and semi-transparency modes
+int referenceChannel(int color, ivec2 pos, int bg, bool dithering, bool isSemiTransparent, gpu::SemiTransparency transparency) {
+    const int ditherOffset[4][4] = {{-4, +0, -3, +1}, {+2, -2, +3, -1}, {-3, +1, -4, +0}, {+3, -1, +2, -2}};
+    if (dithering) color = std::clamp(color + ditherOffset[pos.y & 3][pos.x & 3], 0, 255);
+    int f = color >> 3;
+    if (!isSemiTransparent) return f;
+
+    switch (transparency) {
+        case gpu::SemiTransparency::Bby2plusFby2: return (bg + f) >> 1;
+        case gpu::SemiTransparency::BplusF: return std::min(bg + f, 31);
+        case gpu::SemiTransparency::BminusF: return std::max(bg - f, 0);
+        case gpu::SemiTransparency::BplusFby4: return std::min(bg + (f >> 2), 31);
+    }
+    return f;
+}
+
+/**
+ * Draws line over random VRAM and checks every pixel against ReferenceLine,
+ * pixels which are not part of the line have to stay untouched.
+ */
+void checkLine(void (*draw)(const gpu::RenderContext*, const primitive::Line&), const primitive::Line& line,
+               const gpu::RenderContext& state, const std::vector<uint16_t>& initial) {
+    Target target(initial);
+    applyState(target, state);
+    draw(&target.ctx, line);
+
+    std::vector<bool> onLine(initial.size() + 1);
+    int mismatches = 0;
+    for (const auto& pixel : ReferenceLine(line).pixels) {
+        const int index = pixel.pos.y * gpu::VRAM_WIDTH + pixel.pos.x;
+        onLine[index] = true;
+
+        const PSXColor bg = initial[index], drawn = target.vram[index];
+        if (state.gp0_e6.checkMaskBeforeDraw && bg.k) {
+            mismatches += drawn.raw != bg.raw;
+            continue;
+        }
+
+        const int bgChannels[3] = {bg.r, bg.g, bg.b}, drawnChannels[3] = {drawn.r, drawn.g, drawn.b};
+        bool match = drawn.k == state.gp0_e6.setMaskWhileDrawing;
+        for (int c = 0; c < 3; c++) {
+            const auto channel = [&](int color) {
+                return referenceChannel(color, pixel.pos, bgChannels[c], state.gp0_e1.dither24to15, line.isSemiTransparent,
+                                        state.gp0_e1.semiTransparency);
+            };
+            match &= drawnChannels[c] == channel(pixel.candidates[c][0]) || drawnChannels[c] == channel(pixel.candidates[c][1]);
+        }
+        mismatches += !match;
+    }
+    for (size_t i = 0; i < initial.size(); i++) {
+        if (!onLine[i] && target.vram[i] != initial[i]) mismatches++;
+    }
+    REQUIRE(mismatches == 0);
+}
+}  // namespace
+
+TEST_CASE("Decoded texture pages match texels fetched from VRAM", "[gpu]") {
+    std::mt19937 random(2);
+    const auto rnd = [&](int min, int max) { return std::uniform_int_distribution<int>(min, max)(random); };
+
+    std::vector<uint16_t> initial(gpu::VRAM_WIDTH * gpu::VRAM_HEIGHT);
+    for (auto& pixel : initial) pixel = random();
+
+    Target direct(initial), cached(initial);
+    gpu::TextureCache textureCache;
+    cached.ctx.textureCache = &textureCache;
+
+    for (int i = 0; i < 2000; i++) {
+        // Few pages and palettes are reused often enough to get decoded, other triangles draw over them
+        auto triangle = randomTriangle(random);
+        triangle.texpage = ivec2(rnd(4, 5) * 64, 0);
+        triangle.clut = ivec2(0, rnd(500, 501));
+
+        const auto state = randomState(random);
+        for (auto target : {&direct, &cached}) {
+            applyState(*target, state);
+            Render::drawTriangle(&target->ctx, triangle);
+        }
+        REQUIRE(cached.vram == direct.vram);
+    }
+}
+
+#ifdef CPU_FEATURES_X64
+TEST_CASE("AVX2 triangle rasterizer matches scalar reference", "[gpu]") {
+    if (!cpu_features::hasAvx2()) return;
+
+    std::mt19937 random(1);
+
+    std::vector<uint16_t> initial(gpu::VRAM_WIDTH * gpu::VRAM_HEIGHT);
+    for (auto& pixel : initial) pixel = random();
+
+    Target reference(initial), avx2(initial);
+    for (int i = 0; i < 2000; i++) {
+        auto triangle = randomTriangle(random);
+
+        const auto state = randomState(random);
+        applyState(reference, state);
+        applyState(avx2, state);
+
+        Render::drawTriangleReference(&reference.ctx, triangle);
+        Render::drawTriangleAvx2(&avx2.ctx, triangle);
+        REQUIRE(avx2.vram == reference.vram);
+    }
+}
+
+TEST_CASE("AVX2 rectangle and line rasterizers match scalar reference", "[gpu]") {
+    if (!cpu_features::hasAvx2()) return;
+
+    std::mt19937 random(8);
+
+    std::vector<uint16_t> initial(gpu::VRAM_WIDTH * gpu::VRAM_HEIGHT);
+    for (auto& pixel : initial) pixel = random();
+
+    Target reference(initial), avx2(initial);
+    for (int i = 0; i < 4000; i++) {
+        const auto state = randomState(random);
+        applyState(reference, state);
+        applyState(avx2, state);
+
+        if (i % 2 == 0) {
+            const auto rect = randomRectangle(random);
+            Render::drawRectangleReference(&reference.ctx, rect);
+            Render::drawRectangleAvx2(&avx2.ctx, rect);
+        } else {
+            const auto line = randomLine(random);
+            Render::drawLineReference(&reference.ctx, line);
+            Render::drawLineAvx2(&avx2.ctx, line);
+        }
+        INFO((i % 2 == 0 ? "rectangle " : "line ") << i);
+        REQUIRE(avx2.vram == reference.vram);
+    }
+}
+#endif
+
+TEST_CASE("Fixed point triangle attributes stay within rounding error of exact values", "[gpu]") {
+    std::mt19937 random(3);
+    const auto rnd = [&](int min, int max) { return std::uniform_int_distribution<int>(min, max)(random); };
+
+    gpu::RenderContext ctx{};
+    ctx.drawingArea = {0, 0, gpu::VRAM_WIDTH - 1, gpu::VRAM_HEIGHT - 1};
+
+    for (int i = 0; i < 200; i++) {
+        const ivec2 corner(rnd(-1023, 1023 - 64), rnd(-511, 511 - 64));
+        const int size = rnd(0, 3) == 0 ? 1023 : 64;
+        const auto pos = [&]() { return corner + ivec2(rnd(0, size), rnd(0, size / 2)); };
+        auto triangle = gouraudTriangle(pos(), pos(), pos(), random);
+
+        const ReferenceTriangle ref(triangle);
+        TriangleSetup s;
+        if (!ref.drawable() || !setupTriangle<true, false>(&ctx, triangle, s)) continue;
+
+        const int r[3] = {triangle.v[0].color.r, triangle.v[1].color.r, triangle.v[2].color.r};
+        for (int y = s.min.y; y <= s.max.y; y += 3) {
+            for (int x = s.min.x; x <= s.max.x; x += 5) {
+                if (!ref.covers(x, y)) continue;
+
+                Attributes attrib = s.attributes;
+                addXDeltas<true, false>(attrib, s.deltas, x - s.min.x);
+                addYDeltas<true, false>(attrib, s.deltas, y - s.min.y);
+
+                // Start value and every step are rounded by at most half of the last bit
+                int64_t num, den;
+                ref.value(r, x, y, num, den);
+                int64_t error = int64_t(static_cast<int32_t>(attrib.r)) * den - num * ATTRIBUTE_ONE;
+                int64_t steps = (x - s.min.x) + (y - s.min.y) + 1;
+                if (std::abs(error) > steps * den / 2 + den) {
+                    FAIL("attribute at " << x << "," << y << " off by " << error / double(den) / ATTRIBUTE_ONE);
+                }
+            }
+        }
+    }
+}
+
+TEST_CASE("Triangle rasterizers match exact coverage and colors", "[gpu]") {
+    std::mt19937 random(4);
+    const auto rnd = [&](int min, int max) { return std::uniform_int_distribution<int>(min, max)(random); };
+
+    std::vector<primitive::Triangle> triangles = {
+        // Quad split along diagonal, top-left rule draws each pixel of 16x16 square once
+        gouraudTriangle({16, 16}, {32, 16}, {16, 32}, random),
+        gouraudTriangle({32, 16}, {32, 32}, {16, 32}, random),
+        // Horizontal and vertical edges through pixel centers
+        gouraudTriangle({100, 100}, {140, 100}, {120, 60}, random),
+        gouraudTriangle({100, 100}, {100, 140}, {60, 120}, random),
+        // Largest drawable size, vertices at coordinate limits
+        gouraudTriangle({0, 0}, {1023, 0}, {0, 511}, random),
+        gouraudTriangle({1023, 511}, {0, 511}, {1023, 0}, random),
+        gouraudTriangle({-1023, -511}, {0, 0}, {-1023, 0}, random),
+        gouraudTriangle({-512, 0}, {511, 100}, {0, 511}, random),
+        // Too big, not drawn
+        gouraudTriangle({-1, 0}, {1023, 0}, {0, 511}, random),
+        gouraudTriangle({0, -1}, {1023, 0}, {0, 511}, random),
+        gouraudTriangle({-1023, -511}, {1023, 511}, {0, 511}, random),
+        // Zero area
+        gouraudTriangle({10, 10}, {20, 20}, {30, 30}, random),
+        gouraudTriangle({10, 10}, {10, 10}, {10, 10}, random),
+        gouraudTriangle({10, 10}, {300, 10}, {20, 10}, random),
+        // One pixel thin
+        gouraudTriangle({200, 200}, {600, 201}, {200, 201}, random),
+        gouraudTriangle({200, 200}, {201, 450}, {201, 200}, random),
+    };
+    for (int i = 0; i < 40; i++) {
+        const ivec2 corner(rnd(-64, 1023), rnd(-64, 511));
+        const int size = rnd(0, 3) == 0 ? 400 : 24;
+        const auto pos = [&]() { return corner + ivec2(rnd(-size, size), rnd(-size, size)); };
+        triangles.push_back(gouraudTriangle(pos(), pos(), pos(), random));
+    }
+
+    for (const auto& triangle : triangles) {
+        INFO("triangle " << triangle.v[0].pos.x << "," << triangle.v[0].pos.y << " " << triangle.v[1].pos.x << "," << triangle.v[1].pos.y
+                         << " " << triangle.v[2].pos.x << "," << triangle.v[2].pos.y);
+        checkTriangle(Render::drawTriangleReference, triangle);
+        checkTriangle(Render::drawTriangle, triangle);
+    }
+
+    // Both halves of the quad together
+    Target quad(std::vector<uint16_t>(gpu::VRAM_WIDTH * gpu::VRAM_HEIGHT, 0xffff));
+    quad.ctx.drawingArea = {0, 0, gpu::VRAM_WIDTH - 1, gpu::VRAM_HEIGHT - 1};
+    Render::drawTriangle(&quad.ctx, triangles[0]);
+    Render::drawTriangle(&quad.ctx, triangles[1]);
+    int mismatches = 0;
+    for (int y = 0; y < gpu::VRAM_HEIGHT; y++) {
+        for (int x = 0; x < gpu::VRAM_WIDTH; x++) {
+            bool inside = x >= 16 && x < 32 && y >= 16 && y < 32;
+            bool isDrawn = (quad.vram[y * gpu::VRAM_WIDTH + x] & 0x8000) == 0;
+            mismatches += isDrawn != inside;
+        }
+    }
+    REQUIRE(mismatches == 0);
+}
+
+TEST_CASE("Line rasterizer variants match per pixel reference", "[gpu]") {
+    std::mt19937 random(9);
+    const auto rnd = [&](int min, int max) { return std::uniform_int_distribution<int>(min, max)(random); };
+
+    std::vector<uint16_t> initial(gpu::VRAM_WIDTH * gpu::VRAM_HEIGHT);
+    for (auto& pixel : initial) pixel = random();
+
+    // Every entry of the dispatch table
+    for (int variant = 0; variant < 16; variant++) {
+        for (int i = 0; i < 30; i++) {
+            primitive::Line line;
+            const ivec2 start(rnd(0, gpu::VRAM_WIDTH - 1), rnd(0, gpu::VRAM_HEIGHT - 1));
+            const int size = rnd(0, 1) ? 8 : 600;
+            for (int p = 0; p < 2; p++) {
+                line.pos[p] = p == 0 ? start : start + ivec2(rnd(-size, size), rnd(-size, size));
+                line.pos[p] = ivec2(std::clamp(line.pos[p].x, 0, gpu::VRAM_WIDTH - 1), std::clamp(line.pos[p].y, 0, gpu::VRAM_HEIGHT - 1));
+                line.color[p] = RGB(rnd(0, 255), rnd(0, 255), rnd(0, 255));
+            }
+            line.isSemiTransparent = variant & 1;
+            line.gouraudShading = variant & 2;
+
+            gpu::RenderContext state{};
+            state.gp0_e1.semiTransparency = static_cast<gpu::SemiTransparency>(rnd(0, 3));
+            state.gp0_e1.dither24to15 = (variant & 8) != 0;
+            state.gp0_e6.checkMaskBeforeDraw = (variant & 4) != 0;
+            state.gp0_e6.setMaskWhileDrawing = rnd(0, 1);
+            state.drawingArea = {0, 0, gpu::VRAM_WIDTH, gpu::VRAM_HEIGHT};
+
+            INFO("variant " << variant << ", line " << line.pos[0].x << "," << line.pos[0].y << " " << line.pos[1].x << ","
+                            << line.pos[1].y);
+            checkLine(Render::drawLineReference, line, state, initial);
+#ifdef CPU_FEATURES_X64
+            if (cpu_features::hasAvx2()) checkLine(Render::drawLineAvx2, line, state, initial);
+#endif
+        }
+    }
+}
+
+TEST_CASE("Gouraud lines reach both endpoint colors and change monotonically", "[gpu]") {
+    std::mt19937 random(10);
+    const auto rnd = [&](int min, int max) { return std::uniform_int_distribution<int>(min, max)(random); };
+    // Just above and just below 5 bit steps, so being off by one in either direction is visible
+    const auto channel = [&]() { return rnd(0, 31) * 8 + (rnd(0, 1) ? 7 : 0); };
+
+    for (int i = 0; i < 500; i++) {
+        primitive::Line line;
+        const ivec2 start(rnd(0, gpu::VRAM_WIDTH - 1), rnd(0, gpu::VRAM_HEIGHT - 1));
+        const int size = rnd(0, 3) == 0 ? 1023 : 40;
+        for (int p = 0; p < 2; p++) {
+            line.pos[p] = p == 0 ? start : start + ivec2(rnd(-size, size), rnd(-size, size));
+            line.pos[p] = ivec2(std::clamp(line.pos[p].x, 0, gpu::VRAM_WIDTH - 1), std::clamp(line.pos[p].y, 0, gpu::VRAM_HEIGHT - 1));
+            line.color[p] = RGB(channel(), channel(), channel());
+        }
+        line.isSemiTransparent = false;
+        line.gouraudShading = true;
+
+        for (auto draw : {Render::drawLineReference, Render::drawLine}) {
+            Target target(std::vector<uint16_t>(gpu::VRAM_WIDTH * gpu::VRAM_HEIGHT, 0));
+            target.ctx.drawingArea = {0, 0, gpu::VRAM_WIDTH, gpu::VRAM_HEIGHT};
+            draw(&target.ctx, line);
+
+            const auto pixels = ReferenceLine(line).pixels;
+            const auto at = [&](ivec2 pos) { return PSXColor(target.vram[pos.y * gpu::VRAM_WIDTH + pos.x]); };
+            const PSXColor first = at(line.pos[0]), last = at(line.pos[1]);
+
+            INFO("line " << line.pos[0].x << "," << line.pos[0].y << " " << line.pos[1].x << "," << line.pos[1].y);
+            REQUIRE(pixels.front().pos == line.pos[0]);
+            REQUIRE(pixels.back().pos == line.pos[1]);
+            REQUIRE(first.r == line.color[0].r >> 3);
+            REQUIRE(first.g == line.color[0].g >> 3);
+            REQUIRE(first.b == line.color[0].b >> 3);
+            // Single pixel line has color of its first vertex
+            if (line.pos[0] != line.pos[1]) {
+                REQUIRE(last.r == line.color[1].r >> 3);
+                REQUIRE(last.g == line.color[1].g >> 3);
+                REQUIRE(last.b == line.color[1].b >> 3);
+            }
+
+            int reversals = 0;
+            for (size_t p = 1; p < pixels.size(); p++) {
+                const PSXColor a = at(pixels[p - 1].pos), b = at(pixels[p].pos);
+                const auto sign = [](int v) { return (v > 0) - (v < 0); };
+                reversals += sign(b.r - a.r) * sign(line.color[1].r - line.color[0].r) < 0;
+                reversals += sign(b.g - a.g) * sign(line.color[1].g - line.color[0].g) < 0;
+                reversals += sign(b.b - a.b) * sign(line.color[1].b - line.color[0].b) < 0;
+            }
+            REQUIRE(reversals == 0);
+        }
+    }
+}
@@ -0,0 +1,143 @@
+#include "system.h"
+#include <catch2/catch.hpp>
+#include <thread>
+#include <vector>
+#include "cpu/recompiler/recompiler.h"
+
+namespace {
+uint32_t I(int op, int rs, int rt, uint16_t imm) { return (op << 26) | (rs << 21) | (rt << 16) | imm; }
+uint32_t R(int rs, int rt, int rd, int shamt, int fun) { return (rs << 21) | (rt << 16) | (rd << 11) | (shamt << 6) | fun; }
+
+enum Reg { r0 = 0, t0 = 8, t1, t2, t3, t4, t5, t6, s0 = 16, s1, s2, t9 = 25 };
+
+// Endless loop touching CPU, GTE, GPU, timers and RAM, everything it computes depends on the previous iteration
+std::vector<uint32_t> program(uint32_t loop) {
+    return {
+        I(15, 0, t0, 0x4000),                     // lui t0, 0x4000
+        0x40800000 | (t0 << 16) | (12 << 11),     // mtc0 t0, SR - enable GTE
+        I(15, 0, s0, 0x1234),                     // lui s0, 0x1234
+        I(13, s0, s0, 0x5678),                    // ori s0, s0, 0x5678
+        I(15, 0, t9, 0x1f80),                     // lui t9, 0x1f80
+        I(9, 0, t1, 0x0200),                      // addiu t1, r0, 0x200
+        I(41, t9, t1, 0x1124),                    // sh t1, 0x1124(t9) - timer2 sysclk/8
+        I(15, 0, s2, 0x8002),                     // lui s2, 0x8002
+        I(15, 0, t2, 0x41c6),                     // loop: lui t2, 0x41c6
+        I(13, t2, t2, 0x4e6d),                    // ori t2, t2, 0x4e6d
+        R(s0, t2, 0, 0, 0x19),                    // multu s0, t2
+        R(0, 0, s0, 0, 0x12),                     // mflo s0
+        I(9, s0, s0, 0x3039),                     // addiu s0, s0, 12345
+        I(12, s0, t3, 0xfffc),                    // andi t3, s0, 0xfffc
+        R(t3, s2, t3, 0, 0x21),                   // addu t3, t3, s2
+        I(43, t3, s0, 0),                         // sw s0, 0(t3)
+        I(15, 0, t6, 0x00ff),                     // lui t6, 0x00ff
+        I(13, t6, t6, 0xffff),                    // ori t6, t6, 0xffff
+        R(s0, t6, t4, 0, 0x24),                   // and t4, s0, t6
+        I(15, 0, t5, 0x0200),                     // lui t5, 0x0200
+        R(t4, t5, t4, 0, 0x25),                   // or t4, t4, t5
+        I(43, t9, t4, 0x1810),                    // sw t4, GP0 - fill rectangle
+        I(12, s0, t4, 0x01f0),                    // andi t4, s0, 0x1f0
+        R(0, s0, t6, 16, 0x02),                   // srl t6, s0, 16
+        I(12, t6, t6, 0x00ff),                    // andi t6, t6, 0xff
+        R(0, t6, t6, 16, 0x00),                   // sll t6, t6, 16
+        R(t4, t6, t4, 0, 0x25),                   // or t4, t4, t6
+        I(43, t9, t4, 0x1810),                    // sw t4, GP0 - position
+        I(15, 0, t4, 0x0010),                     // lui t4, 0x10
+        I(13, t4, t4, 0x0010),                    // ori t4, t4, 0x10
+        I(43, t9, t4, 0x1810),                    // sw t4, GP0 - 16x16
+        0x48800000 | (s0 << 16) | (0 << 11),      // mtc2 s0, VXY0
+        I(12, s0, t4, 0x0fff),                    // andi t4, s0, 0xfff
+        0x48800000 | (t4 << 16) | (1 << 11),      // mtc2 t4, VZ0
+        0,                                        // nop
+        0x4a180001,                               // rtps
+        0x48000000 | (t4 << 16) | (14 << 11),     // mfc2 t4, SXY2
+        0,                                        // nop
+        R(s1, t4, s1, 0, 0x26),                   // xor s1, s1, t4
+        I(37, t9, t4, 0x1120),                    // lhu t4, 0x1120(t9) - timer2 value
+        0,                                        // nop
+        R(s1, t4, s1, 0, 0x21),                   // addu s1, s1, t4
+        (2u << 26) | ((loop & 0x0fffffff) >> 2),  // j loop
+        0,                                        // nop
+    };
+}
+
+struct Result {
+    std::vector<uint8_t> ram;
+    std::vector<uint16_t> vram;
+    std::vector<uint32_t> reg;  // GPRs, hi, lo, PC, pending load (register and value)
+    uint64_t cycles;
+
+    bool operator==(const Result& r) const { return ram == r.ram && vram == r.vram && reg == r.reg && cycles == r.cycles; }
+};
+
+// Every instance gets its own config and event bus, nothing is shared between threads
+Result run(CpuCore core, bool fastmem = false) {
+    avocado_config_t config;
+    config.options.system.cpuCore = core;
+    config.options.system.fastmem = fastmem;
+    Dexode::EventBus bus;
+
+    auto sys = std::make_unique<System>(config, bus);
+    const uint32_t base = 0x80010000;
+    auto code = program(base + 8 * 4);
+    for (size_t i = 0; i < code.size(); i++) {
+        sys->writeMemory32(base + i * 4, code[i]);
+    }
+    sys->cpu->setPC(base);
+    sys->state = System::State::run;
+
+    for (int frame = 0; frame < 10; frame++) {
+        sys->emulateFrame();
+    }
+
+    Result result;
+    result.ram.assign(sys->ram.begin(), sys->ram.end());
+    result.vram.assign(sys->gpu->vram.begin(), sys->gpu->vram.end());
+    result.reg.assign(std::begin(sys->cpu->reg), std::end(sys->cpu->reg));
+    result.reg.insert(result.reg.end(), {sys->cpu->hi, sys->cpu->lo, sys->cpu->PC, sys->cpu->slots[0].reg, sys->cpu->slots[0].data});
+    result.cycles = sys->cycles;
+    return result;
+}
+
+void runParallel(CpuCore core) {
+    const int THREADS = 4;
+    Result reference = run(core);
+
+    std::vector<Result> results(THREADS);
+    std::vector<std::thread> threads;
+    for (int i = 0; i < THREADS; i++) {
+        threads.emplace_back([&results, i, core]() { results[i] = run(core); });
+    }
+    for (auto& t : threads) t.join();
+
+    REQUIRE(reference.cycles > 0);
+    for (const auto& result : results) {
+        REQUIRE(result == reference);
+    }
+}
+}  // namespace
+
+TEST_CASE("Systems running on separate threads are bit-identical - interpreter", "[system]") { runParallel(CpuCore::interpreter); }
+
+TEST_CASE("Systems running on separate threads are bit-identical - cached interpreter", "[system]") {
+    runParallel(CpuCore::cachedInterpreter);
+}
+
+TEST_CASE("Systems running on separate threads are bit-identical - recompiler", "[system]") {
+    if (!mips::Recompiler::isSupported()) return;
+    runParallel(CpuCore::recompiler);
+}
+
+TEST_CASE("Cached interpreter and recompiler give the same result as the interpreter", "[system]") {
+    Result reference = run(CpuCore::interpreter);
+
+    SECTION("cached interpreter") { REQUIRE(run(CpuCore::cachedInterpreter) == reference); }
+    for (bool fastmem : {false, true}) {
+        DYNAMIC_SECTION("recompiler, fastmem " << fastmem) {
+            if (!mips::Recompiler::isSupported()) return;
+            Result result = run(CpuCore::recompiler, fastmem);
+            CHECK(result.cycles == reference.cycles);
+            CHECK(result.reg == reference.reg);
+            REQUIRE(result == reference);
+        }
+    }
+}